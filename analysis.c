@@ -0,0 +1,466 @@
+// analysis.c -- Análise de efeitos (pureza) das funções da AST
+
+#include "compiler.h"
+
+// --- Utilidades de Escopo ---
+
+static int is_param(Node *fn_def, const char *name) {
+    Node *param_wrapper = fn_def->left;
+    while (param_wrapper) {
+        if (strcmp(param_wrapper->left->name, name) == 0) return 1;
+        param_wrapper = param_wrapper->right;
+    }
+    return 0;
+}
+
+// Procura um N_VAR_DECL local com o nome dado (inclui blocos de if/else)
+static int declares_local(Node *n, const char *name) {
+    if (!n) return 0;
+    if (n->kind == N_VAR_DECL && strcmp(n->name, name) == 0) return 1;
+    if (n->kind == N_STMT_LIST || n->kind == N_IF) {
+        return declares_local(n->left, name) || declares_local(n->mid, name) || declares_local(n->right, name);
+    }
+    return 0;
+}
+
+static int is_local(Node *fn_def, const char *name) {
+    return is_param(fn_def, name) || declares_local(fn_def->mid, name);
+}
+
+static int is_scalar_type(const char *sauce_type) {
+    return strcmp(sauce_type, "int") == 0 || strcmp(sauce_type, "float") == 0 ||
+           strcmp(sauce_type, "boolean") == 0 || strcmp(sauce_type, "bool") == 0;
+}
+
+static Node *find_fn(const char *name) {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (strcmp(fn_defs[i]->name, name) == 0) return fn_defs[i];
+    }
+    return NULL;
+}
+
+// --- Coleta de Efeitos Locais ---
+
+// Percorre o corpo e acumula os efeitos diretos. Chamadas a outras funções
+// contam como impuras se a função chamada já estiver marcada como impura.
+static int collect_effects(Node *n, Node *fn_def, int is_tail) {
+    if (!n) return 0;
+    int fx = 0;
+
+    switch (n->kind) {
+        case N_SAY:
+        case N_HEAR:
+            fx |= FX_IO;
+            break;
+
+        case N_VAR:
+            if (!is_local(fn_def, n->name)) fx |= FX_READS_GLOBAL;
+            break;
+
+        case N_VAR_ASSIGN:
+            if (!is_local(fn_def, n->name)) fx |= FX_WRITES_GLOBAL;
+            break;
+
+        case N_SPAWN:
+        case N_STAGE:
+            fx |= FX_SPAWNS;
+            break;
+
+        case N_SEND:
+        case N_CLOSE:
+            fx |= FX_IO; // Comunicação com outras threads: nunca avaliada em compilação
+            break;
+
+        case N_RECV:
+        case N_NEXT: // next avança o estado do gerador: também nunca avaliado em compilação
+            fx |= FX_IO;
+            if (!is_local(fn_def, n->right->name)) fx |= FX_WRITES_GLOBAL;
+            break;
+
+        case N_YIELD:
+            fx |= FX_YIELDS;
+            break;
+
+        case N_JOIN:
+            // join consome a task (a variável volta a ser vazia)
+            if (!is_local(fn_def, n->left->name)) fx |= FX_WRITES_GLOBAL;
+            break;
+
+        case N_FN_CALL: {
+            Node *callee = find_fn(n->name);
+            if (!callee) {
+                fx |= FX_CALLS_IMPURE;
+            } else if (callee == fn_def) {
+                if (!is_tail) fx |= FX_SELF_RECURSIVE;
+            } else {
+                if (!fn_is_pure(callee)) fx |= FX_CALLS_IMPURE;
+                if (callee->effects & FX_READS_GLOBAL) fx |= FX_READS_GLOBAL;
+                if (callee->effects & FX_WRITES_GLOBAL) fx |= FX_WRITES_GLOBAL;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    fx |= collect_effects(n->left, fn_def, n->kind == N_RETURN);
+    fx |= collect_effects(n->mid, fn_def, 0);
+    fx |= collect_effects(n->right, fn_def, 0);
+    return fx;
+}
+
+// ------------------------------------------
+// --- API Pública ---
+// ------------------------------------------
+
+int fn_is_pure(Node *fn_def) {
+    return !(fn_def->effects & (FX_IO | FX_WRITES_GLOBAL | FX_CALLS_IMPURE | FX_SPAWNS | FX_YIELDS));
+}
+
+int fn_is_const(Node *fn_def) {
+    return fn_is_pure(fn_def) && !(fn_def->effects & FX_READS_GLOBAL);
+}
+
+// Memoização exige função 'const' com parâmetros e retorno escalares (chave e valor
+// cabem na tabela). É automática para recursão em árvore e opcional via 'memo fn'.
+int fn_should_memoize(Node *fn_def) {
+    if (!fn_is_const(fn_def) || !fn_def->left || !is_scalar_type(fn_def->typeName)) return 0;
+
+    Node *param_wrapper = fn_def->left;
+    while (param_wrapper) {
+        if (!is_scalar_type(param_wrapper->left->typeName)) return 0;
+        param_wrapper = param_wrapper->right;
+    }
+
+    return (fn_def->flags & NODE_FLAG_MEMO) || (fn_def->effects & FX_SELF_RECURSIVE);
+}
+
+// Número de nós de uma subárvore (usado como medida de tamanho para inlining)
+int ast_size(Node *n) {
+    if (!n) return 0;
+    return 1 + ast_size(n->left) + ast_size(n->mid) + ast_size(n->right);
+}
+
+int uses_tasks(Node *n) {
+    if (!n) return 0;
+    if (n->kind == N_SPAWN || n->kind == N_JOIN) return 1;
+    return uses_tasks(n->left) || uses_tasks(n->mid) || uses_tasks(n->right);
+}
+
+int program_uses_tasks() {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (uses_tasks(fn_defs[i]->mid)) return 1;
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (uses_tasks(global_stmts[i])) return 1;
+    }
+    return 0;
+}
+
+static int is_chan_type(const char *sauce_type) {
+    return strncmp(sauce_type, "chan<", 5) == 0;
+}
+
+int uses_channels(Node *n) {
+    if (!n) return 0;
+    if (n->kind == N_SEND || n->kind == N_RECV || n->kind == N_CLOSE || n->kind == N_STAGE) return 1;
+    if (n->kind == N_VAR_DECL && is_chan_type(n->typeName)) return 1;
+    return uses_channels(n->left) || uses_channels(n->mid) || uses_channels(n->right);
+}
+
+int program_uses_channels() {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (uses_channels(fn_defs[i]->left) || uses_channels(fn_defs[i]->mid)) return 1;
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (uses_channels(global_stmts[i])) return 1;
+    }
+    return 0;
+}
+
+static int is_gen_type(const char *sauce_type) {
+    return strncmp(sauce_type, "gen<", 4) == 0;
+}
+
+int uses_generators(Node *n) {
+    if (!n) return 0;
+    if (n->kind == N_YIELD || n->kind == N_NEXT) return 1;
+    if (n->kind == N_VAR_DECL && is_gen_type(n->typeName)) return 1;
+    return uses_generators(n->left) || uses_generators(n->mid) || uses_generators(n->right);
+}
+
+int program_uses_generators() {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (uses_generators(fn_defs[i]->left) || uses_generators(fn_defs[i]->mid)) return 1;
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (uses_generators(global_stmts[i])) return 1;
+    }
+    return 0;
+}
+
+// Globais reatribuídas depois da própria declaração (atribuição, hear, recv, next, join),
+// indexadas pelo comando global que as declara
+static char global_written[MAX_FN_DEFS];
+
+static int global_decl_index(const char *name) {
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (global_stmts[i]->kind == N_VAR_DECL && strcmp(global_stmts[i]->name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// 'fn_def' NULL: comandos globais (ali toda variável atribuída é global)
+static void mark_global_writes(Node *n, Node *fn_def) {
+    if (!n) return;
+    const char *target = NULL;
+    if (n->kind == N_VAR_ASSIGN) target = n->name;
+    else if (n->kind == N_HEAR || n->kind == N_JOIN) target = n->left->name;
+    else if (n->kind == N_RECV || n->kind == N_NEXT) target = n->right->name;
+    if (target && !(fn_def && is_local(fn_def, target))) {
+        int g = global_decl_index(target);
+        if (g >= 0) global_written[g] = 1;
+    }
+    mark_global_writes(n->left, fn_def);
+    mark_global_writes(n->mid, fn_def);
+    mark_global_writes(n->right, fn_def);
+}
+
+// Primeira global reatribuível lida por 'n' (no corpo de 'fn_def'), seguindo as chamadas
+static const char *shared_global_read(Node *n, Node *fn_def, char *visited) {
+    if (!n) return NULL;
+    if (n->kind == N_VAR && !is_local(fn_def, n->name)) {
+        int g = global_decl_index(n->name);
+        if (g >= 0 && global_written[g]) return n->name;
+    }
+    if (n->kind == N_FN_CALL) {
+        for (int i = 0; i < fnDefCount; i++) {
+            if (fn_defs[i] != fn_def && strcmp(fn_defs[i]->name, n->name) == 0 && !visited[i]) {
+                visited[i] = 1;
+                const char *name = shared_global_read(fn_defs[i]->mid, fn_defs[i], visited);
+                if (name) return name;
+            }
+        }
+    }
+    const char *name = shared_global_read(n->left, fn_def, visited);
+    if (!name) name = shared_global_read(n->mid, fn_def, visited);
+    if (!name) name = shared_global_read(n->right, fn_def, visited);
+    return name;
+}
+
+// Uma tarefa (ou estágio) roda em paralelo com quem a criou: não pode escrever em globais
+// nem ler globais reatribuídas em algum ponto (a reatribuição de text libera o valor antigo),
+// nem diretamente nem por funções que chama (globais fixas e say/hear são permitidos)
+static void check_spawns(Node *n) {
+    if (!n) return;
+    if (n->kind == N_SPAWN || n->kind == N_STAGE) {
+        const char *what = n->kind == N_SPAWN ? "spawn" : "stage";
+        Node *callee = find_fn(n->left->name);
+        if (!callee) {
+            fprintf(stderr, "Erro Semântico: '%s %s': função não definida.\n", what, n->left->name);
+            exit(1);
+        }
+        if (callee->effects & FX_WRITES_GLOBAL) {
+            fprintf(stderr, "Erro Semântico: '%s %s' (%d:%d): a função escreve em variáveis globais e não pode rodar em outra thread.\n",
+                    what, callee->name, n->line, n->col);
+            exit(1);
+        }
+        if (callee->effects & FX_READS_GLOBAL) {
+            char *visited = calloc(fnDefCount + 1, 1);
+            const char *global = shared_global_read(callee->mid, callee, visited);
+            free(visited);
+            if (global) {
+                fprintf(stderr, "Erro Semântico: '%s %s' (%d:%d): a função lê a global '%s', que é reatribuída, e não pode rodar em outra thread.\n",
+                        what, callee->name, n->line, n->col, global);
+                exit(1);
+            }
+        }
+    }
+    check_spawns(n->left);
+    check_spawns(n->mid);
+    check_spawns(n->right);
+}
+
+// ------------------------------------------
+// --- Canais: SPSC ou MPMC ---
+// ------------------------------------------
+
+// O anel SPSC dispensa CAS, mas só vale com no máximo uma thread enviando e uma
+// recebendo. Como Sauce não tem laços nem atribuição de canais, cada spawn/stage
+// no escopo que declara o canal roda uma vez por execução desse escopo: basta
+// somar os papéis de cada thread. Parâmetros guardam o papel que a função exerce
+// (NODE_FLAG_CHAN_*); qualquer dúvida vira ESCAPE e o canal fica MPMC.
+#define CHAN_ROLES (NODE_FLAG_CHAN_SEND | NODE_FLAG_CHAN_RECV | NODE_FLAG_CHAN_ESCAPE)
+
+static int param_roles(const char *fn_name, int index) {
+    Node *fn = find_fn(fn_name);
+    if (!fn) return NODE_FLAG_CHAN_ESCAPE;
+    Node *p = fn->left;
+    for (int i = 0; p && i < index; i++) p = p->right;
+    return p ? (p->left->flags & CHAN_ROLES) : NODE_FLAG_CHAN_ESCAPE;
+}
+
+typedef struct {
+    int senders, receivers; // Threads criadas no escopo que enviam / recebem
+    int escape;
+} ChanThreads;
+
+// Papéis de 'name' na thread que executa 'n'. Com 'threads', spawn/stage que recebem
+// o canal contam como novas threads; sem (resumo de parâmetro), o canal escapa.
+static int chan_roles(Node *n, const char *name, ChanThreads *threads, int in_bench) {
+    if (!n) return 0;
+    int roles = 0;
+
+    switch (n->kind) {
+        case N_SEND:
+            if (strcmp(n->left->name, name) == 0) roles |= NODE_FLAG_CHAN_SEND;
+            break;
+        case N_RECV:
+            if (strcmp(n->left->name, name) == 0) roles |= NODE_FLAG_CHAN_RECV;
+            break;
+        case N_BENCH:
+            in_bench = 1; // Corpo repetido: threads criadas aqui não são contáveis
+            break;
+        case N_FN_CALL:
+        case N_SPAWN:
+        case N_STAGE: {
+            Node *call = n->kind == N_FN_CALL ? n : n->left;
+            int index = 0;
+            for (Node *a = call->left; a; a = a->right, index++) {
+                if (a->left->kind != N_VAR || strcmp(a->left->name, name) != 0) {
+                    roles |= chan_roles(a->left, name, threads, in_bench);
+                    continue;
+                }
+                int r = param_roles(call->name, index);
+                if (n->kind == N_FN_CALL) {
+                    roles |= r;
+                } else if (!threads || in_bench || (r & NODE_FLAG_CHAN_ESCAPE)) {
+                    roles |= NODE_FLAG_CHAN_ESCAPE;
+                } else {
+                    if (r & NODE_FLAG_CHAN_SEND) threads->senders++;
+                    if (r & NODE_FLAG_CHAN_RECV) threads->receivers++;
+                }
+            }
+            return roles;
+        }
+        default:
+            break;
+    }
+
+    roles |= chan_roles(n->left, name, threads, in_bench);
+    roles |= chan_roles(n->mid, name, threads, in_bench);
+    roles |= chan_roles(n->right, name, threads, in_bench);
+    return roles;
+}
+
+static int references_var(Node *n, const char *name) {
+    if (!n) return 0;
+    if (n->kind == N_VAR && strcmp(n->name, name) == 0) return 1;
+    return references_var(n->left, name) || references_var(n->mid, name) || references_var(n->right, name);
+}
+
+static void mark_spsc(Node *decl, Node **scope, int count, int is_global) {
+    ChanThreads threads = {0, 0, 0};
+    int roles = 0;
+    for (int i = 0; i < count; i++) {
+        roles |= chan_roles(scope[i], decl->name, &threads, 0);
+    }
+    // Canal global citado dentro de funções: pode ser usado de qualquer thread
+    for (int i = 0; is_global && i < fnDefCount; i++) {
+        if (!is_local(fn_defs[i], decl->name) && references_var(fn_defs[i]->mid, decl->name)) {
+            roles |= NODE_FLAG_CHAN_ESCAPE;
+        }
+    }
+
+    int senders = threads.senders + ((roles & NODE_FLAG_CHAN_SEND) ? 1 : 0);
+    int receivers = threads.receivers + ((roles & NODE_FLAG_CHAN_RECV) ? 1 : 0);
+    decl->flags &= ~NODE_FLAG_SPSC;
+    if (!(roles & NODE_FLAG_CHAN_ESCAPE) && senders <= 1 && receivers <= 1) {
+        decl->flags |= NODE_FLAG_SPSC;
+    }
+}
+
+static void mark_local_channels(Node *n, Node *fn) {
+    if (!n) return;
+    if (n->kind == N_VAR_DECL && is_chan_type(n->typeName)) {
+        mark_spsc(n, &fn->mid, 1, 0);
+    }
+    mark_local_channels(n->left, fn);
+    mark_local_channels(n->mid, fn);
+    mark_local_channels(n->right, fn);
+}
+
+void analyze_channels() {
+    // 1. Resumos dos parâmetros canal (ponto fixo: os papéis só crescem)
+    for (int i = 0; i < fnDefCount; i++) {
+        for (Node *p = fn_defs[i]->left; p; p = p->right) p->left->flags &= ~CHAN_ROLES;
+    }
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < fnDefCount; i++) {
+            for (Node *p = fn_defs[i]->left; p; p = p->right) {
+                Node *param = p->left;
+                if (!is_chan_type(param->typeName)) continue;
+                int roles = param->flags & CHAN_ROLES;
+                roles |= chan_roles(fn_defs[i]->mid, param->name, NULL, 0);
+                if (roles != (param->flags & CHAN_ROLES)) {
+                    param->flags |= roles;
+                    changed = 1;
+                }
+            }
+        }
+    }
+
+    // 2. Declarações: locais (escopo = corpo da função) e globais (escopo = comandos globais)
+    for (int i = 0; i < fnDefCount; i++) {
+        mark_local_channels(fn_defs[i]->mid, fn_defs[i]);
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (global_stmts[i]->kind == N_VAR_DECL && is_chan_type(global_stmts[i]->typeName)) {
+            mark_spsc(global_stmts[i], global_stmts, globalStmtCount, 1);
+        }
+    }
+}
+
+// Ponto fixo: começa assumindo tudo puro e propaga impureza pelo grafo de chamadas.
+// Deve rodar depois da inferência de tipo de retorno.
+void analyze_effects() {
+    for (int i = 0; i < fnDefCount; i++) {
+        fn_defs[i]->effects = 0;
+    }
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < fnDefCount; i++) {
+            Node *fn = fn_defs[i];
+            int fx = fn->effects | collect_effects(fn->mid, fn, 0);
+            if (fx != fn->effects) {
+                fn->effects = fx;
+                changed = 1;
+            }
+        }
+    }
+
+    memset(global_written, 0, sizeof global_written);
+    for (int i = 0; i < fnDefCount; i++) {
+        mark_global_writes(fn_defs[i]->mid, fn_defs[i]);
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        mark_global_writes(global_stmts[i], NULL);
+    }
+
+    for (int i = 0; i < fnDefCount; i++) {
+        Node *fn = fn_defs[i];
+        if ((fn->flags & NODE_FLAG_MEMO) && !fn_should_memoize(fn)) {
+            fprintf(stderr, "Erro Semântico: 'memo fn %s' exige função pura (sem say/hear/globais) com parâmetros e retorno escalares.\n", fn->name);
+            exit(1);
+        }
+        check_spawns(fn->mid);
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        check_spawns(global_stmts[i]);
+    }
+}
@@ -0,0 +1,1047 @@
+// asmgen.c -- Backend x86-64 direto da AST (System V, sintaxe AT&T do GNU as)
+//
+// Usado em builds de depuração rápidas (--asm): gera output.s, que é montado com
+// 'as' e ligado sem passar pelo compilador C. O backend C continua sendo o dos
+// builds otimizados e o único com --profile, --bench e módulos.
+//
+// Modelo de execução:
+//  - Expressões deixam o resultado em %eax (int/boolean), %rax (text) ou %xmm0 (float).
+//    Um operando direito que é folha (literal ou variável) entra direto na
+//    instrução; os demais são salvos na pilha com push/pop.
+//  - Alocação de registradores: parâmetros e locais int/boolean/text mais usados
+//    ficam em %rbx e %r12-%r15 (callee-saved, sobrevivem às chamadas); o resto
+//    (e todo float) fica em slots de 8 bytes abaixo de %rbp.
+
+#include "compiler.h"
+#include <stdarg.h>
+
+#define ASM_MAX_SLOTS 256
+#define ASM_MAX_LITERALS 4096
+#define ASM_NUM_REGS 5
+#define ASM_MAX_ARGS 16
+#define ASM_HEAR_BUF 1024
+
+static FILE *asmf = NULL;
+static int label_count = 0;
+
+static const char *REG64[ASM_NUM_REGS] = { "%rbx", "%r12", "%r13", "%r14", "%r15" };
+static const char *REG32[ASM_NUM_REGS] = { "%ebx", "%r12d", "%r13d", "%r14d", "%r15d" };
+static const char *ARG64[6] = { "%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9" };
+static const char *ARG32[6] = { "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d" };
+
+// Literais emitidos em .rodata no fim do arquivo
+static const char *str_lits[ASM_MAX_LITERALS];
+static int strLitCount = 0;
+static const char *float_lits[ASM_MAX_LITERALS];
+static int floatLitCount = 0;
+
+// --- Estado da Função Atual ---
+
+typedef struct {
+    Node *decl;        // N_VAR_DECL do parâmetro ou da local
+    const char *ctype; // Tipo C: int, double ou char*
+    int reg;           // Índice em REG64/REG32, ou -1 (pilha)
+    int offset;        // Deslocamento em relação a %rbp (slots na pilha)
+    int uses;
+    int needs_addr;    // Alvo de 'hear' numérico: scanf precisa do endereço
+} AsmSlot;
+
+static AsmSlot slots[ASM_MAX_SLOTS];
+static int slotCount = 0;
+static int active[ASM_MAX_SLOTS]; // Slots visíveis no escopo atual (pilha de escopos)
+static int activeCount = 0;
+
+static Node *cur_fn = NULL;  // Função atual (contexto sintético no main)
+static int regs_used = 0;    // Registradores callee-saved salvos no prólogo
+static int temp_depth = 0;   // Pushes pendentes (alinhamento de 16 bytes nas chamadas)
+static int ret_label = 0;
+
+typedef struct {
+    const char *ctype;
+    char op[MAX_TOKEN_LEN + 16]; // Operando AT&T: registrador, N(%rbp) ou nome(%rip)
+} VarRef;
+
+static void gen_expr(Node *n);
+static void gen_statement(Node *n);
+
+// ------------------------------------------
+// --- Utilidades de Emissão ---
+// ------------------------------------------
+
+static void emit(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fputc('\t', asmf);
+    vfprintf(asmf, fmt, ap);
+    fputc('\n', asmf);
+    va_end(ap);
+}
+
+static int new_label() {
+    return label_count++;
+}
+
+static void emit_label(int label) {
+    fprintf(asmf, ".L%d:\n", label);
+}
+
+static int string_literal(const char *text) {
+    for (int i = 0; i < strLitCount; i++) {
+        if (strcmp(str_lits[i], text) == 0) return i;
+    }
+    if (strLitCount >= ASM_MAX_LITERALS) {
+        fprintf(stderr, "Erro: Limite de literais text excedido no backend asm.\n");
+        exit(1);
+    }
+    str_lits[strLitCount] = text;
+    return strLitCount++;
+}
+
+static int float_literal(const char *text) {
+    for (int i = 0; i < floatLitCount; i++) {
+        if (strcmp(float_lits[i], text) == 0) return i;
+    }
+    if (floatLitCount >= ASM_MAX_LITERALS) {
+        fprintf(stderr, "Erro: Limite de literais float excedido no backend asm.\n");
+        exit(1);
+    }
+    float_lits[floatLitCount] = text;
+    return floatLitCount++;
+}
+
+static void push_rax() {
+    emit("pushq %%rax");
+    temp_depth++;
+}
+
+static void push_xmm0() {
+    emit("movq %%xmm0, %%rax");
+    push_rax();
+}
+
+static void pop_reg(const char *reg) {
+    emit("popq %s", reg);
+    temp_depth--;
+}
+
+// Chamada com %rsp alinhado em 16 bytes (o prólogo alinha; cada push desalinha 8)
+static void emit_call(const char *target) {
+    int pad = temp_depth % 2;
+    if (pad) emit("subq $8, %%rsp");
+    emit("call %s", target);
+    if (pad) emit("addq $8, %%rsp");
+}
+
+// ------------------------------------------
+// --- Tipos e Variáveis ---
+// ------------------------------------------
+
+static const char *ctype_of(Node *n) {
+    return sauce_type_to_c(get_expr_type(n, cur_fn));
+}
+
+static int is_double(const char *ctype) {
+    return strcmp(ctype, "double") == 0;
+}
+
+static int is_ptr(const char *ctype) {
+    return strcmp(ctype, "char*") == 0;
+}
+
+static Node *find_fn(const char *name) {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (strcmp(fn_defs[i]->name, name) == 0) return fn_defs[i];
+    }
+    return NULL;
+}
+
+static const char *asm_fn_name(const char *sauce_name) {
+    return strcmp(sauce_name, "main") == 0 ? "sauce_main" : sauce_name;
+}
+
+static VarRef resolve_var(const char *name) {
+    VarRef ref;
+    for (int i = activeCount - 1; i >= 0; i--) {
+        AsmSlot *s = &slots[active[i]];
+        if (strcmp(s->decl->name, name) != 0) continue;
+        ref.ctype = s->ctype;
+        if (s->reg >= 0) {
+            snprintf(ref.op, sizeof(ref.op), "%s", is_ptr(s->ctype) ? REG64[s->reg] : REG32[s->reg]);
+        } else {
+            snprintf(ref.op, sizeof(ref.op), "%d(%%rbp)", s->offset);
+        }
+        return ref;
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind == N_VAR_DECL && strcmp(stmt->name, name) == 0) {
+            ref.ctype = sauce_type_to_c(stmt->typeName);
+            snprintf(ref.op, sizeof(ref.op), "%s(%%rip)", name);
+            return ref;
+        }
+    }
+    fprintf(stderr, "Erro Semântico: Variável '%s' não declarada.\n", name);
+    exit(1);
+}
+
+static void load_var(VarRef *v) {
+    if (is_double(v->ctype)) emit("movsd %s, %%xmm0", v->op);
+    else if (is_ptr(v->ctype)) emit("movq %s, %%rax", v->op);
+    else emit("movl %s, %%eax", v->op);
+}
+
+static void store_var(VarRef *v) {
+    if (is_double(v->ctype)) emit("movsd %%xmm0, %s", v->op);
+    else if (is_ptr(v->ctype)) emit("movq %%rax, %s", v->op);
+    else emit("movl %%eax, %s", v->op);
+}
+
+// Conversões implícitas do C entre int e double
+static void convert(const char *from, const char *to) {
+    if (strcmp(from, "int") == 0 && is_double(to)) emit("cvtsi2sdl %%eax, %%xmm0");
+    else if (is_double(from) && strcmp(to, "int") == 0) emit("cvttsd2si %%xmm0, %%eax");
+}
+
+static void gen_expr_as(Node *n, const char *ctype) {
+    gen_expr(n);
+    convert(ctype_of(n), ctype);
+}
+
+// Folha já no tipo 'ctype' que pode ser operando direto; 0 se precisa ser avaliada
+static int leaf_operand(Node *n, const char *ctype, char *buf, size_t size) {
+    if (n->kind != N_INT && n->kind != N_BOOL && n->kind != N_FLOAT && n->kind != N_VAR) return 0;
+    if (strcmp(ctype_of(n), ctype) != 0) return 0;
+
+    switch (n->kind) {
+        case N_INT:
+            snprintf(buf, size, "$%s", n->text);
+            return 1;
+        case N_BOOL:
+            snprintf(buf, size, "$%d", strcmp(n->text, "true") == 0);
+            return 1;
+        case N_FLOAT:
+            snprintf(buf, size, ".LF%d(%%rip)", float_literal(n->text));
+            return 1;
+        default: {
+            VarRef v = resolve_var(n->name);
+            if (strcmp(v.ctype, ctype) != 0) return 0;
+            snprintf(buf, size, "%s", v.op);
+            return 1;
+        }
+    }
+}
+
+// ------------------------------------------
+// --- Expressões ---
+// ------------------------------------------
+
+static int is_compare(NodeKind k) {
+    return k == N_GT || k == N_LT || k == N_GTE || k == N_LTE || k == N_EQ_CMP || k == N_NEQ;
+}
+
+static const char *int_cc(NodeKind k) {
+    switch (k) {
+        case N_GT: return "g";
+        case N_LT: return "l";
+        case N_GTE: return "ge";
+        case N_LTE: return "le";
+        case N_EQ_CMP: return "e";
+        default: return "ne";
+    }
+}
+
+static const char *int_cc_inverse(NodeKind k) {
+    switch (k) {
+        case N_GT: return "le";
+        case N_LT: return "ge";
+        case N_GTE: return "l";
+        case N_LTE: return "g";
+        case N_EQ_CMP: return "ne";
+        default: return "e";
+    }
+}
+
+// Esquerda em %eax; direita como operando direto ou em %ecx
+static void gen_int_operands(Node *n, char *rhs, size_t size) {
+    gen_expr(n->left);
+    if (leaf_operand(n->right, "int", rhs, size)) return;
+    push_rax();
+    gen_expr(n->right);
+    emit("movl %%eax, %%ecx");
+    pop_reg("%rax");
+    snprintf(rhs, size, "%%ecx");
+}
+
+static void gen_int_binary(Node *n) {
+    char rhs[MAX_TOKEN_LEN + 16];
+    gen_int_operands(n, rhs, sizeof(rhs));
+
+    switch (n->kind) {
+        case N_ADD: emit("addl %s, %%eax", rhs); break;
+        case N_SUB: emit("subl %s, %%eax", rhs); break;
+        case N_MUL: emit("imull %s, %%eax", rhs); break;
+        case N_DIV:
+            if (rhs[0] == '$') {
+                emit("movl %s, %%ecx", rhs);
+                snprintf(rhs, sizeof(rhs), "%%ecx");
+            }
+            emit("cltd");
+            emit("idivl %s", rhs);
+            break;
+        default:
+            emit("cmpl %s, %%eax", rhs);
+            emit("set%s %%al", int_cc(n->kind));
+            emit("movzbl %%al, %%eax");
+            break;
+    }
+}
+
+// Esquerda em %xmm0, direita em %xmm1 (ambas convertidas para double)
+static void gen_float_binary(Node *n) {
+    char rhs[MAX_TOKEN_LEN + 16];
+    gen_expr_as(n->left, "double");
+    if (leaf_operand(n->right, "double", rhs, sizeof(rhs))) {
+        emit("movsd %s, %%xmm1", rhs);
+    } else {
+        push_xmm0();
+        gen_expr_as(n->right, "double");
+        emit("movapd %%xmm0, %%xmm1");
+        pop_reg("%rax");
+        emit("movq %%rax, %%xmm0");
+    }
+
+    switch (n->kind) {
+        case N_ADD: emit("addsd %%xmm1, %%xmm0"); return;
+        case N_SUB: emit("subsd %%xmm1, %%xmm0"); return;
+        case N_MUL: emit("mulsd %%xmm1, %%xmm0"); return;
+        case N_DIV: emit("divsd %%xmm1, %%xmm0"); return;
+        // ucomisd marca 'unordered' (NaN) com CF/ZF/PF = 1: a/ae com operandos trocados
+        // para < e <= fazem toda comparação com NaN dar falso, como em C
+        case N_GT: emit("ucomisd %%xmm1, %%xmm0"); emit("seta %%al"); break;
+        case N_GTE: emit("ucomisd %%xmm1, %%xmm0"); emit("setae %%al"); break;
+        case N_LT: emit("ucomisd %%xmm0, %%xmm1"); emit("seta %%al"); break;
+        case N_LTE: emit("ucomisd %%xmm0, %%xmm1"); emit("setae %%al"); break;
+        case N_EQ_CMP:
+            emit("ucomisd %%xmm1, %%xmm0");
+            emit("sete %%al");
+            emit("setnp %%cl");
+            emit("andb %%cl, %%al");
+            break;
+        default:
+            emit("ucomisd %%xmm1, %%xmm0");
+            emit("setne %%al");
+            emit("setp %%cl");
+            emit("orb %%cl, %%al");
+            break;
+    }
+    emit("movzbl %%al, %%eax");
+}
+
+// Comparação de text: compara o conteúdo (strcmp), como o C gerado; NULL vale como ""
+static void gen_ptr_compare(Node *n) {
+    gen_expr(n->left);
+    push_rax();
+    gen_expr(n->right);
+    emit("movq %%rax, %%rsi");
+    pop_reg("%rdi");
+    emit("leaq .LS%d(%%rip), %%rcx", string_literal(""));
+    emit("testq %%rdi, %%rdi");
+    emit("cmoveq %%rcx, %%rdi");
+    emit("testq %%rsi, %%rsi");
+    emit("cmoveq %%rcx, %%rsi");
+    emit_call("strcmp@PLT");
+    emit("cmpl $0, %%eax");
+    switch (n->kind) {
+        case N_GT: emit("setg %%al"); break;
+        case N_LT: emit("setl %%al"); break;
+        case N_GTE: emit("setge %%al"); break;
+        case N_LTE: emit("setle %%al"); break;
+        case N_EQ_CMP: emit("sete %%al"); break;
+        default: emit("setne %%al"); break;
+    }
+    emit("movzbl %%al, %%eax");
+}
+
+static void gen_binary(Node *n) {
+    const char *lt = ctype_of(n->left);
+    const char *rt = ctype_of(n->right);
+    if (is_ptr(ctype_of(n))) { // Valida os tipos (erro em aritmética com text)
+        fprintf(stderr, "Erro: --asm ainda não suporta concatenação de text ('+'); use o backend C.\n");
+        exit(1);
+    }
+
+    if (is_compare(n->kind) && (is_ptr(lt) || is_ptr(rt))) {
+        gen_ptr_compare(n);
+    } else if (is_double(lt) || is_double(rt)) {
+        gen_float_binary(n);
+    } else {
+        gen_int_binary(n);
+    }
+}
+
+// Avalia 'n' e deixa ZF = 1 se o valor é falso (zero, NULL ou 0.0)
+static void gen_truth(Node *n) {
+    const char *t = ctype_of(n);
+    gen_expr(n);
+    if (is_double(t)) {
+        // NaN é verdadeiro em C: só 0.0 ordenado é falso
+        emit("xorpd %%xmm1, %%xmm1");
+        emit("ucomisd %%xmm1, %%xmm0");
+        emit("setne %%al");
+        emit("setp %%cl");
+        emit("orb %%cl, %%al");
+        emit("movzbl %%al, %%eax");
+        emit("testl %%eax, %%eax");
+    } else if (is_ptr(t)) {
+        emit("testq %%rax, %%rax");
+    } else {
+        emit("testl %%eax, %%eax");
+    }
+}
+
+// Salto condicional sem materializar o booleano quando a condição é comparação de int
+static void gen_jump_if_false(Node *cond, int label) {
+    if (is_compare(cond->kind) && strcmp(ctype_of(cond->left), "int") == 0 &&
+        strcmp(ctype_of(cond->right), "int") == 0) {
+        char rhs[MAX_TOKEN_LEN + 16];
+        gen_int_operands(cond, rhs, sizeof(rhs));
+        emit("cmpl %s, %%eax", rhs);
+        emit("j%s .L%d", int_cc_inverse(cond->kind), label);
+        return;
+    }
+    gen_truth(cond);
+    emit("je .L%d", label);
+}
+
+static void gen_logical(Node *n) {
+    int done = new_label();
+    int shortcut = new_label();
+    if (n->kind == N_AND) {
+        gen_jump_if_false(n->left, shortcut);
+        gen_jump_if_false(n->right, shortcut);
+        emit("movl $1, %%eax");
+        emit("jmp .L%d", done);
+        emit_label(shortcut);
+        emit("xorl %%eax, %%eax");
+    } else {
+        gen_truth(n->left);
+        emit("jne .L%d", shortcut);
+        gen_truth(n->right);
+        emit("jne .L%d", shortcut);
+        emit("xorl %%eax, %%eax");
+        emit("jmp .L%d", done);
+        emit_label(shortcut);
+        emit("movl $1, %%eax");
+    }
+    emit_label(done);
+}
+
+// Argumentos avaliados da esquerda para a direita e empilhados; depois desempilhados
+// nos registradores de argumento (%rdi... para int/text, %xmm0... para float).
+static void gen_call(Node *n) {
+    Node *callee = find_fn(n->name);
+    if (!callee) {
+        fprintf(stderr, "Erro Semântico: Função '%s' não definida.\n", n->name);
+        exit(1);
+    }
+
+    int is_float[ASM_MAX_ARGS], reg_idx[ASM_MAX_ARGS];
+    int nargs = 0, nint = 0, nfloat = 0;
+    Node *p = callee->left, *a = n->left;
+    while (a) {
+        if (!p) break;
+        const char *pt = sauce_type_to_c(p->left->typeName);
+        if (nargs >= ASM_MAX_ARGS || (is_double(pt) ? nfloat >= 8 : nint >= 6)) {
+            fprintf(stderr, "Erro: O backend asm suporta até 6 argumentos int/text e 8 float por chamada ('%s'); use o backend C.\n", n->name);
+            exit(1);
+        }
+        gen_expr_as(a->left, pt);
+        is_float[nargs] = is_double(pt);
+        if (is_float[nargs]) {
+            reg_idx[nargs] = nfloat++;
+            push_xmm0();
+        } else {
+            reg_idx[nargs] = nint++;
+            push_rax();
+        }
+        nargs++;
+        p = p->right;
+        a = a->right;
+    }
+    if (p || a) {
+        fprintf(stderr, "Erro Semântico: Número de argumentos incorreto na chamada de '%s'.\n", n->name);
+        exit(1);
+    }
+
+    for (int k = nargs - 1; k >= 0; k--) {
+        if (is_float[k]) {
+            pop_reg("%rax");
+            emit("movq %%rax, %%xmm%d", reg_idx[k]);
+        } else {
+            pop_reg(ARG64[reg_idx[k]]);
+        }
+    }
+    emit_call(asm_fn_name(callee->name));
+}
+
+static void gen_expr(Node *n) {
+    if (!n) return;
+
+    switch (n->kind) {
+        case N_INT:
+            emit("movl $%s, %%eax", n->text);
+            break;
+        case N_BOOL:
+            emit("movl $%d, %%eax", strcmp(n->text, "true") == 0);
+            break;
+        case N_FLOAT:
+            emit("movsd .LF%d(%%rip), %%xmm0", float_literal(n->text));
+            break;
+        case N_STRING:
+            emit("leaq .LS%d(%%rip), %%rax", string_literal(n->text));
+            break;
+        case N_VAR: {
+            VarRef v = resolve_var(n->name);
+            load_var(&v);
+            break;
+        }
+        case N_FN_CALL:
+            gen_call(n);
+            break;
+        case N_NOT:
+            gen_truth(n->left);
+            emit("sete %%al");
+            emit("movzbl %%al, %%eax");
+            break;
+        case N_AND:
+        case N_OR:
+            gen_logical(n);
+            break;
+        case N_ADD: case N_SUB: case N_MUL: case N_DIV:
+        case N_GT: case N_LT: case N_EQ_CMP: case N_NEQ:
+        case N_GTE: case N_LTE:
+            gen_binary(n);
+            break;
+        default:
+            fprintf(stderr, "Erro Interno: Expressão de nó desconhecida: %d\n", n->kind);
+            exit(1);
+    }
+}
+
+// ------------------------------------------
+// --- Comandos ---
+// ------------------------------------------
+
+static int find_slot(Node *decl) {
+    for (int i = 0; i < slotCount; i++) {
+        if (slots[i].decl == decl) return i;
+    }
+    return -1;
+}
+
+static void gen_block(Node *list) {
+    int mark = activeCount; // Locais do bloco saem de escopo no fim (como em C)
+    for (Node *w = list; w; w = w->right) {
+        gen_statement(w->left);
+    }
+    activeCount = mark;
+}
+
+// Atribuição de text: strdup do novo valor e free do antigo
+static void gen_text_assign(VarRef *v, Node *expr) {
+    gen_expr(expr);
+    push_rax();
+    load_var(v);
+    emit("movq %%rax, %%rdi");
+    emit_call("free@PLT");
+    pop_reg("%rdi");
+    emit_call("strdup@PLT");
+    store_var(v);
+}
+
+static void gen_printf(int fmt, int nvec) {
+    emit("leaq .LS%d(%%rip), %%rdi", fmt);
+    emit("movl $%d, %%eax", nvec); // %al: registradores vetoriais usados (varargs)
+    emit_call("printf@PLT");
+}
+
+static void gen_say(Node *n) {
+    Node *expr = n->left;
+    const char *type = get_expr_type(expr, cur_fn);
+    const char *ctype = sauce_type_to_c(type);
+
+    if (strcmp(type, "boolean") == 0 || strcmp(type, "bool") == 0) {
+        int is_false = new_label(), done = new_label();
+        gen_truth(expr);
+        emit("je .L%d", is_false);
+        emit("leaq .LS%d(%%rip), %%rsi", string_literal("true"));
+        emit("jmp .L%d", done);
+        emit_label(is_false);
+        emit("leaq .LS%d(%%rip), %%rsi", string_literal("false"));
+        emit_label(done);
+        gen_printf(string_literal("%s\\n"), 0);
+    } else if (strcmp(ctype, "int") == 0) {
+        gen_expr(expr);
+        emit("movl %%eax, %%esi");
+        gen_printf(string_literal("%d\\n"), 0);
+    } else if (is_double(ctype)) {
+        gen_expr(expr);
+        gen_printf(string_literal("%f\\n"), 1);
+    } else if (is_ptr(ctype)) {
+        gen_expr(expr);
+        emit("movq %%rax, %%rsi");
+        gen_printf(string_literal("%s\\n"), 0);
+    } else {
+        gen_printf(string_literal("Erro: Tipo desconhecido (SAID) para saida.\\n"), 0);
+    }
+}
+
+// Descarta o resto da linha após uma leitura numérica
+static void gen_flush_line() {
+    int loop = new_label(), done = new_label();
+    emit_label(loop);
+    emit_call("getchar@PLT");
+    emit("cmpl $10, %%eax");
+    emit("je .L%d", done);
+    emit("cmpl $-1, %%eax");
+    emit("jne .L%d", loop);
+    emit_label(done);
+}
+
+static void gen_load_stdin(const char *reg) {
+    emit("movq stdin@GOTPCREL(%%rip), %s", reg);
+    emit("movq (%s), %s", reg, reg);
+}
+
+static void gen_hear(Node *n) {
+    VarRef v = resolve_var(n->left->name);
+    gen_printf(string_literal("\\n> "), 0);
+
+    if (!is_ptr(v.ctype)) {
+        emit("leaq %s, %%rsi", v.op);
+        emit("leaq .LS%d(%%rip), %%rdi", string_literal(is_double(v.ctype) ? "%lf" : "%d"));
+        emit("xorl %%eax, %%eax");
+        emit_call("scanf@PLT");
+        gen_flush_line();
+        return;
+    }
+
+    // 1. Pula espaços (isspace do locale C: ' ' e \t..\r) e devolve o primeiro caractere útil
+    int skip = new_label(), done = new_label();
+    emit_label(skip);
+    emit_call("getchar@PLT");
+    emit("cmpl $-1, %%eax");
+    emit("je .L%d", done);
+    emit("cmpl $32, %%eax");
+    emit("je .L%d", skip);
+    emit("leal -9(%%rax), %%ecx");
+    emit("cmpl $4, %%ecx");
+    emit("jbe .L%d", skip);
+    emit("movl %%eax, %%edi");
+    gen_load_stdin("%rsi");
+    emit_call("ungetc@PLT");
+    emit_label(done);
+
+    // 2. Lê a linha em um buffer na pilha, remove o '\n' e guarda uma cópia
+    int read_ok = new_label();
+    emit("subq $%d, %%rsp", ASM_HEAR_BUF);
+    emit("movq %%rsp, %%rdi");
+    emit("movl $%d, %%esi", ASM_HEAR_BUF);
+    gen_load_stdin("%rdx");
+    emit_call("fgets@PLT");
+    emit("testq %%rax, %%rax");
+    emit("jne .L%d", read_ok);
+    emit("movb $0, (%%rsp)");
+    emit_label(read_ok);
+    emit("movq %%rsp, %%rdi");
+    emit("leaq .LS%d(%%rip), %%rsi", string_literal("\\n"));
+    emit_call("strcspn@PLT");
+    emit("movb $0, (%%rsp,%%rax)");
+    load_var(&v);
+    emit("movq %%rax, %%rdi");
+    emit_call("free@PLT");
+    emit("movq %%rsp, %%rdi");
+    emit_call("strdup@PLT");
+    store_var(&v);
+    emit("addq $%d, %%rsp", ASM_HEAR_BUF);
+}
+
+static int is_self_tail_call(Node *ret) {
+    return ret->left && ret->left->kind == N_FN_CALL && strcmp(ret->left->name, cur_fn->name) == 0;
+}
+
+// return f(...) dentro de f: argumentos vão para os parâmetros e salta para a entrada
+static void gen_self_tail_call(Node *call) {
+    Node *p = cur_fn->left, *a = call->left;
+    int nargs = 0;
+    for (; p && a; p = p->right, a = a->right, nargs++) {
+        const char *pt = sauce_type_to_c(p->left->typeName);
+        gen_expr_as(a->left, pt);
+        if (is_double(pt)) push_xmm0();
+        else push_rax();
+    }
+    if (p || a) {
+        fprintf(stderr, "Erro Semântico: Número de argumentos incorreto na chamada recursiva de '%s'.\n", cur_fn->name);
+        exit(1);
+    }
+    for (int k = nargs - 1; k >= 0; k--) {
+        Node *param = cur_fn->left;
+        for (int i = 0; i < k; i++) param = param->right;
+        VarRef v = resolve_var(param->left->name);
+        pop_reg("%rax");
+        if (is_double(v.ctype)) emit("movq %%rax, %%xmm0");
+        store_var(&v);
+    }
+    emit("jmp .Ltco_%s", asm_fn_name(cur_fn->name));
+}
+
+static void gen_statement(Node *n) {
+    if (!n) return;
+
+    // -g: o 'as' gera a tabela de linhas (.debug_line) a partir dos .loc
+    if (cg_options.line_directives && n->line > 0) {
+        emit(".loc 1 %d %d", n->line, n->col);
+    }
+
+    switch (n->kind) {
+        case N_VAR_DECL: {
+            // Declarações locais (as globais são tratadas por gen_main)
+            int slot = find_slot(n);
+            if (slot < 0) {
+                fprintf(stderr, "Erro Interno: Local '%s' sem slot no backend asm.\n", n->name);
+                exit(1);
+            }
+            const char *ctype = slots[slot].ctype;
+            if (n->left) {
+                gen_expr_as(n->left, ctype);
+            } else if (is_double(ctype)) {
+                emit("xorpd %%xmm0, %%xmm0");
+            } else {
+                emit("xorl %%eax, %%eax");
+            }
+            active[activeCount++] = slot;
+            VarRef v = resolve_var(n->name);
+            store_var(&v);
+            break;
+        }
+
+        case N_VAR_ASSIGN: {
+            VarRef v = resolve_var(n->name);
+            if (is_ptr(v.ctype)) {
+                gen_text_assign(&v, n->left);
+            } else {
+                gen_expr_as(n->left, v.ctype);
+                store_var(&v);
+            }
+            break;
+        }
+
+        case N_SAY:
+            gen_say(n);
+            break;
+
+        case N_HEAR:
+            gen_hear(n);
+            break;
+
+        case N_IF: {
+            int else_label = new_label(), end_label = new_label();
+            gen_jump_if_false(n->left, else_label);
+            gen_block(n->right);
+            if (n->mid) emit("jmp .L%d", end_label);
+            emit_label(else_label);
+            if (n->mid) {
+                if (n->mid->kind == N_IF) gen_statement(n->mid);
+                else gen_block(n->mid);
+                emit_label(end_label);
+            }
+            break;
+        }
+
+        case N_RETURN: {
+            if (is_self_tail_call(n)) {
+                gen_self_tail_call(n->left);
+                break;
+            }
+            const char *ret_type = sauce_type_to_c(cur_fn->typeName);
+            if (n->left) {
+                if (n->explicitReturnType[0] != '\0') {
+                    const char *cast = sauce_type_to_c(n->explicitReturnType);
+                    gen_expr_as(n->left, cast);
+                    convert(cast, ret_type);
+                } else {
+                    gen_expr_as(n->left, ret_type);
+                }
+            }
+            emit("jmp .L%d", ret_label);
+            break;
+        }
+
+        case N_EXPR_STMT:
+            gen_expr(n->left);
+            break;
+
+        case N_IMPORT:
+        case N_BENCH:
+            // Módulos e bench só existem no backend C (o driver recusa as combinações)
+            break;
+
+        default:
+            fprintf(stderr, "Erro Interno: Comando de nó desconhecido para geração: %d\n", n->kind);
+            exit(1);
+    }
+}
+
+// ------------------------------------------
+// --- Quadros de Pilha e Alocação de Registradores ---
+// ------------------------------------------
+
+static void add_slot(Node *decl) {
+    if (slotCount >= ASM_MAX_SLOTS) {
+        fprintf(stderr, "Erro: Variáveis locais demais em uma função para o backend asm.\n");
+        exit(1);
+    }
+    AsmSlot *s = &slots[slotCount++];
+    s->decl = decl;
+    s->ctype = sauce_type_to_c(decl->typeName);
+    s->reg = -1;
+    s->offset = 0;
+    s->uses = 0;
+    s->needs_addr = 0;
+}
+
+// Locais declaradas em qualquer bloco (then/else e cadeias else-if)
+static void collect_decls(Node *n) {
+    if (!n) return;
+    if (n->kind == N_VAR_DECL) {
+        add_slot(n);
+    } else if (n->kind == N_STMT_LIST) {
+        collect_decls(n->left);
+        collect_decls(n->right);
+    } else if (n->kind == N_IF) {
+        collect_decls(n->right);
+        collect_decls(n->mid);
+    }
+}
+
+static void count_uses(Node *n) {
+    if (!n) return;
+    if (n->kind == N_VAR || n->kind == N_VAR_ASSIGN) {
+        for (int i = 0; i < slotCount; i++) {
+            if (strcmp(slots[i].decl->name, n->name) == 0) slots[i].uses++;
+        }
+    } else if (n->kind == N_HEAR && n->left) {
+        for (int i = 0; i < slotCount; i++) {
+            if (strcmp(slots[i].decl->name, n->left->name) == 0 && !is_ptr(slots[i].ctype)) slots[i].needs_addr = 1;
+        }
+    }
+    count_uses(n->left);
+    count_uses(n->mid);
+    count_uses(n->right);
+}
+
+// Os ASM_NUM_REGS slots int/text mais usados vão para registradores; o resto para a pilha
+static int assign_registers() {
+    int used = 0;
+    while (used < ASM_NUM_REGS) {
+        int best = -1;
+        for (int i = 0; i < slotCount; i++) {
+            AsmSlot *s = &slots[i];
+            if (s->reg >= 0 || s->needs_addr || is_double(s->ctype) || s->uses == 0) continue;
+            if (best < 0 || s->uses > slots[best].uses) best = i;
+        }
+        if (best < 0) break;
+        slots[best].reg = used++;
+    }
+    return used;
+}
+
+// Prólogo: %rbp, registradores salvos e slots; %rsp fica alinhado em 16 bytes
+static void begin_frame(const char *name, int global) {
+    regs_used = assign_registers();
+    int stack_slots = 0;
+    for (int i = 0; i < slotCount; i++) {
+        if (slots[i].reg < 0) {
+            slots[i].offset = -(8 * regs_used + 8 * (stack_slots + 1));
+            stack_slots++;
+        }
+    }
+    int frame = 8 * stack_slots;
+    if ((8 * regs_used + frame) % 16 != 0) frame += 8;
+
+    fprintf(asmf, "\n\t.text\n");
+    if (global) fprintf(asmf, "\t.globl %s\n", name);
+    fprintf(asmf, "\t.type %s, @function\n", name);
+    fprintf(asmf, "%s:\n", name);
+    emit("pushq %%rbp");
+    emit("movq %%rsp, %%rbp");
+    for (int i = 0; i < regs_used; i++) {
+        emit("pushq %s", REG64[i]);
+    }
+    if (frame > 0) emit("subq $%d, %%rsp", frame);
+
+    temp_depth = 0;
+    activeCount = 0;
+    ret_label = new_label();
+}
+
+static void end_frame(const char *name) {
+    emit_label(ret_label);
+    if (regs_used > 0) emit("leaq -%d(%%rbp), %%rsp", 8 * regs_used);
+    else emit("movq %%rbp, %%rsp");
+    for (int i = regs_used - 1; i >= 0; i--) {
+        emit("popq %s", REG64[i]);
+    }
+    emit("popq %%rbp");
+    emit("ret");
+    fprintf(asmf, "\t.size %s, .-%s\n", name, name);
+}
+
+static void gen_function(Node *fn) {
+    const char *name = asm_fn_name(fn->name);
+    cur_fn = fn;
+    slotCount = 0;
+    for (Node *p = fn->left; p; p = p->right) {
+        add_slot(p->left);
+    }
+    int nparams = slotCount;
+    collect_decls(fn->mid);
+    count_uses(fn->mid);
+
+    begin_frame(name, 0);
+
+    // Parâmetros: dos registradores de argumento para os seus slots
+    int nint = 0, nfloat = 0;
+    for (int i = 0; i < nparams; i++) {
+        if (is_double(slots[i].ctype)) nfloat++;
+        else nint++;
+    }
+    if (nint > 6 || nfloat > 8) {
+        fprintf(stderr, "Erro: O backend asm suporta até 6 parâmetros int/text e 8 float ('%s'); use o backend C.\n", fn->name);
+        exit(1);
+    }
+    nint = nfloat = 0;
+    for (int i = 0; i < nparams; i++) {
+        active[activeCount++] = i;
+        VarRef v = resolve_var(slots[i].decl->name);
+        if (is_double(v.ctype)) emit("movsd %%xmm%d, %s", nfloat++, v.op);
+        else if (is_ptr(v.ctype)) emit("movq %s, %s", ARG64[nint++], v.op);
+        else emit("movl %s, %s", ARG32[nint++], v.op);
+    }
+    fprintf(asmf, ".Ltco_%s:\n", name);
+
+    gen_block(fn->mid);
+
+    // Retorno de segurança: 0 / 0.0 / NULL
+    emit("xorl %%eax, %%eax");
+    emit("xorpd %%xmm0, %%xmm0");
+    end_frame(name);
+}
+
+// main: inicializadores globais e comandos de topo na ordem original
+static void gen_main() {
+    // Contexto sintético (como o dos blocos bench): as locais dos 'if' de topo
+    // ficam visíveis para a inferência de tipos de get_expr_type
+    Node *ifs = NULL, *tail = NULL;
+    slotCount = 0;
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind != N_IF) continue;
+        collect_decls(stmt);
+        Node *w = make_node(N_STMT_LIST, NULL, NULL, stmt, NULL, NULL);
+        if (tail) tail->right = w;
+        else ifs = w;
+        tail = w;
+    }
+    cur_fn = make_node(N_FN_DEF, "_sauce_main", NULL, NULL, ifs, NULL);
+    strcpy(cur_fn->typeName, "int");
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (global_stmts[i]->kind != N_BENCH) count_uses(global_stmts[i]);
+    }
+
+    begin_frame("main", 1);
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind != N_VAR_DECL) {
+            gen_statement(stmt);
+            continue;
+        }
+        if (!stmt->left) continue;
+        if (cg_options.line_directives && stmt->line > 0) emit(".loc 1 %d %d", stmt->line, stmt->col);
+        VarRef v = resolve_var(stmt->name);
+        if (is_ptr(v.ctype)) {
+            gen_text_assign(&v, stmt->left);
+        } else {
+            gen_expr_as(stmt->left, v.ctype);
+            store_var(&v);
+        }
+    }
+
+    // Libera as strings globais
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind == N_VAR_DECL && is_ptr(sauce_type_to_c(stmt->typeName))) {
+            emit("movq %s(%%rip), %%rdi", stmt->name);
+            emit_call("free@PLT");
+        }
+    }
+    emit("xorl %%eax, %%eax");
+    end_frame("main");
+}
+
+// ------------------------------------------
+// --- Ponto de Entrada do Backend ---
+// ------------------------------------------
+
+void generate_asm(const char *out_s) {
+    prepare_program(0); // Build de depuração: sem inlining nem dobramento
+
+
+    stats_enter(PHASE_CODEGEN);
+    asmf = fopen(out_s, "w");
+    if (!asmf) { perror("Erro ao abrir arquivo de saída"); exit(1); }
+
+    label_count = 0;
+    strLitCount = 0;
+    floatLitCount = 0;
+
+    fprintf(asmf, "# Assembly x86-64 gerado pelo compilador Sauce (backend direto)\n");
+    if (cg_options.line_directives) {
+        fprintf(asmf, "\t.file 1 \"");
+        for (const char *c = cg_options.source_file; *c; c++) {
+            if (*c == '"' || *c == '\\') fputc('\\', asmf);
+            fputc(*c, asmf);
+        }
+        fprintf(asmf, "\"\n");
+    }
+
+    // 1. Variáveis globais (zeradas em .bss; os inicializadores rodam no main)
+    int any_global = 0;
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind != N_VAR_DECL) continue;
+        if (!any_global++) fprintf(asmf, "\t.bss\n\t.align 8\n");
+        fprintf(asmf, "%s:\n\t.zero 8\n", stmt->name);
+    }
+
+    // 2. Funções e main
+    for (int i = 0; i < fnDefCount; i++) {
+        gen_function(fn_defs[i]);
+    }
+    gen_main();
+
+    // 3. Literais
+    fprintf(asmf, "\n\t.section .rodata\n");
+    if (floatLitCount > 0) fprintf(asmf, "\t.align 8\n");
+    for (int i = 0; i < floatLitCount; i++) {
+        fprintf(asmf, ".LF%d:\n\t.double %s\n", i, float_lits[i]);
+    }
+    for (int i = 0; i < strLitCount; i++) {
+        fprintf(asmf, ".LS%d:\n\t.string \"%s\"\n", i, str_lits[i]);
+    }
+    fprintf(asmf, "\t.section .note.GNU-stack,\"\",@progbits\n");
+
+    stats.c_bytes += ftell(asmf);
+    fclose(asmf);
+    stats_leave();
+}
@@ -0,0 +1,91 @@
+// gen_sauce.c -- Gerador determinístico de programas .sauce escaláveis para o bench
+//
+// Uso: gen_sauce <funções> <globais> <profundidade> <cadeia> > prog.sauce
+//   funções       número de 'fn' gerados
+//   globais       número de variáveis globais
+//   profundidade  profundidade das expressões aritméticas
+//   cadeia        tamanho das cadeias else-if em cada função
+//
+// O programa gerado tem <funções> + 1 'fn' e <globais> + <funções> + 2 comandos
+// globais (o limite do compilador é verificado por run.sh). Toda operação passa
+// por wrap(), que reduz o valor a (-1000, 1000): o programa nunca estoura int e
+// imprime o mesmo resultado em qualquer backend e nível de otimização.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned long long rng_state = 0x5a11ce5eedULL;
+
+// LCG simples: mesma saída em qualquer máquina
+static unsigned rnd(unsigned n) {
+    rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(rng_state >> 33) % n;
+}
+
+static int nglobals;
+
+// Expressão aleatória sobre os parâmetros a/b, globais e literais
+static void gen_expr(int depth) {
+    if (depth <= 0) {
+        switch (rnd(3)) {
+            case 0: printf("a"); break;
+            case 1: printf("b"); break;
+            default:
+                if (nglobals > 0) printf("g%u", rnd(nglobals));
+                else printf("%u", rnd(100) + 1);
+                break;
+        }
+        return;
+    }
+    static const char *ops[] = { "+", "-", "*" };
+    printf("wrap(");
+    gen_expr(depth - 1);
+    printf(" %s ", ops[rnd(3)]);
+    if (rnd(2)) printf("%u", rnd(9) + 1);
+    else gen_expr(depth - 1);
+    printf(")");
+}
+
+int main(int argc, char **argv) {
+    if (argc != 5) {
+        fprintf(stderr, "Uso: %s <funções> <globais> <profundidade> <cadeia>\n", argv[0]);
+        return 1;
+    }
+    int nfuncs = atoi(argv[1]);
+    nglobals = atoi(argv[2]);
+    int depth = atoi(argv[3]);
+    int chain = atoi(argv[4]);
+
+    for (int i = 0; i < nglobals; i++) {
+        printf("g%d[int] = %u\n", i, rnd(1000));
+    }
+    printf("\n");
+
+    // Resto da divisão por 1000 (a linguagem não tem '%'): operandos sempre pequenos
+    printf("fn wrap(x[int]) [int] {\n");
+    printf("    return x - (x / 1000) * 1000\n");
+    printf("}\n\n");
+
+    for (int f = 0; f < nfuncs; f++) {
+        printf("fn f%d(a[int], b[int]) [int] {\n", f);
+        printf("    t[int] = ");
+        gen_expr(depth);
+        printf("\n");
+        for (int c = 0; c < chain; c++) {
+            printf("    %sif (a == %d) {\n", c ? "} else " : "", c);
+            printf("        return t + %u\n", rnd(50));
+        }
+        if (chain > 0) printf("    }\n");
+        // Chama a função anterior para formar cadeias de chamadas
+        if (f > 0) printf("    return f%d(b, t / 7)\n", f - 1);
+        else printf("    return t\n");
+        printf("}\n\n");
+    }
+
+    printf("acc[int] = 0\n");
+    for (int f = 0; f < nfuncs; f++) {
+        printf("acc = wrap(acc + f%d(%u, acc / 3))\n", f, rnd(chain > 0 ? chain * 2 : 4));
+    }
+    printf("say(acc)\n");
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include <stdio.h>
+
+int main(void) {
+    int n = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    int acc = 1;
+    for (int i = 0; i < n; i++) {
+        acc = (acc + i * 3) / 2 + i / 7;
+    }
+    printf("%d\n", acc);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include <stdio.h>
+
+/* Baseline: o mesmo fluxo (range -> scaled -> total) como um laço só */
+int main(void) {
+    int n = 0, acc = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    for (int x = 1; x <= n; x++) {
+        acc += x * 3 - (x / 7) * 7;
+    }
+    printf("%d\n", acc);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include <stdio.h>
+
+int main(void) {
+    int n = 0, x = 0, acc = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    for (int k = 0; k < n; k++) {
+        if (scanf("%d", &x) != 1) break;
+        acc += x;
+    }
+    printf("%d\n", acc);
+    return 0;
+}
@@ -0,0 +1,16 @@
+#include <stdio.h>
+
+/* Baseline sequencial: a razão mostra o ganho do pool de tarefas (SAUCE_WORKERS) */
+static int seed = 0;
+
+static int tree(int k) {
+    if (k < 2) return k + seed;
+    return tree(k - 1) + tree(k - 2);
+}
+
+int main(void) {
+    int n = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    printf("%d\n", tree(n));
+    return 0;
+}
@@ -0,0 +1,21 @@
+#include <stdio.h>
+
+/* Baseline sequencial: leitura, transformação e soma no mesmo laço (sem canais) */
+static int mix(int x, int d) {
+    for (; d > 0; d--) {
+        int y = x * 13 + 7;
+        x = y - (y / 1000) * 1000;
+    }
+    return x;
+}
+
+int main(void) {
+    int n = 0, x = 0, acc = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    for (int k = 0; k < n; k++) {
+        if (scanf("%d", &x) != 1) break;
+        acc += mix(x, 200);
+    }
+    printf("%d\n", acc);
+    return 0;
+}
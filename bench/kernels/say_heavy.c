@@ -0,0 +1,11 @@
+#include <stdio.h>
+
+int main(void) {
+    int n = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    for (int i = 0; i < n; i++) {
+        printf("%d\n", i);
+    }
+    printf("%d\n", n);
+    return 0;
+}
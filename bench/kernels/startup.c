@@ -0,0 +1,10 @@
+#include <stdio.h>
+
+int main(void) {
+    int n = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    printf("%d\n", n * 2);
+    printf("%s\n", n > 10 ? "true" : "false");
+    printf("ok\n");
+    return 0;
+}
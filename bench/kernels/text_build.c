@@ -0,0 +1,25 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Baseline: um buffer que dobra de tamanho, com os números formatados no lugar */
+int main(void) {
+    int n = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    size_t len = 0, cap = 32;
+    char *buf = malloc(cap);
+    buf[0] = '\0';
+    for (int i = 0; i < n; i++) {
+        char num[16];
+        int k = snprintf(num, sizeof num, "%d,", i);
+        if (len + k + 1 > cap) {
+            while (len + k + 1 > cap) cap *= 2;
+            buf = realloc(buf, cap);
+        }
+        memcpy(buf + len, num, k + 1);
+        len += k;
+    }
+    printf("%s\n", buf);
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,18 @@
+#include <stdio.h>
+#include <string.h>
+
+/* Baseline: a chave e a comparação formatadas em buffers na pilha */
+int main(void) {
+    int n = 0;
+    if (scanf("%d", &n) != 1) return 1;
+    int hits = 0;
+    char want[64];
+    snprintf(want, sizeof want, "user:7:%d", n);
+    for (int i = 0; i < n; i++) {
+        char key[64];
+        snprintf(key, sizeof key, "user:%d:%d", i, n);
+        if (strcmp(key, want) == 0) hits++;
+    }
+    printf("%d\n", hits);
+    return 0;
+}
@@ -0,0 +1,158 @@
+#!/bin/sh
+# run.sh -- Bench do compilador Sauce (chamado por 'make bench')
+#
+# 1. Throughput do compilador: programas gerados por gen_sauce em tamanhos
+#    crescentes, medidos com --stats-json (tempo por fase, linhas/s, RSS de pico).
+#    Os tamanhos ficam abaixo de MAX_FN_DEFS (compiler.h), que limita funções e
+#    comandos globais por arquivo; um tamanho acima disso é recusado antes de gerar.
+# 2. Kernels de runtime: o 'app' gerado contra um baseline em C escrito à mão.
+# 3. Inicialização: latência exec->exit e tamanho do binário de um app curto,
+#    no perfil normal e com --static, contra o baseline em C.
+#
+# Variáveis: BENCH_RUNS (repetições por kernel, padrão 3),
+#            BENCH_STARTUP_RUNS (execuções na média de inicialização, padrão 200)
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BENCH="$ROOT/bench"
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/sauce-bench.XXXXXX")
+RUNS=${BENCH_RUNS:-3}
+STARTUP_RUNS=${BENCH_STARTUP_RUNS:-200}
+trap 'rm -rf "$WORK"' EXIT
+
+cc -std=c11 -O2 -o "$WORK/gen_sauce" "$BENCH/gen_sauce.c"
+
+now_ns() {
+    date +%s%N
+}
+
+# Extrai um campo numérico do JSON de --stats-json
+json_field() {
+    sed -n "s/.*\"$1\": \([0-9.]*\).*/\1/p" "$2"
+}
+
+# ------------------------------------------------------------
+# 1. Throughput do compilador
+# ------------------------------------------------------------
+echo "===== Compilador: throughput ====="
+printf "%-8s %8s %9s %9s %9s %9s %9s %10s %9s\n" \
+    size lines lex_ms parse_ms anal_ms cgen_ms cc_ms "lines/s" rss_kb
+
+# Limite do compilador para funções e para comandos globais por arquivo
+MAX_FN_DEFS=$(sed -n 's/^#define MAX_FN_DEFS \([0-9]*\).*/\1/p' "$ROOT/compiler.h")
+
+# nome funções globais profundidade cadeia
+for spec in "small 20 20 3 10" "medium 80 80 5 40" "large 120 120 7 150" "xlarge 400 400 5 40"; do
+    set -- $spec
+    name=$1
+    # gen_sauce emite funções + 1 'fn' e globais + funções + 2 comandos globais
+    if [ $(($2 + 1)) -gt "$MAX_FN_DEFS" ] || [ $(($3 + $2 + 2)) -gt "$MAX_FN_DEFS" ]; then
+        echo "tamanho $name acima de MAX_FN_DEFS ($MAX_FN_DEFS)"; exit 1
+    fi
+    "$WORK/gen_sauce" "$2" "$3" "$4" "$5" > "$WORK/$name.sauce"
+    lines=$(wc -l < "$WORK/$name.sauce")
+
+    (cd "$WORK" && "$ROOT/compiler" --stats-json -o "$name.app" "$name.sauce" 2> "$name.log" > /dev/null) || {
+        echo "falha ao compilar $name:"; cat "$WORK/$name.log"; exit 1;
+    }
+    grep '^{' "$WORK/$name.log" > "$WORK/$name.json"
+
+    lex=$(json_field lex "$WORK/$name.json")
+    parse=$(json_field parse "$WORK/$name.json")
+    anal=$(json_field analysis "$WORK/$name.json")
+    cgen=$(json_field codegen "$WORK/$name.json")
+    ccms=$(json_field cc "$WORK/$name.json")
+    rss=$(json_field peak_rss_kb "$WORK/$name.json")
+
+    # Linhas/s do front-end (tudo menos o cc externo)
+    lps=$(awk -v l="$lines" -v a="$lex" -v b="$parse" -v c="$anal" -v d="$cgen" \
+        'BEGIN { t = (a + b + c + d) / 1000; printf "%.0f", (t > 0 ? l / t : 0) }')
+
+    printf "%-8s %8s %9s %9s %9s %9s %9s %10s %9s\n" \
+        "$name" "$lines" "$lex" "$parse" "$anal" "$cgen" "$ccms" "$lps" "$rss"
+done
+
+# ------------------------------------------------------------
+# 2. Kernels de runtime
+# ------------------------------------------------------------
+echo
+echo "===== Runtime: app gerado vs baseline C (melhor de $RUNS) ====="
+printf "%-12s %12s %12s %8s\n" kernel sauce_ms c_ms ratio
+
+# Entradas: primeira linha é o tamanho; hear_heavy lê mais um número por linha
+echo 35 > "$WORK/recursion.in"
+echo 35 > "$WORK/parallel.in"
+echo 50000000 > "$WORK/generator.in"
+echo 50000000 > "$WORK/arithmetic.in"
+echo 1000000 > "$WORK/say_heavy.in"
+echo 2000000 > "$WORK/text_build.in"
+echo 2000000 > "$WORK/text_locals.in"
+awk 'BEGIN { n = 500000; print n; for (i = 0; i < n; i++) print (i * 7) % 1000 }' > "$WORK/hear_heavy.in"
+cp "$WORK/hear_heavy.in" "$WORK/pipeline.in"
+
+best_ms() {
+    exe=$1
+    input=$2
+    best=""
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        start=$(now_ns)
+        "$exe" < "$input" > /dev/null
+        end=$(now_ns)
+        t=$(( (end - start) / 1000 ))
+        if [ -z "$best" ] || [ $t -lt $best ]; then best=$t; fi
+        i=$((i + 1))
+    done
+    awk -v us="$best" 'BEGIN { printf "%.3f", us / 1000 }'
+}
+
+for kernel in recursion parallel arithmetic say_heavy hear_heavy pipeline generator text_build text_locals; do
+    (cd "$WORK" && "$ROOT/compiler" -o "$kernel.app" "$BENCH/kernels/$kernel.sauce" > /dev/null 2>&1) || {
+        echo "falha ao compilar kernel $kernel"; exit 1;
+    }
+    cc -std=c11 -O2 -o "$WORK/$kernel.base" "$BENCH/kernels/$kernel.c"
+
+    s=$(best_ms "$WORK/$kernel.app" "$WORK/$kernel.in")
+    c=$(best_ms "$WORK/$kernel.base" "$WORK/$kernel.in")
+    ratio=$(awk -v s="$s" -v c="$c" 'BEGIN { printf "%.2fx", (c > 0 ? s / c : 0) }')
+    printf "%-12s %12s %12s %8s\n" "$kernel" "$s" "$c" "$ratio"
+done
+
+# ------------------------------------------------------------
+# 3. Inicialização (apps curtos, um processo por pedido)
+# ------------------------------------------------------------
+echo
+echo "===== Inicialização: exec->exit (média de $STARTUP_RUNS) e tamanho ====="
+printf "%-14s %12s %12s\n" build exec_us size_bytes
+
+echo 21 > "$WORK/startup.in"
+
+# Média em µs; inclui o fork do shell, igual para todas as linhas
+mean_us() {
+    exe=$1
+    start=$(now_ns)
+    i=0
+    while [ $i -lt "$STARTUP_RUNS" ]; do
+        "$exe" < "$WORK/startup.in" > /dev/null
+        i=$((i + 1))
+    done
+    end=$(now_ns)
+    awk -v ns=$((end - start)) -v n="$STARTUP_RUNS" 'BEGIN { printf "%.1f", ns / n / 1000 }'
+}
+
+(cd "$WORK" && "$ROOT/compiler" -o startup.app "$BENCH/kernels/startup.sauce" > /dev/null 2>&1 &&
+    "$ROOT/compiler" --static -o startup.static "$BENCH/kernels/startup.sauce" > /dev/null 2>&1) || {
+    echo "falha ao compilar startup"; exit 1;
+}
+cc -std=c11 -O2 -o "$WORK/startup.base" "$BENCH/kernels/startup.c"
+
+for build in app static base; do
+    exe="$WORK/startup.$build"
+    case $build in
+        app) label="sauce" ;;
+        static) label="sauce --static" ;;
+        base) label="c" ;;
+    esac
+    printf "%-14s %12s %12s\n" "$label" "$(mean_us "$exe")" "$(wc -c < "$exe" | tr -d ' ')"
+done
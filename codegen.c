@@ -11,6 +11,20 @@ extern Node *global_stmts[];
 extern int globalStmtCount;
 
 static FILE *outf = NULL;
+static int in_bench_body = 0; // Gerando o corpo de um bloco 'bench'
+static int unit_linkage = 0;  // Gerando uma unidade do build por função (ligação externa)
+static Node *unit_fn = NULL;  // Função da unidade atual (NULL: unidade das globais e do main)
+static Node *gen_current = NULL; // Gerando o 'next' deste gerador (locais içados para o estado)
+static int gen_yields = 0;       // Pontos de retomada já emitidos em gen_current
+
+// '#line' (-g): linhas do C sem origem no .sauce voltam a apontar para o próprio arquivo C
+static char out_name[1024];   // Nome final do arquivo C (sem o sufixo .tmp)
+static const char *out_path = NULL;
+static long out_scanned = 0;  // Bytes já contados
+static int out_lines = 0;     // Quebras de linha em [0, out_scanned)
+
+// Opções de geração (preenchidas pelo driver antes de parse_all)
+CodegenOptions cg_options = {0};
 
 // --- Estruturas de Suporte para Semantic Analysis ---
 typedef struct {
@@ -18,23 +32,46 @@ typedef struct {
     char type[MAX_TOKEN_LEN];
 } Symbol;
 
-#define MAX_SYMBOLS 512
+#define MAX_SYMBOLS MAX_FN_DEFS // Cabe toda global: elas vêm dos comandos globais
 Symbol global_symbols[MAX_SYMBOLS];
 int globalSymbolCount = 0;
 
 
 // --- Prototipos Internos ---
-static const char *sauce_type_to_c(const char *sauce_type);
 static const char *lookup_variable_type(const char *name, Node *fn_def);
 static Node *find_function_def(const char *name);
-static const char *get_expr_type(Node *expr, Node *fn_context);
 static const char *recursive_find_return_type(Node *block_list, Node *fn_context);
 static void infer_function_return_type(Node *fn_def);
 static int ends_with_return(Node *block_list);
+static int is_self_tail_call(Node *ret, Node *fn_def);
+static int has_self_tail_call(Node *block, Node *fn_def);
 
+static const char *task_result_type(Node *join, Node *fn_def);
+static const char *chan_value_suffix(const char *chan, Node *fn_def);
+static const char *generator_type(Node *fn);
+static void check_thread_args(Node *fn, const char *what);
+static int is_text_type(const char *sauce_type);
+static int is_gen_decl(Node *decl);
+static int arena_temps_in(Node *fn_def);
+static int is_fresh_text_call(Node *n);
+static void gen_bench_sink(const char *value);
+static void mark_fresh_text_results();
+static void gen_arena_value(Node *expr, Node *fn_def);
+static int is_text_concat(Node *n, Node *fn_def);
+static int has_text_buf(const char *name, Node *fn_def);
+static int is_self_append(Node *expr, const char *name, Node *fn_def);
+static void gen_text_append(const char *name, Node *expr, Node *fn_def);
+static void gen_text_buf_drop(const char *name, Node *value, Node *fn_def);
+static void gen_line_directive(Node *n);
+static void gen_line_reset();
 static void gen_expr(Node *n, Node *fn_context);
 static void gen_statement(Node *n, Node *fn_def);
 static void gen_fn_definition(Node *n);
+static void gen_memo_wrapper(Node *n);
+static const char *fn_c_linkage(Node *fn_def);
+static const char *fn_c_attributes(Node *fn_def);
+static int profiled_branch_index(Node *n);
+static void gen_prototypes();
 
 static const char* get_c_fn_name(const char *sauce_name) {
     if (strcmp(sauce_name, "main") == 0) {
@@ -54,10 +91,14 @@ const char *sauce_type_to_c(const char *sauce_type) {
     if (strcmp(sauce_type, "float") == 0) return "double";
     if (strcmp(sauce_type, "string") == 0 || strcmp(sauce_type, "text") == 0) return "char*";
     if (strcmp(sauce_type, "bool") == 0 || strcmp(sauce_type, "boolean") == 0) return "int"; // Usando int (0/1) para simplicidade C
+    if (strcmp(sauce_type, "task") == 0) return "_sauce_task*"; // Ver runtime/sauce_rt.h
+    if (strncmp(sauce_type, "chan<", 5) == 0) return "_sauce_chan*"; // Ver runtime/sauce_rt.h
+    if (strncmp(sauce_type, "gen<", 4) == 0) return "_sauce_gen*";   // Ver runtime/sauce_rt.h
     return "void";
 }
 
 Node *find_function_def(const char *name) {
+    stats.symbol_lookups++;
     for (int i = 0; i < fnDefCount; i++) {
         if (strcmp(fn_defs[i]->name, name) == 0) {
             return fn_defs[i];
@@ -66,7 +107,21 @@ Node *find_function_def(const char *name) {
     return NULL;
 }
 
+static Node *find_local_decl(Node *n, const char *name) {
+    if (!n) return NULL;
+    if (n->kind == N_VAR_DECL && strcmp(n->name, name) == 0) return n;
+    if (n->kind == N_STMT_LIST || n->kind == N_IF) {
+        Node *found = find_local_decl(n->left, name);
+        if (!found) found = find_local_decl(n->right, name);
+        if (!found) found = find_local_decl(n->mid, name);
+        return found;
+    }
+    return NULL;
+}
+
 const char *lookup_variable_type(const char *name, Node *fn_def) {
+    stats.symbol_lookups++;
+
     // 1. Verificar escopo da função (parâmetros)
     if (fn_def != NULL) {
         Node *param_wrapper = fn_def->left;
@@ -77,6 +132,12 @@ const char *lookup_variable_type(const char *name, Node *fn_def) {
             }
             param_wrapper = param_wrapper->right;
         }
+
+        // 1.1 Declarações locais no corpo da função (incluindo blocos de if/else)
+        Node *local = find_local_decl(fn_def->mid, name);
+        if (local) {
+            return local->typeName;
+        }
     }
 
     // 2. Verificar escopo global (símbolos já registrados)
@@ -129,12 +190,19 @@ const char *get_expr_type(Node *expr, Node *fn_context) {
                 fprintf(stderr, "Erro Semântico: Função '%s' não definida.\n", expr->name);
                 exit(1);
             }
+            // Chamar um gerador cria o estado: o valor é o gen<T>, não um T
+            if (fn_def->flags & NODE_FLAG_GENERATOR) return generator_type(fn_def);
             return fn_def->typeName;
         }
 
         case N_ADD: case N_SUB: case N_MUL: case N_DIV: {
             const char *left_type = get_expr_type(expr->left, fn_context);
             const char *right_type = get_expr_type(expr->right, fn_context);
+            // text + text/int/float concatena (ver gen_concat)
+            if (expr->kind == N_ADD && (is_text_type(left_type) || is_text_type(right_type))) {
+                const char *other = is_text_type(left_type) ? right_type : left_type;
+                if (is_text_type(other) || strcmp(other, "int") == 0 || strcmp(other, "float") == 0) return "text";
+            }
             if (strcmp(left_type, "float") == 0 || strcmp(right_type, "float") == 0) return "float";
             if (strcmp(left_type, "int") == 0 && strcmp(right_type, "int") == 0) return "int";
             
@@ -145,6 +213,15 @@ const char *get_expr_type(Node *expr, Node *fn_context) {
         case N_GTE: case N_LTE: 
         case N_AND: case N_OR: case N_NOT: 
             return "boolean";
+
+        case N_SPAWN:
+            return "task";
+        case N_JOIN:
+            return task_result_type(expr, fn_context);
+        case N_RECV:
+            return "boolean"; // false: canal fechado e vazio
+        case N_NEXT:
+            return "boolean"; // false: gerador terminou
             
         default:
             return "void";
@@ -176,9 +253,21 @@ const char *recursive_find_return_type(Node *block_list, Node *fn_context) {
     return "void";
 }
 
+static Node *find_first_yield(Node *n) {
+    if (!n) return NULL;
+    if (n->kind == N_YIELD) return n;
+    Node *found = find_first_yield(n->left);
+    if (!found) found = find_first_yield(n->right);
+    if (!found) found = find_first_yield(n->mid);
+    return found;
+}
+
 void infer_function_return_type(Node *fn_def) {
     if (fn_def->typeName[0] == '\0' || strcmp(fn_def->typeName, "void") == 0) {
-        const char *inferred_type = recursive_find_return_type(fn_def->mid, fn_def);
+        // Gerador: o tipo é o dos valores produzidos (os 'return' só encerram)
+        const char *inferred_type = (fn_def->flags & NODE_FLAG_GENERATOR)
+            ? get_expr_type(find_first_yield(fn_def->mid)->left, fn_def)
+            : recursive_find_return_type(fn_def->mid, fn_def);
         if (inferred_type != NULL && strcmp(inferred_type, "void") != 0) {
             strncpy(fn_def->typeName, inferred_type, MAX_TOKEN_LEN-1);
             fn_def->typeName[MAX_TOKEN_LEN-1] = '\0';
@@ -211,256 +300,1992 @@ static int ends_with_return(Node *block_list) {
 }
 
 // ------------------------------------------
-// --- Code Generation Core ---
+// --- Eliminação de Chamada de Cauda (TCO) ---
 // ------------------------------------------
 
-static void gen_expr(Node *n, Node *fn_context) {
-    if (!n) return;
-
-    switch (n->kind) {
-        case N_INT:
-        case N_FLOAT:
-            fprintf(outf, "%s", n->text);
-            break;
-            
-        case N_STRING:
-            // Garante que a string C literal seja impressa com aspas duplas.
-            fprintf(outf, "\"%s\"", n->text);
-            break;
-
-        case N_BOOL:
-            // Booleanos mapeiam para 1 e 0 (tipo int em C)
-            fprintf(outf, "%s", strcmp(n->text, "true") == 0 ? "1" : "0");
-            break;
+// Um 'return f(...)' dentro da própria 'f' vira reatribuição de parâmetros + goto,
+// garantindo pilha constante mesmo em -O0 (Sauce não tem laços, só recursão).
+static int is_self_tail_call(Node *ret, Node *fn_def) {
+    if (!ret || !fn_def || ret->kind != N_RETURN) return 0;
+    Node *call = ret->left;
+    return call && call->kind == N_FN_CALL && strcmp(call->name, fn_def->name) == 0;
+}
 
-        case N_VAR:
-            fprintf(outf, "%s", n->name);
-            break;
+// Procura recursivamente (incluindo blocos then/else e cadeias else-if)
+static int has_self_tail_call(Node *block, Node *fn_def) {
+    if (!block) return 0;
 
-        case N_FN_CALL:
-            fprintf(outf, "%s(", get_c_fn_name(n->name));
-            Node *arg_wrapper = n->left;
-            while (arg_wrapper) {
-                gen_expr(arg_wrapper->left, fn_context); 
-                arg_wrapper = arg_wrapper->right;
-                if (arg_wrapper) {
-                    fprintf(outf, ", ");
-                }
-            }
-            fprintf(outf, ")");
-            break;
-        
-        case N_AND:
-        case N_OR:
-        case N_NOT:
-        case N_ADD: case N_SUB: case N_MUL: case N_DIV: 
-        case N_GT: case N_EQ_CMP: case N_LT: case N_NEQ: 
-        case N_GTE: case N_LTE: 
-        
-            if (n->kind == N_NOT) {
-                fprintf(outf, "(!");
-                gen_expr(n->left, fn_context);
-                fprintf(outf, ")");
-                break;
-            }
+    // Cadeia else-if: o 'mid' de um N_IF pode ser outro N_IF diretamente
+    if (block->kind == N_IF) {
+        return has_self_tail_call(block->right, fn_def) || has_self_tail_call(block->mid, fn_def);
+    }
 
-            fprintf(outf, "("); 
-            gen_expr(n->left, fn_context); 
-            
-            if (n->kind == N_AND) fprintf(outf, " && "); 
-            else if (n->kind == N_OR) fprintf(outf, " || "); 
-            else if (n->kind == N_ADD) fprintf(outf, " + ");
-            else if (n->kind == N_SUB) fprintf(outf, " - ");
-            else if (n->kind == N_MUL) fprintf(outf, " * ");
-            else if (n->kind == N_DIV) fprintf(outf, " / ");
-            else if (n->kind == N_GT) fprintf(outf, " > ");
-            else if (n->kind == N_LT) fprintf(outf, " < ");
-            else if (n->kind == N_EQ_CMP) fprintf(outf, " == ");
-            else if (n->kind == N_NEQ) fprintf(outf, " != ");
-            else if (n->kind == N_GTE) fprintf(outf, " >= ");
-            else if (n->kind == N_LTE) fprintf(outf, " <= ");
-            
-            gen_expr(n->right, fn_context); 
-            fprintf(outf, ")"); 
-            break;
-            
-        default:
-            fprintf(stderr, "Erro Interno: Expressão de nó desconhecida: %d\n", n->kind);
-            exit(1);
+    Node *stmt_wrapper = block;
+    while (stmt_wrapper) {
+        Node *stmt = stmt_wrapper->left;
+        if (stmt) {
+            if (is_self_tail_call(stmt, fn_def)) return 1;
+            if (stmt->kind == N_IF && has_self_tail_call(stmt, fn_def)) return 1;
+        }
+        stmt_wrapper = stmt_wrapper->right;
     }
+    return 0;
 }
 
-static void gen_statement(Node *n, Node *fn_def) {
-    if (!n) return;
+static void gen_self_tail_call(Node *n, Node *fn_def) {
+    Node *call = n->left;
 
-    switch (n->kind) {
-        case N_VAR_DECL: {
-            // Este caso só deve ocorrer para declarações LOCAIS.
-            const char *c_type = sauce_type_to_c(n->typeName);
-            
-            fprintf(outf, "    %s %s", c_type, n->name);
-            
-            if (n->left) {
-                fprintf(outf, " = ");
-                gen_expr(n->left, fn_def);
-            } else if (strcmp(c_type, "char*") == 0) {
-                 fprintf(outf, " = NULL"); // Inicialização segura para ponteiro
-            } else {
-                 fprintf(outf, " = 0"); // Inicialização segura para números/booleanos
-            }
-            
-            fprintf(outf, ";\n");
-            break;
+    // 1. Avalia todos os argumentos em temporários (antes de sobrescrever qualquer parâmetro)
+    fprintf(outf, "    {\n");
+    int idx = 0;
+    Node *param_wrapper = fn_def->left;
+    Node *arg_wrapper = call->left;
+    while (param_wrapper && arg_wrapper) {
+        Node *param = param_wrapper->left;
+        fprintf(outf, "    %s _tco%d = ", sauce_type_to_c(param->typeName), idx++);
+        if (has_text_buf(param->name, fn_def) && is_self_append(arg_wrapper->left, param->name, fn_def)) {
+            gen_text_append(param->name, arg_wrapper->left, fn_def); // 'p + ...' cresce o próprio p
+        } else {
+            gen_expr(arg_wrapper->left, fn_def);
         }
-        
-        case N_VAR_ASSIGN: {
-            const char *sauce_type = lookup_variable_type(n->name, fn_def);
-            if (!sauce_type) {
-                fprintf(stderr, "Erro de Geração: Variável '%s' não encontrada para atribuição.\n", n->name);
-                exit(1);
-            }
+        fprintf(outf, ";\n");
+        param_wrapper = param_wrapper->right;
+        arg_wrapper = arg_wrapper->right;
+    }
+    if (param_wrapper || arg_wrapper) {
+        fprintf(stderr, "Erro Semântico: Número de argumentos incorreto na chamada recursiva de '%s'.\n", fn_def->name);
+        exit(1);
+    }
 
-            if (strcmp(sauce_type, "text") == 0 || strcmp(sauce_type, "string") == 0) {
-                // Atribuição de string: libera a string antiga e copia a nova
-                fprintf(outf, "    if (%s != NULL) free(%s);\n", n->name, n->name);
-                fprintf(outf, "    %s = strdup(", n->left->kind == N_STRING ? n->name : n->name);
-                gen_expr(n->left, fn_def); 
-                fprintf(outf, ");\n");
-            } else {
-                // Atribuição simples
-                fprintf(outf, "    %s = ", n->name);
-                gen_expr(n->left, fn_def);
-                fprintf(outf, ";\n");
-            }
-            break;
+    // 2. Reatribui os parâmetros e volta para a entrada da função
+    idx = 0;
+    param_wrapper = fn_def->left;
+    arg_wrapper = call->left;
+    while (param_wrapper) {
+        const char *name = param_wrapper->left->name;
+        fprintf(outf, "    %s = _tco%d;\n", name, idx++);
+        // Outro valor no lugar do buffer: ele é liberado e a próxima concatenação recomeça do zero
+        Node *arg = arg_wrapper->left;
+        if (!(arg->kind == N_VAR && strcmp(arg->name, name) == 0) && !is_self_append(arg, name, fn_def)) {
+            gen_text_buf_drop(name, arg, fn_def);
         }
+        param_wrapper = param_wrapper->right;
+        arg_wrapper = arg_wrapper->right;
+    }
+    fprintf(outf, "    goto _tco_entry;\n");
+    fprintf(outf, "    }\n");
+}
 
-        case N_SAY: {
-            Node *expr = n->left;
-            const char *type = get_expr_type(expr, fn_def);
-            
-            // *** CORREÇÃO CRÍTICA: Trata a saída de booleanos para imprimir "true" ou "false" ***
-            if (strcmp(type, "boolean") == 0) {
-                // Se for booleano, usa o operador ternário para imprimir a string "true" ou "false"
-                fprintf(outf, "    printf(\"%%s\\n\", (");
-                gen_expr(expr, fn_def); 
-                fprintf(outf, ") ? \"true\" : \"false\");\n");
-            } 
-            else {
-                // Para todos os outros tipos
-                fprintf(outf, "    printf(");
-                
-                if (strcmp(type, "int") == 0) {
-                    fprintf(outf, "\"%%d\\n\", ");
-                } else if (strcmp(type, "float") == 0) {
-                    fprintf(outf, "\"%%f\\n\", ");
-                } else if (strcmp(type, "text") == 0 || strcmp(type, "string") == 0) {
-                    fprintf(outf, "\"%%s\\n\", ");
-                } else {
-                    // Caso fallback
-                    fprintf(outf, "\"Erro: Tipo desconhecido (SAID) para saida.\\n\"");
-                    fprintf(outf, ");\n");
-                    break;
-                }
-                
-                gen_expr(expr, fn_def);
-                fprintf(outf, ");\n");
-            }
-            break;
-        }
-        
-        case N_HEAR: {
-            const char *var_name = n->left->name;
-            const char *sauce_type = lookup_variable_type(var_name, fn_def);
-            const char *c_type = sauce_type_to_c(sauce_type);
-            
-            fprintf(outf, "    printf(\"\\n> \");\n");
-            
-            if (strcmp(c_type, "int") == 0) {
-                fprintf(outf, "    if (scanf(\"%%d\", &%s) != 1) { /* erro na leitura de int */ } \n", var_name);
-                // Limpa o buffer após leitura numérica
-                fprintf(outf, "    { int _c; while((_c = getchar()) != '\\n' && _c != EOF); }\n");
-            } else if (strcmp(c_type, "double") == 0) {
-                fprintf(outf, "    if (scanf(\"%%lf\", &%s) != 1) { /* erro na leitura de double */ } \n", var_name);
-                // Limpa o buffer após leitura numérica
-                fprintf(outf, "    { int _c; while((_c = getchar()) != '\\n' && _c != EOF); }\n");
-            } else if (strcmp(c_type, "char*") == 0) {
-                // 1. Limpa espaços e newlines de entradas ANTERIORES
-                fprintf(outf, "    { int _c; do { _c = getchar(); } while (_c != EOF && isspace(_c)); if (_c != EOF) ungetc(_c, stdin); }\n");
-                
-                // 2. Lê a linha toda com fgets, aloca e atribui
-                fprintf(outf, "    { char _buf[1024]; if (!fgets(_buf, sizeof(_buf), stdin)) _buf[0]='\\0'; _buf[strcspn(_buf, \"\\n\")]='\\0'; if (%s != NULL) free(%s); %s = strdup(_buf); }\n", var_name, var_name, var_name);
-            } else {
-                fprintf(outf, "    // Tipo '%s' nao suporta HEAR.\n", sauce_type);
-            }
-            break;
-        }
-        
-        case N_IF: {
-            fprintf(outf, "    if (");
-            gen_expr(n->left, fn_def); 
-            fprintf(outf, ") {\n");
-            
-            Node *body_stmt = n->right;
-            while (body_stmt) {
-                gen_statement(body_stmt->left, fn_def);
-                body_stmt = body_stmt->right;
-            }
-            
-            fprintf(outf, "    }");
-            
-            if (n->mid) {
-                fprintf(outf, " else ");
-                if (n->mid->kind == N_IF) {
-                    // else if (Recursão)
-                    gen_statement(n->mid, fn_def);
-                } else {
-                    fprintf(outf, "{\n");
-                    Node *else_stmt = n->mid;
-                    while (else_stmt) {
-                        gen_statement(else_stmt->left, fn_def);
-                        else_stmt = else_stmt->right;
-                    }
-                    fprintf(outf, "    }");
-                }
-            }
-            fprintf(outf, "\n");
-            break;
+// ------------------------------------------
+// --- Tarefas (spawn/join) ---
+// ------------------------------------------
+
+// 't[task] = spawn f(args)' publica f(args) no pool de threads e 'join(t)' espera o
+// resultado. O tipo do join vem da função do spawn que inicializa a declaração.
+// Declaração visível de 'name': parâmetro, local ou global
+static Node *find_var_decl(const char *name, Node *fn_def) {
+    if (fn_def) {
+        for (Node *p = fn_def->left; p; p = p->right) {
+            if (strcmp(p->left->name, name) == 0) return p->left;
         }
+        Node *local = find_local_decl(fn_def->mid, name);
+        if (local) return local;
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind == N_VAR_DECL && strcmp(stmt->name, name) == 0) return stmt;
+    }
+    return NULL;
+}
 
-        case N_RETURN:
-            fprintf(outf, "    return ");
-            
-            if (n->explicitReturnType[0] != '\0') {
-                const char *c_type = sauce_type_to_c(n->explicitReturnType);
-                fprintf(outf, "(%s)", c_type);
-            }
-            
-            gen_expr(n->left, fn_def);
-            fprintf(outf, ";\n");
-            break;
+static Node *spawned_function(Node *spawn) {
+    Node *callee = find_function_def(spawn->left->name);
+    if (!callee) {
+        fprintf(stderr, "Erro Semântico: 'spawn %s': função não definida.\n", spawn->left->name);
+        exit(1);
+    }
+    return callee;
+}
 
-        case N_EXPR_STMT:
-            fprintf(outf, "    ");
-            gen_expr(n->left, fn_def);
-            fprintf(outf, ";\n");
-            break;
-            
-        default:
-            fprintf(stderr, "Erro Interno: Comando de nó desconhecido para geração: %d\n", n->kind);
-            exit(1);
+static const char *task_result_type(Node *join, Node *fn_def) {
+    const char *name = join->left->name;
+    Node *decl = find_var_decl(name, fn_def);
+    if (!decl || strcmp(decl->typeName, "task") != 0 || !decl->left || decl->left->kind != N_SPAWN) {
+        fprintf(stderr, "Erro Semântico: join(%s): '%s' precisa ser declarada como '%s[task] = spawn f(...)'.\n",
+                name, name, name);
+        exit(1);
     }
+    return spawned_function(decl->left)->typeName;
 }
 
-static void gen_fn_definition(Node *n) {
-    const char *return_type = sauce_type_to_c(n->typeName);
-    const char *fn_name_c = get_c_fn_name(n->name); 
+// Uma task só recebe spawn (cópias de handle causariam join duplo) e spawn só vai
+// para tasks. Reatribuições precisam manter o tipo de resultado da declaração.
+static void check_task_value(const char *name, const char *type, Node *expr, Node *fn_def) {
+    int is_task = type && strcmp(type, "task") == 0;
+    int is_spawn = expr && expr->kind == N_SPAWN;
+    if (is_task && expr && !is_spawn) {
+        fprintf(stderr, "Erro Semântico: task '%s' só pode receber 'spawn f(...)'.\n", name);
+        exit(1);
+    }
+    if (!is_task && is_spawn) {
+        fprintf(stderr, "Erro Semântico: 'spawn' só inicializa variáveis task ('%s' é %s).\n", name, type ? type : "?");
+        exit(1);
+    }
+    if (!is_spawn) return;
 
-    fprintf(outf, "\n%s %s(", return_type, fn_name_c);
+    Node *decl = find_var_decl(name, fn_def);
+    if (decl && decl->left && decl->left != expr && decl->left->kind == N_SPAWN &&
+        strcmp(sauce_type_to_c(spawned_function(decl->left)->typeName),
+               sauce_type_to_c(spawned_function(expr)->typeName)) != 0) {
+        fprintf(stderr, "Erro Semântico: task '%s' recebe '%s', que devolve um tipo diferente do spawn da declaração.\n",
+                name, expr->left->name);
+        exit(1);
+    }
+}
 
-    Node *param_wrapper = n->left;
-    while (param_wrapper) {
-        Node *param = param_wrapper->left;
+// Pool de trabalho (runtime/rt_task.c) e canais/estágios (runtime/rt_chan.c) vêm
+// de libsauce_rt.a; aqui só os wrappers de spawn/stage e as chamadas tipadas.
+
+// Sufixo dos helpers tipados (_sauce_send_int, ...) a partir do 'chan<T>' declarado
+static const char *chan_value_suffix(const char *chan, Node *fn_def) {
+    const char *type = lookup_variable_type(chan, fn_def);
+    if (!type || strncmp(type, "chan<", 5) != 0) {
+        fprintf(stderr, "Erro Semântico: '%s' não é um canal.\n", chan);
+        exit(1);
+    }
+    if (strncmp(type + 5, "float", 5) == 0) return "float";
+    if (strncmp(type + 5, "text", 4) == 0 || strncmp(type + 5, "string", 6) == 0) return "text";
+    return "int"; // int e boolean
+}
+
+// spawned[i]: bit 1 = usada em spawn, bit 2 = usada em stage
+static void mark_spawned(Node *n, char *spawned) {
+    if (!n) return;
+    if (n->kind == N_SPAWN || n->kind == N_STAGE) {
+        for (int i = 0; i < fnDefCount; i++) {
+            if (strcmp(fn_defs[i]->name, n->left->name) == 0) spawned[i] |= n->kind == N_SPAWN ? 1 : 2;
+        }
+    }
+    mark_spawned(n->left, spawned);
+    mark_spawned(n->mid, spawned);
+    mark_spawned(n->right, spawned);
+}
+
+// Por função usada em spawn: struct com os argumentos, 'run' (executa no trabalhador)
+// e o construtor chamado no ponto do spawn. Argumentos text são copiados: a tarefa
+// pode rodar depois que o chamador liberou ou reatribuiu a string.
+static void gen_spawn_wrapper(Node *fn) {
+    check_thread_args(fn, "spawn");
+    const char *name = get_c_fn_name(fn->name);
+    const char *ret = sauce_type_to_c(fn->typeName);
+    int idx;
+    Node *p;
+
+    fprintf(outf, "typedef struct { _sauce_task base;");
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        fprintf(outf, " %s a%d;", sauce_type_to_c(p->left->typeName), idx);
+    }
+    fprintf(outf, " } _sauce_spawn_%s_t;\n", name);
+
+    fprintf(outf, "static void _sauce_spawn_%s_run(_sauce_task *t) {\n", name);
+    fprintf(outf, "    _sauce_spawn_%s_t *s = (_sauce_spawn_%s_t *)t;\n", name, name);
+    fprintf(outf, "    ");
+    if (strcmp(ret, "int") == 0) fprintf(outf, "t->result.i = ");
+    else if (strcmp(ret, "double") == 0) fprintf(outf, "t->result.f = ");
+    else if (strcmp(ret, "char*") == 0) fprintf(outf, "t->result.s = ");
+    fprintf(outf, "%s(", name);
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        fprintf(outf, "%ss->a%d", idx ? ", " : "", idx);
+    }
+    fprintf(outf, ");\n");
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        if (strcmp(sauce_type_to_c(p->left->typeName), "char*") != 0) continue;
+        // O resultado pode ser o próprio argumento
+        if (strcmp(ret, "char*") == 0) fprintf(outf, "    if (t->result.s != s->a%d) _sauce_text_free(s->a%d);\n", idx, idx);
+        else fprintf(outf, "    _sauce_text_free(s->a%d);\n", idx);
+    }
+    fprintf(outf, "}\n");
+
+    fprintf(outf, "static _sauce_task *_sauce_spawn_%s(", name);
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        fprintf(outf, "%s%s a%d", idx ? ", " : "", sauce_type_to_c(p->left->typeName), idx);
+    }
+    if (!fn->left) fprintf(outf, "void");
+    fprintf(outf, ") {\n");
+    fprintf(outf, "    _sauce_spawn_%s_t *s = malloc(sizeof *s);\n", name);
+    fprintf(outf, "    if (SAUCE_UNLIKELY(!s)) { perror(\"malloc\"); exit(1); }\n");
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        if (strcmp(sauce_type_to_c(p->left->typeName), "char*") == 0) {
+            fprintf(outf, "    s->a%d = _sauce_text_dup(a%d);\n", idx, idx);
+        } else {
+            fprintf(outf, "    s->a%d = a%d;\n", idx, idx);
+        }
+    }
+    fprintf(outf, "    _sauce_task_submit(&s->base, _sauce_spawn_%s_run);\n", name);
+    fprintf(outf, "    return &s->base;\n");
+    fprintf(outf, "}\n");
+}
+
+// Estágio: mesma struct de argumentos, mas a função roda numa thread própria e o
+// resultado é descartado (estágios se comunicam por canais)
+static void gen_stage_wrapper(Node *fn) {
+    check_thread_args(fn, "stage");
+    const char *name = get_c_fn_name(fn->name);
+    int idx;
+    Node *p;
+
+    fprintf(outf, "typedef struct {");
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        fprintf(outf, " %s a%d;", sauce_type_to_c(p->left->typeName), idx);
+    }
+    fprintf(outf, " char _unused; } _sauce_stage_%s_t;\n", name);
+
+    fprintf(outf, "static void *_sauce_stage_%s_run(void *arg) {\n", name);
+    fprintf(outf, "    _sauce_stage_%s_t *s = arg;\n", name);
+    fprintf(outf, "    %s%s(", strcmp(sauce_type_to_c(fn->typeName), "void") != 0 ? "(void)" : "", name);
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        fprintf(outf, "%ss->a%d", idx ? ", " : "", idx);
+    }
+    fprintf(outf, ");\n");
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        if (strcmp(sauce_type_to_c(p->left->typeName), "char*") == 0) fprintf(outf, "    _sauce_text_free(s->a%d);\n", idx);
+    }
+    fprintf(outf, "    free(s);\n");
+    fprintf(outf, "    return NULL;\n");
+    fprintf(outf, "}\n");
+
+    fprintf(outf, "static void _sauce_stage_%s(", name);
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        fprintf(outf, "%s%s a%d", idx ? ", " : "", sauce_type_to_c(p->left->typeName), idx);
+    }
+    if (!fn->left) fprintf(outf, "void");
+    fprintf(outf, ") {\n");
+    fprintf(outf, "    _sauce_stage_%s_t *s = malloc(sizeof *s);\n", name);
+    fprintf(outf, "    if (SAUCE_UNLIKELY(!s)) { perror(\"malloc\"); exit(1); }\n");
+    for (p = fn->left, idx = 0; p; p = p->right, idx++) {
+        if (strcmp(sauce_type_to_c(p->left->typeName), "char*") == 0) {
+            fprintf(outf, "    s->a%d = _sauce_text_dup(a%d);\n", idx, idx);
+        } else {
+            fprintf(outf, "    s->a%d = a%d;\n", idx, idx);
+        }
+    }
+    fprintf(outf, "    _sauce_stage_start(_sauce_stage_%s_run, s);\n", name);
+    fprintf(outf, "}\n");
+}
+
+// Emite os wrappers das funções usadas em spawn/stage nas raízes dadas (depois dos protótipos)
+static void gen_spawn_wrappers(Node **roots, int count) {
+    char spawned[MAX_FN_DEFS] = {0};
+    for (int i = 0; i < count; i++) mark_spawned(roots[i], spawned);
+    int any = 0;
+    for (int i = 0; i < fnDefCount; i++) {
+        if (spawned[i] & 1) gen_spawn_wrapper(fn_defs[i]);
+        if (spawned[i] & 2) gen_stage_wrapper(fn_defs[i]);
+        if (spawned[i]) any = 1;
+    }
+    if (any) fprintf(outf, "\n");
+}
+
+// ------------------------------------------
+// --- Text: cabeçalho, literais internados e concatenação ---
+// ------------------------------------------
+
+// Todo valor text aponta para os bytes logo depois de um cabeçalho com tamanho e
+// hash (FNV-1a): literais são objetos estáticos internados (um por texto distinto),
+// e cópias, hear, canais e concatenações alocam pelo runtime. A igualdade testa o
+// ponteiro, depois tamanho e hash, e só então compara os bytes. NULL (text não
+// inicializado) vale como o text vazio. 'kind' diz de onde veio a memória: só o
+// que saiu do malloc é liberado (literais e valores do arena nunca).
+// O runtime (cabeçalho e helpers inline) está em runtime/sauce_rt.h.
+
+// --- Literais internados: um objeto estático com cabeçalho por texto distinto ---
+static const char **text_literals = NULL;
+static int textLiteralCount = 0, textLiteralCap = 0;
+
+static int text_literal_index(const char *text) {
+    for (int i = 0; i < textLiteralCount; i++) {
+        if (strcmp(text_literals[i], text) == 0) return i;
+    }
+    return -1;
+}
+
+static void collect_text_literals(Node *n) {
+    if (!n) return;
+    if (n->kind == N_STRING && text_literal_index(n->text) < 0) {
+        if (textLiteralCount == textLiteralCap) {
+            textLiteralCap = textLiteralCap ? textLiteralCap * 2 : 64;
+            text_literals = realloc(text_literals, sizeof(char *) * textLiteralCap);
+            if (!text_literals) { perror("realloc"); exit(1); }
+        }
+        text_literals[textLiteralCount++] = n->text;
+    }
+    collect_text_literals(n->left);
+    collect_text_literals(n->mid);
+    collect_text_literals(n->right);
+}
+
+static unsigned long long text_hash(const char *s);
+
+// O hash é calculado aqui; com sequências de escape fica 0 (desconhecido) em vez de
+// reimplementar a interpretação do compilador C
+static void gen_text_literals() {
+    for (int i = 0; i < textLiteralCount; i++) {
+        const char *t = text_literals[i];
+        fprintf(outf, "static const struct { _sauce_text_hdr hdr; char s[sizeof(\"%s\")]; } _sauce_lit%d __attribute__((unused)) = "
+                "{{0x%llxULL, sizeof(\"%s\") - 1, SAUCE_TEXT_STATIC}, \"%s\"};\n", t, i, strchr(t, '\\') ? 0ULL : text_hash(t), t, t);
+    }
+    if (textLiteralCount) fprintf(outf, "\n");
+}
+
+// --- Concatenação ---
+
+// Uma cadeia 'a + b + 1 + ...' vira uma só chamada: soma os tamanhos dos cabeçalhos,
+// aloca uma vez e copia (números são formatados na pilha, como no say).
+// 's = s + ...' (e 'return f(s + ...)' na TCO) sobre um local/parâmetro que não
+// escapa cresce s no lugar com capacidade dobrada: concatenações repetidas
+// custam O(n) no total em vez de realocar e copiar tudo a cada passo.
+#define CONCAT_MAX_PARTS 64
+
+static int is_text_concat(Node *n, Node *fn_def) {
+    return n && n->kind == N_ADD && is_text_type(get_expr_type(n, fn_def));
+}
+
+static int uses_text_concat(Node *n, Node *fn_def) {
+    if (!n) return 0;
+    if (is_text_concat(n, fn_def)) return 1;
+    return uses_text_concat(n->left, fn_def) || uses_text_concat(n->mid, fn_def) || uses_text_concat(n->right, fn_def);
+}
+
+// Achata a cadeia (associativa à esquerda) nos seus pedaços, em ordem
+static int concat_parts(Node *n, Node *fn_def, Node **parts, int count) {
+    if (is_text_concat(n, fn_def) && count + 2 <= CONCAT_MAX_PARTS) {
+        count = concat_parts(n->left, fn_def, parts, count);
+        return concat_parts(n->right, fn_def, parts, count);
+    }
+    parts[count] = n;
+    return count + 1;
+}
+
+// "count, (const char *[]){...}": text direto, números formatados na pilha
+static void gen_concat_args(Node **parts, int count, Node *fn_def) {
+    fprintf(outf, "%d, (const char *[]){", count);
+    for (int i = 0; i < count; i++) {
+        const char *type = get_expr_type(parts[i], fn_def);
+        if (strcmp(type, "int") == 0) fprintf(outf, "_sauce_text_int(&(_sauce_text_intbuf){.hdr = {0, 0}}, ");
+        else if (strcmp(type, "float") == 0) fprintf(outf, "_sauce_text_float(&(_sauce_text_floatbuf){.hdr = {0, 0}}, ");
+        gen_expr(parts[i], fn_def);
+        if (!is_text_type(type)) fprintf(outf, ")");
+        if (i + 1 < count) fprintf(outf, ", ");
+    }
+    fprintf(outf, "}");
+}
+
+static void gen_concat(Node *n, Node *fn_def) {
+    Node *parts[CONCAT_MAX_PARTS];
+    int count = concat_parts(n, fn_def, parts, 0);
+    fprintf(outf, "_sauce_concat(");
+    gen_concat_args(parts, count, fn_def);
+    fprintf(outf, ")");
+}
+
+// Comparação de text compara o conteúdo (igualdade via cabeçalhos, ordem via strcmp)
+static int is_text_compare(Node *n, Node *fn_def) {
+    const char *lt = get_expr_type(n->left, fn_def);
+    const char *rt = get_expr_type(n->right, fn_def);
+    if (!is_text_type(lt) && !is_text_type(rt)) return 0;
+    if (!is_text_type(lt) || !is_text_type(rt)) {
+        fprintf(stderr, "Erro Semântico: Comparação entre %s e %s.\n", lt, rt);
+        exit(1);
+    }
+    return 1;
+}
+
+// Cópia própria de um valor text; concatenações e resultados novos de chamadas já são próprios
+static void gen_text_copy(Node *expr, Node *fn_def) {
+    if (is_text_concat(expr, fn_def) || is_fresh_text_call(expr)) {
+        gen_expr(expr, fn_def);
+        return;
+    }
+    fprintf(outf, "_sauce_text_dup(");
+    gen_expr(expr, fn_def);
+    fprintf(outf, ")");
+}
+
+// Concatenação só para comparar: no arena da chamada (ou do main), se houver um
+static void gen_text_compare_operand(Node *n, Node *fn_def) {
+    if (arena_temps_in(fn_def) && is_text_concat(n, fn_def)) {
+        gen_arena_value(n, fn_def);
+    } else {
+        gen_expr(n, fn_def);
+    }
+}
+
+static void gen_text_compare(Node *n, Node *fn_def) {
+    int eq = n->kind == N_EQ_CMP || n->kind == N_NEQ;
+    fprintf(outf, "(%s%s(", n->kind == N_NEQ ? "!" : "", eq ? "_sauce_text_eq" : "_sauce_text_cmp");
+    gen_text_compare_operand(n->left, fn_def);
+    fprintf(outf, ", ");
+    gen_text_compare_operand(n->right, fn_def);
+    fprintf(outf, ")");
+    if (n->kind == N_GT) fprintf(outf, " > 0");
+    else if (n->kind == N_LT) fprintf(outf, " < 0");
+    else if (n->kind == N_GTE) fprintf(outf, " >= 0");
+    else if (n->kind == N_LTE) fprintf(outf, " <= 0");
+    fprintf(outf, ")");
+}
+
+// 'name + ...': o primeiro pedaço da cadeia é a própria variável
+static int is_self_append(Node *expr, const char *name, Node *fn_def) {
+    if (!is_text_concat(expr, fn_def)) return 0;
+    Node *parts[CONCAT_MAX_PARTS];
+    concat_parts(expr, fn_def, parts, 0);
+    return parts[0]->kind == N_VAR && strcmp(parts[0]->name, name) == 0;
+}
+
+static void gen_text_append(const char *name, Node *expr, Node *fn_def) {
+    Node *parts[CONCAT_MAX_PARTS];
+    int count = concat_parts(expr, fn_def, parts, 0);
+    fprintf(outf, "_sauce_append(%s, &_sauce_tb_%s, ", name, name);
+    gen_concat_args(parts + 1, count - 1, fn_def);
+    fprintf(outf, ")");
+}
+
+// Variáveis com buffer na função sendo gerada (locais e parâmetros text)
+static Node *textbuf_fn = NULL;
+static char textbuf_names[MAX_SYMBOLS][MAX_TOKEN_LEN];
+static int textbufCount = 0;
+
+static int has_text_buf(const char *name, Node *fn_def) {
+    if (!fn_def || fn_def != textbuf_fn) return 0;
+    for (int i = 0; i < textbufCount; i++) {
+        if (strcmp(textbuf_names[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+static int mentions_var(Node *n, const char *name) {
+    if (!n) return 0;
+    if (n->kind == N_VAR && strcmp(n->name, name) == 0) return 1;
+    return mentions_var(n->left, name) || mentions_var(n->mid, name) || mentions_var(n->right, name);
+}
+
+// O buffer só pode crescer no lugar se ninguém mais guarda o ponteiro: 'name' só
+// aparece onde o valor é copiado ou apenas lido (say, return, comparações,
+// concatenações, lado direito de atribuições) ou como alvo de hear/atribuições.
+// 'safe': n está numa dessas posições.
+static int text_var_escapes(Node *n, const char *name, Node *fn_def, int safe) {
+    if (!n) return 0;
+    switch (n->kind) {
+        case N_VAR:
+            return !safe && strcmp(n->name, name) == 0;
+        case N_SAY: case N_HEAR: case N_VAR_ASSIGN:
+            return text_var_escapes(n->left, name, fn_def, 1);
+        case N_RETURN:
+            if (is_self_tail_call(n, fn_def)) {
+                // O argumento no lugar do próprio parâmetro é a nova versão dele;
+                // os outros não podem citá-lo (seriam avaliados depois de crescer)
+                Node *p = fn_def->left, *a = n->left->left;
+                for (; p && a; p = p->right, a = a->right) {
+                    if (strcmp(p->left->name, name) == 0) {
+                        if (text_var_escapes(a->left, name, fn_def, 1)) return 1;
+                    } else if (mentions_var(a->left, name)) {
+                        return 1;
+                    }
+                }
+                return 0;
+            }
+            return text_var_escapes(n->left, name, fn_def, 1);
+        case N_GT: case N_LT: case N_EQ_CMP: case N_NEQ: case N_GTE: case N_LTE:
+            return text_var_escapes(n->left, name, fn_def, 1) || text_var_escapes(n->right, name, fn_def, 1);
+        case N_ADD:
+            if (is_text_concat(n, fn_def)) {
+                return text_var_escapes(n->left, name, fn_def, 1) || text_var_escapes(n->right, name, fn_def, 1);
+            }
+            break;
+        default:
+            break;
+    }
+    return text_var_escapes(n->left, name, fn_def, 0) || text_var_escapes(n->mid, name, fn_def, 0) ||
+           text_var_escapes(n->right, name, fn_def, 0);
+}
+
+static int is_local_or_param(const char *name, Node *fn_def) {
+    for (Node *p = fn_def->left; p; p = p->right) {
+        if (strcmp(p->left->name, name) == 0) return 1;
+    }
+    return find_local_decl(fn_def->mid, name) != NULL;
+}
+
+static void add_text_buf(const char *name, Node *fn_def) {
+    if (has_text_buf(name, fn_def) || textbufCount >= MAX_SYMBOLS) return;
+    if (!is_local_or_param(name, fn_def) || !is_text_type(lookup_variable_type(name, fn_def))) return;
+    if (text_var_escapes(fn_def->mid, name, fn_def, 0)) return;
+    strcpy(textbuf_names[textbufCount++], name);
+}
+
+// Alvos de 's = s + ...' e de 'return f(..., s + ..., ...)' no lugar de s
+static void collect_text_bufs(Node *n, Node *fn_def) {
+    if (!n) return;
+    if (n->kind == N_VAR_ASSIGN && is_self_append(n->left, n->name, fn_def)) {
+        add_text_buf(n->name, fn_def);
+    } else if (is_self_tail_call(n, fn_def)) {
+        Node *p = fn_def->left, *a = n->left->left;
+        for (; p && a; p = p->right, a = a->right) {
+            if (is_self_append(a->left, p->left->name, fn_def)) add_text_buf(p->left->name, fn_def);
+        }
+    }
+    collect_text_bufs(n->left, fn_def);
+    collect_text_bufs(n->mid, fn_def);
+    collect_text_bufs(n->right, fn_def);
+}
+
+static void select_text_bufs(Node *fn_def) {
+    textbuf_fn = fn_def;
+    textbufCount = 0;
+    collect_text_bufs(fn_def->mid, fn_def);
+}
+
+// Declara os buffers no início da função (antes do ponto de reentrada da TCO); o
+// buffer que não sai pelo return é liberado na saída (cleanup)
+static void gen_text_bufs(Node *fn_def) {
+    select_text_bufs(fn_def);
+    for (int i = 0; i < textbufCount; i++) {
+        fprintf(outf, "    _sauce_textbuf _sauce_tb_%s __attribute__((cleanup(_sauce_textbuf_release))) = {0};\n",
+                textbuf_names[i]);
+    }
+}
+
+// Qualquer outra escrita na variável (depois do free do valor antigo): o valor novo é uma
+// cópia própria, sem folga; o buffer passa a ser dono dela (a primeira concatenação a libera)
+static void gen_text_buf_reset(const char *name, Node *fn_def) {
+    if (has_text_buf(name, fn_def)) fprintf(outf, "    _sauce_tb_%s = (_sauce_textbuf){0, %s};\n", name, name);
+}
+
+// Escrita que não libera o valor antigo (nova declaração, parâmetro da TCO): libera o buffer.
+// Um valor novo ('value' concatenação ou resultado novo) fica com o buffer; outro é só lido.
+static void gen_text_buf_drop(const char *name, Node *value, Node *fn_def) {
+    if (!has_text_buf(name, fn_def)) return;
+    fprintf(outf, "    _sauce_textbuf_drop(&_sauce_tb_%s);\n", name);
+    if (value && (is_text_concat(value, fn_def) || is_fresh_text_call(value))) {
+        fprintf(outf, "    _sauce_tb_%s.own = %s;\n", name, name);
+    }
+}
+
+// --- Arena por chamada para locais text que não escapam ---
+
+// Locais text cujo ponteiro nunca sobrevive à chamada (não são devolvidos nem
+// guardados sem cópia) vivem num arena por thread: uma pilha de blocos onde
+// alocar é avançar um índice. A função guarda a marca na entrada e volta a ela
+// em qualquer return (cleanup) e a cada volta da TCO, então o espaço é reusado.
+// O resto (o que escapa) continua no heap.
+
+static Node *arena_fn = NULL;
+static char arena_names[MAX_SYMBOLS][MAX_TOKEN_LEN];
+static int arenaCount = 0;
+static int arenaTemps = 0; // Concatenações comparadas e descartadas: temporários no arena
+static int mainArenaTemps = 0; // Idem nos comandos globais (main)
+
+static int has_arena_var(const char *name, Node *fn_def) {
+    if (!fn_def || fn_def != arena_fn) return 0;
+    for (int i = 0; i < arenaCount; i++) {
+        if (strcmp(arena_names[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+static int is_param(const char *name, Node *fn_def) {
+    for (Node *p = fn_def->left; p; p = p->right) {
+        if (strcmp(p->left->name, name) == 0) return 1;
+    }
+    return 0;
+}
+
+// 'safe': o valor de n é copiado, só lido, ou não é um ponteiro de text. Onde o
+// ponteiro pode sair da chamada (return de text, inicializar um text fora do arena,
+// argumento de uma chamada cujo resultado text escapa) o local escapa. Quem é
+// alvo de recv/next recebe valores do heap: fica fora do arena.
+static int arena_var_escapes(Node *n, const char *name, Node *fn_def, int safe) {
+    if (!n) return 0;
+    switch (n->kind) {
+        case N_VAR:
+            return !safe && strcmp(n->name, name) == 0;
+        case N_VAR_DECL: {
+            int copied = is_gen_decl(n) || !is_text_type(n->typeName) || has_arena_var(n->name, fn_def);
+            return arena_var_escapes(n->left, name, fn_def, copied);
+        }
+        case N_VAR_ASSIGN: case N_SAY: case N_HEAR: case N_YIELD: case N_EXPR_STMT:
+            return arena_var_escapes(n->left, name, fn_def, 1);
+        case N_SEND:
+            return arena_var_escapes(n->right, name, fn_def, 1);
+        case N_RECV: case N_NEXT:
+            return n->right && strcmp(n->right->name, name) == 0;
+        case N_RETURN:
+            // Na TCO os argumentos viram parâmetros depois que o arena volta à marca
+            if (is_self_tail_call(n, fn_def)) return arena_var_escapes(n->left->left, name, fn_def, 0);
+            return arena_var_escapes(n->left, name, fn_def, !is_text_type(fn_def->typeName));
+        case N_SPAWN: case N_STAGE: // Os wrappers copiam os argumentos text
+            return arena_var_escapes(n->left->left, name, fn_def, 1);
+        case N_FN_CALL: {
+            int args_safe = safe || !is_text_type(get_expr_type(n, fn_def));
+            for (Node *a = n->left; a; a = a->right) {
+                if (arena_var_escapes(a->left, name, fn_def, args_safe)) return 1;
+            }
+            return 0;
+        }
+        case N_GT: case N_LT: case N_EQ_CMP: case N_NEQ: case N_GTE: case N_LTE:
+            return arena_var_escapes(n->left, name, fn_def, 1) || arena_var_escapes(n->right, name, fn_def, 1);
+        case N_ADD:
+            if (is_text_concat(n, fn_def)) {
+                return arena_var_escapes(n->left, name, fn_def, 1) || arena_var_escapes(n->right, name, fn_def, 1);
+            }
+            break;
+        case N_STMT_LIST: // Listas de argumentos herdam a posição da chamada
+            return arena_var_escapes(n->left, name, fn_def, safe) || arena_var_escapes(n->right, name, fn_def, safe);
+        default:
+            break;
+    }
+    return arena_var_escapes(n->left, name, fn_def, 0) || arena_var_escapes(n->mid, name, fn_def, 0) ||
+           arena_var_escapes(n->right, name, fn_def, 0);
+}
+
+// Chamada que não devolve text: o callee não tem como devolver o ponteiro de um
+// argumento (o que ele guarda, guarda por cópia), então a concatenação passada
+// só é lida durante a chamada
+static int is_concat_temp_call(Node *n, Node *fn_def) {
+    return n->kind == N_FN_CALL && !is_text_type(get_expr_type(n, fn_def));
+}
+
+// Concatenações descartadas no fim do comando: operandos de comparação e argumentos
+// dessas chamadas (a TCO passa os argumentos adiante e não conta)
+static int uses_concat_temps(Node *n, Node *fn_def) {
+    if (!n) return 0;
+    if ((n->kind == N_GT || n->kind == N_LT || n->kind == N_EQ_CMP || n->kind == N_NEQ ||
+         n->kind == N_GTE || n->kind == N_LTE) &&
+        (is_text_concat(n->left, fn_def) || is_text_concat(n->right, fn_def))) return 1;
+    if (n->kind == N_FN_CALL && is_concat_temp_call(n, fn_def)) {
+        for (Node *a = n->left; a; a = a->right) {
+            if (is_text_concat(a->left, fn_def)) return 1;
+        }
+    }
+    return uses_concat_temps(n->left, fn_def) || uses_concat_temps(n->mid, fn_def) || uses_concat_temps(n->right, fn_def);
+}
+
+static void collect_arena_candidates(Node *n, Node *fn_def) {
+    if (!n) return;
+    if (n->kind == N_VAR_DECL && is_text_type(n->typeName) && !is_param(n->name, fn_def) &&
+        !has_text_buf(n->name, fn_def) && !has_arena_var(n->name, fn_def) && arenaCount < MAX_SYMBOLS) {
+        strcpy(arena_names[arenaCount++], n->name);
+    }
+    if (n->kind == N_STMT_LIST || n->kind == N_IF) {
+        collect_arena_candidates(n->left, fn_def);
+        collect_arena_candidates(n->mid, fn_def);
+        collect_arena_candidates(n->right, fn_def);
+    }
+}
+
+// Começa com todos os locais text (fora os buffers de concatenação) e tira os que
+// escapam até estabilizar: tirar um pode fazer outro escapar (inicialização sem cópia)
+static void select_arena_vars(Node *fn_def) {
+    select_text_bufs(fn_def);
+    arena_fn = fn_def;
+    arenaCount = 0;
+    arenaTemps = 0;
+    if (fn_def->flags & (NODE_FLAG_GENERATOR | NODE_FLAG_EXTERN)) return;
+    arenaTemps = uses_concat_temps(fn_def->mid, fn_def);
+    collect_arena_candidates(fn_def->mid, fn_def);
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < arenaCount; i++) {
+            if (arena_var_escapes(fn_def->mid, arena_names[i], fn_def, 0)) {
+                strcpy(arena_names[i], arena_names[--arenaCount]);
+                changed = 1;
+                break;
+            }
+        }
+    }
+}
+
+static int arena_temps_in(Node *fn_def) {
+    if (!fn_def) return mainArenaTemps;
+    return fn_def == arena_fn && arenaTemps;
+}
+
+// Valor novo de um local do arena: literais ficam onde estão, o resto é copiado
+static void gen_arena_value(Node *expr, Node *fn_def) {
+    if (expr->kind == N_STRING) {
+        gen_expr(expr, fn_def);
+    } else if (is_text_concat(expr, fn_def)) {
+        Node *parts[CONCAT_MAX_PARTS];
+        int count = concat_parts(expr, fn_def, parts, 0);
+        fprintf(outf, "_sauce_concat_with(_sauce_arena_alloc, ");
+        gen_concat_args(parts, count, fn_def);
+        fprintf(outf, ")");
+    } else {
+        fprintf(outf, is_fresh_text_call(expr) ? "_sauce_arena_take(" : "_sauce_arena_dup(");
+        gen_expr(expr, fn_def);
+        fprintf(outf, ")");
+    }
+}
+
+// --- Resultados text novos ---
+
+// Uma função marcada NODE_FLAG_FRESH_TEXT devolve sempre um valor que ninguém mais
+// guarda: literal, concatenação, o próprio buffer de concatenação (que sai pelo
+// _sauce_textbuf_take), um local que só recebe valores novos e não escapa, ou a
+// chamada de outra função assim. Quem chama assume o resultado em vez de copiá-lo
+// (e de vazar o original); os locais do arena copiam e liberam.
+
+static int is_fresh_text_call(Node *n) {
+    if (!n || n->kind != N_FN_CALL) return 0;
+    Node *callee = find_function_def(n->name);
+    return callee && (callee->flags & NODE_FLAG_FRESH_TEXT);
+}
+
+static int is_fresh_text(Node *e, Node *fn_def);
+
+static int decls_fresh(Node *n, const char *name, Node *fn_def) {
+    if (!n) return 1;
+    if (n->kind == N_VAR_DECL && strcmp(n->name, name) == 0 && n->left && !is_fresh_text(n->left, fn_def)) return 0;
+    return decls_fresh(n->left, name, fn_def) && decls_fresh(n->mid, name, fn_def) && decls_fresh(n->right, name, fn_def);
+}
+
+// Atribuições, hear e concatenações já produzem cópias novas: basta olhar as declarações
+static int is_fresh_text_local(const char *name, Node *fn_def) {
+    return !is_param(name, fn_def) && find_local_decl(fn_def->mid, name) &&
+           !text_var_escapes(fn_def->mid, name, fn_def, 0) && decls_fresh(fn_def->mid, name, fn_def);
+}
+
+static int is_fresh_text(Node *e, Node *fn_def) {
+    if (e->kind == N_STRING || is_text_concat(e, fn_def)) return 1;
+    if (e->kind == N_FN_CALL) return is_fresh_text_call(e);
+    if (e->kind == N_VAR) return has_text_buf(e->name, fn_def) || is_fresh_text_local(e->name, fn_def);
+    return 0;
+}
+
+static int returns_fresh_text(Node *n, Node *fn_def) {
+    if (!n) return 1;
+    if (n->kind == N_RETURN && !is_self_tail_call(n, fn_def)) return n->left && is_fresh_text(n->left, fn_def);
+    return returns_fresh_text(n->left, fn_def) && returns_fresh_text(n->mid, fn_def) && returns_fresh_text(n->right, fn_def);
+}
+
+// Começa com todas as funções text do programa e tira as que devolvem algo emprestado
+// (parâmetro, global, resultado de outra) até estabilizar
+static void mark_fresh_text_results() {
+    for (int i = 0; i < fnDefCount; i++) {
+        Node *fn = fn_defs[i];
+        fn->flags &= ~NODE_FLAG_FRESH_TEXT;
+        if (is_text_type(fn->typeName) && !(fn->flags & (NODE_FLAG_GENERATOR | NODE_FLAG_EXTERN))) {
+            fn->flags |= NODE_FLAG_FRESH_TEXT;
+        }
+    }
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < fnDefCount; i++) {
+            Node *fn = fn_defs[i];
+            if (!(fn->flags & NODE_FLAG_FRESH_TEXT)) continue;
+            select_text_bufs(fn);
+            if (!returns_fresh_text(fn->mid, fn)) {
+                fn->flags &= ~NODE_FLAG_FRESH_TEXT;
+                changed = 1;
+            }
+        }
+    }
+    textbuf_fn = NULL;
+}
+
+// ------------------------------------------
+// --- Geradores (yield/next) ---
+// ------------------------------------------
+
+// Uma função com 'yield' vira máquina de estados sem pilha própria: struct com os
+// parâmetros e locais (içados) + um 'next' que retoma do último yield via switch/goto.
+// Dentro do 'next' as variáveis são locais C carregados do estado na entrada e
+// salvos a cada yield. 'g[gen<T>] = f(args)' cria o estado: na pilha de quem declara
+// (a variável não pode ser reatribuída, devolvida nem ir para outra thread) ou no
+// heap para globais e geradores de outras unidades. 'next(g, x)' chama o 'next'
+// direto quando o gerador de 'g' é conhecido e via ponteiro (parâmetros gen<T>).
+
+static Node *hoisted_vars[MAX_SYMBOLS]; // Parâmetros e locais de gen_current
+static int hoistedCount = 0;
+
+// Tipo das chamadas ao gerador (guardado no 'text' do N_FN_DEF, sem uso em funções)
+static const char *generator_type(Node *fn) {
+    snprintf(fn->text, MAX_TOKEN_LEN, "gen<%.*s>", MAX_TOKEN_LEN - 6, fn->typeName);
+    return fn->text;
+}
+
+// Tipo C do elemento de 'chan<T>' / 'gen<T>'
+static const char *elem_c_type(const char *sauce_type) {
+    char inner[MAX_TOKEN_LEN];
+    const char *open = strchr(sauce_type, '<');
+    if (!open) return "void";
+    snprintf(inner, sizeof(inner), "%s", open + 1);
+    char *close = strchr(inner, '>');
+    if (close) *close = '\0';
+    return sauce_type_to_c(inner);
+}
+
+static int is_gen_decl(Node *decl) {
+    return strncmp(decl->typeName, "gen<", 4) == 0;
+}
+
+// Valor do tipo 'type' pode ir para um elemento C 'elem' (int -> double é implícito)
+static int fits_elem(const char *type, const char *elem) {
+    const char *c_type = sauce_type_to_c(type);
+    if (strcmp(elem, "double") == 0) return strcmp(c_type, "double") == 0 || strcmp(c_type, "int") == 0;
+    return strcmp(c_type, elem) == 0;
+}
+
+static void check_not_generator_call(Node *call) {
+    Node *callee = find_function_def(call->name);
+    if (callee && (callee->flags & NODE_FLAG_GENERATOR)) {
+        fprintf(stderr, "Erro Semântico: '%s' é um gerador: use 'g[gen<T>] = %s(...)' e next(g, x).\n",
+                call->name, call->name);
+        exit(1);
+    }
+}
+
+// O estado fica na unidade que define o gerador; nas outras só existe o '_new'
+static int generator_in_unit(Node *fn) {
+    return unit_linkage ? fn == unit_fn : !(fn->flags & NODE_FLAG_EXTERN);
+}
+
+static void add_hoisted(Node *decl) {
+    for (int i = 0; i < hoistedCount; i++) {
+        if (strcmp(hoisted_vars[i]->name, decl->name) == 0) return; // Um tipo por nome (ver lookup_variable_type)
+    }
+    if (hoistedCount >= MAX_SYMBOLS) {
+        fprintf(stderr, "Erro: Limite de variáveis em um gerador excedido.\n");
+        exit(1);
+    }
+    hoisted_vars[hoistedCount++] = decl;
+}
+
+static void collect_hoisted(Node *n) {
+    if (!n) return;
+    if (n->kind == N_VAR_DECL) {
+        if (is_gen_decl(n)) {
+            fprintf(stderr, "Erro Semântico: '%s': geradores não podem declarar outros geradores (receba-os como parâmetro).\n",
+                    n->name);
+            exit(1);
+        }
+        add_hoisted(n);
+        return;
+    }
+    if (n->kind == N_STMT_LIST || n->kind == N_IF) {
+        collect_hoisted(n->left);
+        collect_hoisted(n->right);
+        collect_hoisted(n->mid);
+    }
+}
+
+static void gen_generator_types(Node *fn) {
+    const char *name = get_c_fn_name(fn->name);
+    hoistedCount = 0;
+    for (Node *p = fn->left; p; p = p->right) add_hoisted(p->left);
+    collect_hoisted(fn->mid);
+
+    fprintf(outf, "typedef struct { _sauce_gen base; int state;");
+    for (int i = 0; i < hoistedCount; i++) {
+        fprintf(outf, " %s %s;", sauce_type_to_c(hoisted_vars[i]->typeName), hoisted_vars[i]->name);
+    }
+    fprintf(outf, " } _sauce_gen_%s_t;\n", name);
+    fprintf(outf, "static int _sauce_gen_%s_next(_sauce_gen *_g, void *_out);\n", name);
+
+    // text recebido é copiado: o gerador vive além da expressão que o criou
+    fprintf(outf, "static inline __attribute__((unused)) _sauce_gen *_sauce_gen_%s_init(_sauce_gen_%s_t *_s", name, name);
+    for (Node *p = fn->left; p; p = p->right) {
+        fprintf(outf, ", %s %s", sauce_type_to_c(p->left->typeName), p->left->name);
+    }
+    fprintf(outf, ") {\n");
+    fprintf(outf, "    _s->base.next = _sauce_gen_%s_next;\n", name);
+    fprintf(outf, "    _s->state = 0;\n");
+    for (int i = 0; i < hoistedCount; i++) {
+        Node *v = hoisted_vars[i];
+        int is_param = 0;
+        for (Node *p = fn->left; p; p = p->right) if (p->left == v) is_param = 1;
+        int is_text = strcmp(sauce_type_to_c(v->typeName), "char*") == 0;
+        if (is_param && is_text) fprintf(outf, "    _s->%s = _sauce_text_dup(%s);\n", v->name, v->name);
+        else if (is_param) fprintf(outf, "    _s->%s = %s;\n", v->name, v->name);
+        else fprintf(outf, "    _s->%s = %s;\n", v->name, is_text ? "NULL" : "0");
+    }
+    fprintf(outf, "    return &_s->base;\n");
+    fprintf(outf, "}\n");
+}
+
+static void gen_save_state() {
+    for (int i = 0; i < hoistedCount; i++) {
+        fprintf(outf, "    _s->%s = %s;\n", hoisted_vars[i]->name, hoisted_vars[i]->name);
+    }
+}
+
+static void gen_yield(Node *n) {
+    const char *elem = sauce_type_to_c(gen_current->typeName);
+    const char *type = get_expr_type(n->left, gen_current);
+    if (!fits_elem(type, elem)) {
+        fprintf(stderr, "Erro Semântico: yield em '%s' (%d:%d): valor %s, mas o gerador produz %s.\n",
+                gen_current->name, n->line, n->col, type, gen_current->typeName);
+        exit(1);
+    }
+    int k = ++gen_yields;
+    if (strcmp(elem, "char*") == 0) {
+        // O consumidor recebe uma cópia e libera o valor anterior (como recv)
+        fprintf(outf, "    { char **_o = _out; char *_t = ");
+        gen_text_copy(n->left, gen_current);
+        fprintf(outf, "; _sauce_text_free(*_o); *_o = _t; }\n");
+    } else {
+        fprintf(outf, "    *(%s *)_out = ", elem);
+        gen_expr(n->left, gen_current);
+        fprintf(outf, ";\n");
+    }
+    gen_save_state();
+    fprintf(outf, "    _s->state = %d;\n", k);
+    fprintf(outf, "    return 1;\n");
+    fprintf(outf, "_yield%d: ;\n", k);
+}
+
+// 'return' encerra o gerador (o valor, se houver, só é avaliado)
+static void gen_generator_return(Node *n) {
+    if (n->left) {
+        fprintf(outf, "    (void)(");
+        gen_expr(n->left, gen_current);
+        fprintf(outf, ");\n");
+    }
+    fprintf(outf, "    _s->state = -1;\n");
+    fprintf(outf, "    return 0;\n");
+}
+
+static void gen_generator_definition(Node *fn) {
+    const char *name = get_c_fn_name(fn->name);
+    hoistedCount = 0;
+    for (Node *p = fn->left; p; p = p->right) add_hoisted(p->left);
+    collect_hoisted(fn->mid);
+
+    fprintf(outf, "\n");
+    gen_line_directive(fn);
+    fprintf(outf, "static int _sauce_gen_%s_next(_sauce_gen *_g, void *_out) {\n", name);
+    fprintf(outf, "    _sauce_gen_%s_t *_s = (_sauce_gen_%s_t *)_g;\n", name, name);
+    for (int i = 0; i < hoistedCount; i++) {
+        fprintf(outf, "    %s %s = _s->%s;\n", sauce_type_to_c(hoisted_vars[i]->typeName),
+                hoisted_vars[i]->name, hoisted_vars[i]->name);
+    }
+    fprintf(outf, "    if (_s->state != 0) goto _sauce_resume;\n");
+    if (has_self_tail_call(fn->mid, fn)) {
+        fprintf(outf, "_tco_entry: ;\n");
+    }
+
+    gen_current = fn;
+    gen_yields = 0;
+    for (Node *stmt = fn->mid; stmt; stmt = stmt->right) {
+        gen_statement(stmt->left, fn);
+    }
+    gen_current = NULL;
+    gen_line_reset();
+
+    if (!ends_with_return(fn->mid)) {
+        fprintf(outf, "    _s->state = -1;\n");
+        fprintf(outf, "    return 0;\n");
+    }
+    fprintf(outf, "_sauce_resume:\n");
+    fprintf(outf, "    switch (_s->state) {\n");
+    for (int k = 1; k <= gen_yields; k++) {
+        fprintf(outf, "    case %d: goto _yield%d;\n", k, k);
+    }
+    fprintf(outf, "    default: break;\n");
+    fprintf(outf, "    }\n");
+    fprintf(outf, "    return 0; /* Já terminou */\n");
+    fprintf(outf, "}\n");
+
+    // Construtor no heap: globais e chamadas vindas de outras unidades
+    fprintf(outf, "%s_sauce_gen *_sauce_gen_%s_new(", fn_c_linkage(fn), name);
+    for (Node *p = fn->left; p; p = p->right) {
+        fprintf(outf, "%s%s %s", p == fn->left ? "" : ", ", sauce_type_to_c(p->left->typeName), p->left->name);
+    }
+    if (!fn->left) fprintf(outf, "void");
+    fprintf(outf, ") {\n");
+    fprintf(outf, "    _sauce_gen_%s_t *_s = malloc(sizeof *_s);\n", name);
+    fprintf(outf, "    if (SAUCE_UNLIKELY(!_s)) { perror(\"malloc\"); exit(1); }\n");
+    fprintf(outf, "    return _sauce_gen_%s_init(_s", name);
+    for (Node *p = fn->left; p; p = p->right) fprintf(outf, ", %s", p->left->name);
+    fprintf(outf, ");\n");
+    fprintf(outf, "}\n");
+}
+
+// Gerador que inicializa a declaração 'decl' (NULL se não for uma chamada de gerador)
+static Node *generator_of(Node *decl) {
+    if (!decl || !decl->left || decl->left->kind != N_FN_CALL) return NULL;
+    Node *fn = find_function_def(decl->left->name);
+    return fn && (fn->flags & NODE_FLAG_GENERATOR) ? fn : NULL;
+}
+
+static void gen_generator_args(Node *call, Node *fn_def, int leading_comma) {
+    for (Node *a = call->left; a; a = a->right) {
+        if (leading_comma || a != call->left) fprintf(outf, ", ");
+        gen_expr(a->left, fn_def);
+    }
+}
+
+// 'g[gen<T>] = f(args)': local (estado na pilha) ou global (heap, criado em main)
+static void gen_generator_decl(Node *decl, Node *fn_def, int is_global) {
+    Node *fn = generator_of(decl);
+    if (!fn) {
+        fprintf(stderr, "Erro Semântico: '%s[%s]' precisa ser inicializado com uma chamada de gerador.\n",
+                decl->name, decl->typeName);
+        exit(1);
+    }
+    if (strcmp(elem_c_type(decl->typeName), sauce_type_to_c(fn->typeName)) != 0) {
+        fprintf(stderr, "Erro Semântico: '%s' é %s, mas o gerador '%s' produz %s.\n",
+                decl->name, decl->typeName, fn->name, fn->typeName);
+        exit(1);
+    }
+    const char *name = get_c_fn_name(fn->name);
+    if (!is_global && generator_in_unit(fn)) {
+        fprintf(outf, "    _sauce_gen_%s_t _sauce_gs_%s;\n", name, decl->name);
+        fprintf(outf, "    _sauce_gen* %s = _sauce_gen_%s_init(&_sauce_gs_%s", decl->name, name, decl->name);
+        gen_generator_args(decl->left, fn_def, 1);
+    } else {
+        fprintf(outf, "    %s%s = _sauce_gen_%s_new(", is_global ? "" : "_sauce_gen* ", decl->name, name);
+        gen_generator_args(decl->left, fn_def, 0);
+    }
+    fprintf(outf, ");\n");
+}
+
+static void gen_next(Node *n, Node *fn_def) {
+    const char *g = n->left->name;
+    const char *type = lookup_variable_type(g, fn_def);
+    if (!type || strncmp(type, "gen<", 4) != 0) {
+        fprintf(stderr, "Erro Semântico: next(%s, ...): '%s' não é um gerador.\n", g, g);
+        exit(1);
+    }
+    const char *target = lookup_variable_type(n->right->name, fn_def);
+    if (!target) {
+        fprintf(stderr, "Erro Semântico: Variável '%s' não declarada.\n", n->right->name);
+        exit(1);
+    }
+    if (strcmp(sauce_type_to_c(target), elem_c_type(type)) != 0) {
+        fprintf(stderr, "Erro Semântico: next(%s, %s): '%s' é %s, diferente do tipo do gerador.\n",
+                g, n->right->name, n->right->name, target);
+        exit(1);
+    }
+    Node *fn = generator_of(find_var_decl(g, fn_def));
+    if (fn && generator_in_unit(fn)) {
+        fprintf(outf, "_sauce_gen_%s_next(%s, &%s)", get_c_fn_name(fn->name), g, n->right->name);
+    } else {
+        fprintf(outf, "%s->next(%s, &%s)", g, g, n->right->name);
+    }
+}
+
+// O estado de um gerador não é thread-safe (e o local fica na pilha de quem o criou)
+static void check_thread_args(Node *fn, const char *what) {
+    if (fn->flags & NODE_FLAG_GENERATOR) {
+        fprintf(stderr, "Erro Semântico: '%s %s': geradores não podem rodar em outra thread.\n", what, fn->name);
+        exit(1);
+    }
+    for (Node *p = fn->left; p; p = p->right) {
+        if (is_gen_decl(p->left)) {
+            fprintf(stderr, "Erro Semântico: '%s %s': o parâmetro '%s' é um gerador e não pode ir para outra thread.\n",
+                    what, fn->name, p->left->name);
+            exit(1);
+        }
+    }
+}
+
+static int is_chan_decl(Node *decl) {
+    return strncmp(decl->typeName, "chan<", 5) == 0;
+}
+
+// Um canal é criado na declaração e nunca trocado: sem inicializador
+static void check_chan_decl(Node *decl) {
+    if (is_chan_decl(decl) && decl->left) {
+        fprintf(stderr, "Erro Semântico: canal '%s' não aceita inicializador (é criado vazio na declaração).\n",
+                decl->name);
+        exit(1);
+    }
+}
+
+// ------------------------------------------
+// --- Code Generation Core ---
+// ------------------------------------------
+
+static void gen_expr(Node *n, Node *fn_context) {
+    if (!n) return;
+
+    switch (n->kind) {
+        case N_INT:
+        case N_FLOAT:
+            fprintf(outf, "%s", n->text);
+            break;
+            
+        case N_STRING: {
+            // Literal internado (objeto estático com cabeçalho, ver gen_text_literals)
+            int lit = text_literal_index(n->text);
+            if (lit < 0) {
+                fprintf(stderr, "Erro Interno: literal text fora da tabela: \"%s\"\n", n->text);
+                exit(1);
+            }
+            fprintf(outf, "((char *)_sauce_lit%d.s)", lit);
+            break;
+        }
+
+        case N_BOOL:
+            // Booleanos mapeiam para 1 e 0 (tipo int em C)
+            fprintf(outf, "%s", strcmp(n->text, "true") == 0 ? "1" : "0");
+            break;
+
+        case N_VAR:
+            fprintf(outf, "%s", n->name);
+            break;
+
+        case N_FN_CALL:
+            check_not_generator_call(n);
+            fprintf(outf, "%s(", get_c_fn_name(n->name));
+            Node *arg_wrapper = n->left;
+            while (arg_wrapper) {
+                if (arena_temps_in(fn_context) && is_concat_temp_call(n, fn_context) &&
+                    is_text_concat(arg_wrapper->left, fn_context)) {
+                    gen_arena_value(arg_wrapper->left, fn_context); // Só lido durante a chamada
+                } else {
+                    gen_expr(arg_wrapper->left, fn_context);
+                }
+                arg_wrapper = arg_wrapper->right;
+                if (arg_wrapper) {
+                    fprintf(outf, ", ");
+                }
+            }
+            fprintf(outf, ")");
+            break;
+
+        case N_SPAWN: {
+            // Empacota os argumentos e publica a tarefa (ver gen_spawn_wrapper)
+            Node *call = n->left;
+            fprintf(outf, "_sauce_spawn_%s(", get_c_fn_name(call->name));
+            for (Node *a = call->left; a; a = a->right) {
+                gen_expr(a->left, fn_context);
+                if (a->right) fprintf(outf, ", ");
+            }
+            fprintf(outf, ")");
+            break;
+        }
+
+        case N_RECV: {
+            // Destino: variável do mesmo tipo do canal (text libera o valor antigo)
+            const char *suffix = chan_value_suffix(n->left->name, fn_context);
+            const char *target = lookup_variable_type(n->right->name, fn_context);
+            if (!target) {
+                fprintf(stderr, "Erro Semântico: Variável '%s' não declarada.\n", n->right->name);
+                exit(1);
+            }
+            const char *c_target = sauce_type_to_c(target);
+            const char *c_elem = strcmp(suffix, "float") == 0 ? "double" : strcmp(suffix, "text") == 0 ? "char*" : "int";
+            if (strcmp(c_target, c_elem) != 0) {
+                fprintf(stderr, "Erro Semântico: recv(%s, %s): '%s' é %s, diferente do tipo do canal.\n",
+                        n->left->name, n->right->name, n->right->name, target);
+                exit(1);
+            }
+            fprintf(outf, "_sauce_recv_%s(%s, &%s)", suffix, n->left->name, n->right->name);
+            break;
+        }
+
+        case N_NEXT:
+            gen_next(n, fn_context);
+            break;
+
+        case N_JOIN: {
+            const char *c_type = sauce_type_to_c(task_result_type(n, fn_context));
+            fprintf(outf, "_sauce_join(&%s)", n->left->name);
+            if (strcmp(c_type, "double") == 0) fprintf(outf, ".f");
+            else if (strcmp(c_type, "char*") == 0) fprintf(outf, ".s");
+            else if (strcmp(c_type, "int") == 0) fprintf(outf, ".i");
+            break;
+        }
+        
+        case N_AND:
+        case N_OR:
+        case N_NOT:
+        case N_ADD: case N_SUB: case N_MUL: case N_DIV: 
+        case N_GT: case N_EQ_CMP: case N_LT: case N_NEQ: 
+        case N_GTE: case N_LTE: 
+        
+            if (is_text_concat(n, fn_context)) {
+                gen_concat(n, fn_context);
+                break;
+            }
+            if (n->kind != N_AND && n->kind != N_OR && n->kind != N_NOT && is_text_compare(n, fn_context)) {
+                gen_text_compare(n, fn_context);
+                break;
+            }
+
+            if (n->kind == N_NOT) {
+                fprintf(outf, "(!");
+                gen_expr(n->left, fn_context);
+                fprintf(outf, ")");
+                break;
+            }
+
+            fprintf(outf, "("); 
+            gen_expr(n->left, fn_context); 
+            
+            if (n->kind == N_AND) fprintf(outf, " && "); 
+            else if (n->kind == N_OR) fprintf(outf, " || "); 
+            else if (n->kind == N_ADD) fprintf(outf, " + ");
+            else if (n->kind == N_SUB) fprintf(outf, " - ");
+            else if (n->kind == N_MUL) fprintf(outf, " * ");
+            else if (n->kind == N_DIV) fprintf(outf, " / ");
+            else if (n->kind == N_GT) fprintf(outf, " > ");
+            else if (n->kind == N_LT) fprintf(outf, " < ");
+            else if (n->kind == N_EQ_CMP) fprintf(outf, " == ");
+            else if (n->kind == N_NEQ) fprintf(outf, " != ");
+            else if (n->kind == N_GTE) fprintf(outf, " >= ");
+            else if (n->kind == N_LTE) fprintf(outf, " <= ");
+            
+            gen_expr(n->right, fn_context); 
+            fprintf(outf, ")"); 
+            break;
+            
+        default:
+            fprintf(stderr, "Erro Interno: Expressão de nó desconhecida: %d\n", n->kind);
+            exit(1);
+    }
+}
+
+// ------------------------------------------
+// --- Mapeamento de Linhas (-g) ---
+// ------------------------------------------
+
+static void begin_output(const char *out_c) {
+    out_path = out_c;
+    snprintf(out_name, sizeof(out_name), "%s", out_c);
+    size_t len = strlen(out_name);
+    if (len > 4 && strcmp(out_name + len - 4, ".tmp") == 0) out_name[len - 4] = '\0';
+    out_scanned = 0;
+    out_lines = 0;
+}
+
+static void gen_quoted_path(const char *path) {
+    fputc('"', outf);
+    for (const char *c = path; *c; c++) {
+        if (*c == '"' || *c == '\\') fputc('\\', outf);
+        fputc(*c, outf);
+    }
+    fputc('"', outf);
+}
+
+// As linhas C seguintes pertencem à linha do .sauce onde o nó começa
+static void gen_line_directive(Node *n) {
+    if (!cg_options.line_directives || !n || n->line <= 0) return;
+    fprintf(outf, "#line %d ", n->line);
+    gen_quoted_path(cg_options.source_file ? cg_options.source_file : "input.sauce");
+    fprintf(outf, "\n");
+}
+
+// Volta a numerar pelo próprio arquivo C (código gerado sem origem no .sauce)
+static void gen_line_reset() {
+    if (!cg_options.line_directives) return;
+    fflush(outf);
+    long end = ftell(outf);
+    FILE *in = fopen(out_path, "r");
+    if (in) {
+        fseek(in, out_scanned, SEEK_SET);
+        for (long pos = out_scanned; pos < end; pos++) {
+            int c = fgetc(in);
+            if (c == EOF) break;
+            if (c == '\n') out_lines++;
+        }
+        fclose(in);
+    }
+    out_scanned = end;
+    // Esta diretiva está na linha out_lines + 1; vale a partir da seguinte
+    fprintf(outf, "#line %d ", out_lines + 2);
+    gen_quoted_path(out_name);
+    fprintf(outf, "\n");
+}
+
+// ------------------------------------------
+// --- Cadeias else-if -> switch ---
+// ------------------------------------------
+
+// 'if (x == 1) ... else if (x == 2) ...' com a mesma variável e constantes distintas
+// vira um switch (tabela de saltos no cc). Com text, o switch é sobre o hash do
+// conteúdo e cada caso confirma com strcmp.
+#define SWITCH_MIN_ARMS 3
+
+static int switch_counter = 0; // Nomes únicos para as variáveis dos switches de text
+
+// 'var == literal' ou 'literal == var': retorna o literal e grava a variável em *var
+static Node *switch_key(Node *cond, Node **var) {
+    if (!cond || cond->kind != N_EQ_CMP) return NULL;
+    Node *a = cond->left, *b = cond->right;
+    if (a->kind != N_VAR) { Node *t = a; a = b; b = t; }
+    if (a->kind != N_VAR || (b->kind != N_INT && b->kind != N_STRING)) return NULL;
+    // O hash de um literal com escapes teria que seguir as regras do C: fica na cascata
+    if (b->kind == N_STRING && strchr(b->text, '\\')) return NULL;
+    *var = a;
+    return b;
+}
+
+static int same_switch_key(Node *a, Node *b) {
+    if (a->kind == N_INT) return strtoll(a->text, NULL, 10) == strtoll(b->text, NULL, 10);
+    return strcmp(a->text, b->text) == 0;
+}
+
+// Quantos ifs do início da cadeia entram no switch (0 se a cadeia não serve).
+// Para no primeiro if de outra variável, de outro tipo de literal ou com constante repetida.
+static int switch_chain_length(Node *n, Node *fn_def) {
+    Node *var = NULL;
+    Node *first = switch_key(n->left, &var);
+    if (!first) return 0;
+    const char *type = lookup_variable_type(var->name, fn_def);
+    if (!type) return 0;
+    if (first->kind == N_INT && strcmp(type, "int") != 0) return 0;
+    if (first->kind == N_STRING && strcmp(sauce_type_to_c(type), "char*") != 0) return 0;
+
+    int count = 0;
+    for (Node *cur = n; cur && cur->kind == N_IF; cur = cur->mid, count++) {
+        Node *v = NULL;
+        if (if_branch_hint(cur)) break; // Braço com dica de desvio continua um 'if'
+        Node *key = switch_key(cur->left, &v);
+        if (!key || strcmp(v->name, var->name) != 0 || key->kind != first->kind) break;
+
+        int repeated = 0;
+        Node *prev = n;
+        for (int i = 0; i < count && !repeated; i++, prev = prev->mid) {
+            Node *pv;
+            repeated = same_switch_key(switch_key(prev->left, &pv), key);
+        }
+        if (repeated) break;
+    }
+    return count;
+}
+
+// Mesmo hash do cabeçalho dos text (_sauce_text_hash no runtime), 0 reservado
+static unsigned long long text_hash(const char *s) {
+    unsigned long long h = 1469598103934665603ULL;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1;
+}
+
+static void gen_block(Node *list, Node *fn_def) {
+    for (Node *w = list; w; w = w->right) {
+        gen_statement(w->left, fn_def);
+    }
+}
+
+// O que sobra depois dos 'arms' ifs do switch: bloco else, if que não entrou ou nada
+static void gen_switch_default(Node *rest, Node *fn_def) {
+    if (!rest) return;
+    fprintf(outf, "    default: {\n");
+    if (rest->kind == N_IF) gen_statement(rest, fn_def);
+    else gen_block(rest, fn_def);
+    fprintf(outf, "    break; }\n");
+}
+
+static void gen_switch_chain(Node *n, int arms, Node *fn_def) {
+    Node *var = NULL;
+    int is_text = switch_key(n->left, &var)->kind == N_STRING;
+    Node *rest = n;
+    for (int i = 0; i < arms; i++) rest = rest->mid;
+
+    if (!is_text) {
+        fprintf(outf, "    switch (%s) {\n", var->name);
+        Node *cur = n;
+        for (int i = 0; i < arms; i++, cur = cur->mid) {
+            Node *v;
+            fprintf(outf, "    case %s: {\n", switch_key(cur->left, &v)->text);
+            gen_block(cur->right, fn_def);
+            fprintf(outf, "    break; }\n");
+        }
+        gen_switch_default(rest, fn_def);
+        fprintf(outf, "    }\n");
+        return;
+    }
+
+    // text: 1) hash -> índice do braço (colisões confirmadas em sequência); 2) switch denso no índice
+    int id = switch_counter++;
+    Node **keys = malloc(sizeof(Node *) * arms);
+    unsigned long long *hashes = malloc(sizeof(unsigned long long) * arms);
+    char *done = calloc(arms, 1);
+    Node *cur = n;
+    for (int i = 0; i < arms; i++, cur = cur->mid) {
+        Node *v;
+        keys[i] = switch_key(cur->left, &v);
+        hashes[i] = text_hash(keys[i]->text);
+    }
+
+    fprintf(outf, "    {\n");
+    fprintf(outf, "    int _sw%d = -1;\n", id);
+    // NULL (text não inicializado) vale como "", igual a _sauce_text_eq
+    fprintf(outf, "    const char *_sk%d = %s ? %s : \"\";\n", id, var->name, var->name);
+    fprintf(outf, "    switch (%s ? _sauce_text_hash(%s) : 0x%llxULL) {\n", var->name, var->name, text_hash(""));
+    for (int i = 0; i < arms; i++) {
+        if (done[i]) continue;
+        fprintf(outf, "    case 0x%llxULL:", hashes[i]);
+        const char *sep = " ";
+        for (int j = i; j < arms; j++) {
+            if (hashes[j] != hashes[i]) continue;
+            done[j] = 1;
+            fprintf(outf, "%sif (strcmp(_sk%d, \"%s\") == 0) _sw%d = %d;", sep, id, keys[j]->text, id, j);
+            sep = " else ";
+        }
+        fprintf(outf, " break;\n");
+    }
+    fprintf(outf, "    }\n");
+
+    fprintf(outf, "    switch (_sw%d) {\n", id);
+    cur = n;
+    for (int i = 0; i < arms; i++, cur = cur->mid) {
+        fprintf(outf, "    case %d: {\n", i);
+        gen_block(cur->right, fn_def);
+        fprintf(outf, "    break; }\n");
+    }
+    gen_switch_default(rest, fn_def);
+    fprintf(outf, "    }\n");
+    fprintf(outf, "    }\n");
+
+    free(keys);
+    free(hashes);
+    free(done);
+}
+
+// --- say/hear do perfil --static: chamadas ao runtime sem stdio (runtime/rt_io.c) ---
+
+// 0: tipo sem helper (fica com o caminho do printf)
+static int gen_say_minimal(Node *expr, const char *type, Node *fn_def) {
+    if (is_text_concat(expr, fn_def) || is_fresh_text_call(expr)) {
+        fprintf(outf, "    { char *_t = ");
+        gen_expr(expr, fn_def);
+        fprintf(outf, "; _sauce_say_text(_t); _sauce_text_free(_t); }\n");
+        return 1;
+    }
+    const char *helper;
+    if (strcmp(type, "boolean") == 0) helper = "bool";
+    else if (strcmp(type, "int") == 0) helper = "int";
+    else if (strcmp(type, "float") == 0) helper = "float";
+    else if (strcmp(type, "text") == 0 || strcmp(type, "string") == 0) helper = "text";
+    else return 0;
+    fprintf(outf, "    _sauce_say_%s(", helper);
+    gen_expr(expr, fn_def);
+    fprintf(outf, ");\n");
+    return 1;
+}
+
+static int gen_hear_minimal(const char *var_name, const char *c_type, Node *fn_def) {
+    if (strcmp(c_type, "int") == 0) {
+        fprintf(outf, "    _sauce_hear_int(&%s);\n", var_name);
+    } else if (strcmp(c_type, "double") == 0) {
+        fprintf(outf, "    _sauce_hear_float(&%s);\n", var_name);
+    } else if (strcmp(c_type, "char*") == 0) {
+        if (has_arena_var(var_name, fn_def)) {
+            fprintf(outf, "    %s = _sauce_hear_text(_sauce_arena_alloc);\n", var_name);
+        } else {
+            fprintf(outf, "    { char *_t = _sauce_hear_text(_sauce_text_alloc); _sauce_text_free(%s); %s = _t; }\n",
+                    var_name, var_name);
+        }
+        gen_text_buf_reset(var_name, fn_def);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static void gen_statement(Node *n, Node *fn_def) {
+    if (!n) return;
+
+    gen_line_directive(n);
+
+    switch (n->kind) {
+        case N_VAR_DECL: {
+            // Este caso só deve ocorrer para declarações LOCAIS.
+            const char *c_type = sauce_type_to_c(n->typeName);
+            check_task_value(n->name, n->typeName, n->left, fn_def);
+            check_chan_decl(n);
+            if (is_gen_decl(n)) {
+                gen_generator_decl(n, fn_def, 0);
+                break;
+            }
+            
+            // Dentro de um gerador a variável já existe (içada): só atribui
+            if (gen_current) fprintf(outf, "    %s", n->name);
+            else fprintf(outf, "    %s %s", c_type, n->name);
+            
+            if (is_chan_decl(n)) {
+                fprintf(outf, " = _sauce_chan_new(SAUCE_CHAN_CAPACITY, %d)", (n->flags & NODE_FLAG_SPSC) ? 1 : 0);
+            } else if (n->left && has_arena_var(n->name, fn_def)) {
+                fprintf(outf, " = ");
+                gen_arena_value(n->left, fn_def);
+            } else if (n->left) {
+                fprintf(outf, " = ");
+                gen_expr(n->left, fn_def);
+            } else if (strcmp(c_type, "char*") == 0) {
+                 fprintf(outf, " = NULL"); // Inicialização segura para ponteiro
+            } else {
+                 fprintf(outf, " = 0"); // Inicialização segura para números/booleanos
+            }
+            
+            fprintf(outf, ";\n");
+            gen_text_buf_drop(n->name, n->left, fn_def);
+            if (in_bench_body) {
+                fprintf(outf, "    ");
+                gen_bench_sink(n->name);
+                fprintf(outf, "\n");
+            }
+            break;
+        }
+        
+        case N_VAR_ASSIGN: {
+            const char *sauce_type = lookup_variable_type(n->name, fn_def);
+            if (!sauce_type) {
+                fprintf(stderr, "Erro de Geração: Variável '%s' não encontrada para atribuição.\n", n->name);
+                exit(1);
+            }
+            check_task_value(n->name, sauce_type, n->left, fn_def);
+            if (strncmp(sauce_type, "chan<", 5) == 0 || strncmp(sauce_type, "gen<", 4) == 0) {
+                fprintf(stderr, "Erro Semântico: %s '%s' não pode ser reatribuído.\n",
+                        sauce_type[0] == 'c' ? "canal" : "gerador", n->name);
+                exit(1);
+            }
+
+            if (has_arena_var(n->name, fn_def)) {
+                // Local do arena: o valor antigo some quando a chamada terminar
+                fprintf(outf, "    %s = ", n->name);
+                gen_arena_value(n->left, fn_def);
+                fprintf(outf, ";\n");
+            } else if (has_text_buf(n->name, fn_def) && is_self_append(n->left, n->name, fn_def)) {
+                // s = s + ...: cresce o buffer de s no lugar
+                fprintf(outf, "    %s = ", n->name);
+                gen_text_append(n->name, n->left, fn_def);
+                fprintf(outf, ";\n");
+            } else if (is_text_concat(n->left, fn_def)) {
+                // A concatenação já é uma cópia nova (e pode ler o valor antigo)
+                fprintf(outf, "    { char *_t = ");
+                gen_concat(n->left, fn_def);
+                fprintf(outf, "; _sauce_text_free(%s); %s = _t; }\n", n->name, n->name);
+                gen_text_buf_reset(n->name, fn_def);
+            } else if (strcmp(sauce_type, "text") == 0 || strcmp(sauce_type, "string") == 0) {
+                // Atribuição de string: libera a string antiga e copia a nova
+                fprintf(outf, "    _sauce_text_free(%s);\n", n->name);
+                fprintf(outf, "    %s = ", n->name);
+                gen_text_copy(n->left, fn_def);
+                fprintf(outf, ";\n");
+                gen_text_buf_reset(n->name, fn_def);
+            } else {
+                // Atribuição simples
+                fprintf(outf, "    %s = ", n->name);
+                gen_expr(n->left, fn_def);
+                fprintf(outf, ";\n");
+            }
+            if (in_bench_body) {
+                fprintf(outf, "    ");
+                gen_bench_sink(n->name);
+                fprintf(outf, "\n");
+            }
+            break;
+        }
+
+        case N_SAY: {
+            Node *expr = n->left;
+            const char *type = get_expr_type(expr, fn_def);
+
+            if (cg_options.minimal_io && gen_say_minimal(expr, type, fn_def)) break;
+            
+            if (is_text_concat(expr, fn_def) || is_fresh_text_call(expr)) {
+                // Texto temporário (concatenação ou resultado novo): imprime e libera
+                fprintf(outf, "    { char *_t = ");
+                gen_expr(expr, fn_def);
+                fprintf(outf, "; printf(\"%%s\\n\", _t); _sauce_text_free(_t); }\n");
+                break;
+            }
+
+            // *** CORREÇÃO CRÍTICA: Trata a saída de booleanos para imprimir "true" ou "false" ***
+            if (strcmp(type, "boolean") == 0) {
+                // Se for booleano, usa o operador ternário para imprimir a string "true" ou "false"
+                fprintf(outf, "    printf(\"%%s\\n\", (");
+                gen_expr(expr, fn_def); 
+                fprintf(outf, ") ? \"true\" : \"false\");\n");
+            } 
+            else {
+                // Para todos os outros tipos
+                fprintf(outf, "    printf(");
+                
+                if (strcmp(type, "int") == 0) {
+                    fprintf(outf, "\"%%d\\n\", ");
+                } else if (strcmp(type, "float") == 0) {
+                    fprintf(outf, "\"%%f\\n\", ");
+                } else if (strcmp(type, "text") == 0 || strcmp(type, "string") == 0) {
+                    fprintf(outf, "\"%%s\\n\", ");
+                } else {
+                    // Caso fallback
+                    fprintf(outf, "\"Erro: Tipo desconhecido (SAID) para saida.\\n\"");
+                    fprintf(outf, ");\n");
+                    break;
+                }
+                
+                gen_expr(expr, fn_def);
+                fprintf(outf, ");\n");
+            }
+            break;
+        }
+        
+        case N_HEAR: {
+            const char *var_name = n->left->name;
+            const char *sauce_type = lookup_variable_type(var_name, fn_def);
+            const char *c_type = sauce_type_to_c(sauce_type);
+
+            if (cg_options.minimal_io && gen_hear_minimal(var_name, c_type, fn_def)) break;
+            
+            fprintf(outf, "    printf(\"\\n> \");\n");
+            
+            if (strcmp(c_type, "int") == 0) {
+                fprintf(outf, "    if (scanf(\"%%d\", &%s) != 1) { /* erro na leitura de int */ } \n", var_name);
+                // Limpa o buffer após leitura numérica
+                fprintf(outf, "    { int _c; while((_c = getchar()) != '\\n' && _c != EOF); }\n");
+            } else if (strcmp(c_type, "double") == 0) {
+                fprintf(outf, "    if (scanf(\"%%lf\", &%s) != 1) { /* erro na leitura de double */ } \n", var_name);
+                // Limpa o buffer após leitura numérica
+                fprintf(outf, "    { int _c; while((_c = getchar()) != '\\n' && _c != EOF); }\n");
+            } else if (strcmp(c_type, "char*") == 0) {
+                // 1. Limpa espaços e newlines de entradas ANTERIORES
+                fprintf(outf, "    { int _c; do { _c = getchar(); } while (_c != EOF && isspace(_c)); if (_c != EOF) ungetc(_c, stdin); }\n");
+                
+                // 2. Lê a linha toda com fgets, aloca e atribui
+                fprintf(outf, "    { char _buf[1024]; if (!fgets(_buf, sizeof(_buf), stdin)) _buf[0]='\\0'; size_t _n = strcspn(_buf, \"\\n\"); ");
+                if (has_arena_var(var_name, fn_def)) fprintf(outf, "%s = _sauce_text_new_with(_sauce_arena_alloc, _buf, _n); }\n", var_name);
+                else fprintf(outf, "_sauce_text_free(%s); %s = _sauce_text_new(_buf, _n); }\n", var_name, var_name);
+                gen_text_buf_reset(var_name, fn_def);
+            } else {
+                fprintf(outf, "    // Tipo '%s' nao suporta HEAR.\n", sauce_type);
+            }
+            break;
+        }
+        
+        case N_IF: {
+            int arms = switch_chain_length(n, fn_def);
+            if (arms >= SWITCH_MIN_ARMS) {
+                gen_switch_chain(n, arms, fn_def);
+                break;
+            }
+
+            // Dica (fonte ou perfil) vira __builtin_expect; com --profile, conta os dois lados
+            int hint = if_branch_hint(n);
+            int branch = cg_options.profile ? profiled_branch_index(n) : -1;
+            fprintf(outf, "    if (%s", hint > 0 ? "SAUCE_LIKELY(" : hint < 0 ? "SAUCE_UNLIKELY(" : "");
+            if (branch >= 0) fprintf(outf, "_sauce_prof_branch(%d, ", branch);
+            gen_expr(n->left, fn_def); 
+            fprintf(outf, "%s%s) {\n", branch >= 0 ? ")" : "", hint ? ")" : "");
+            
+            Node *body_stmt = n->right;
+            while (body_stmt) {
+                gen_statement(body_stmt->left, fn_def);
+                body_stmt = body_stmt->right;
+            }
+            
+            fprintf(outf, "    }");
+            
+            if (n->mid) {
+                fprintf(outf, " else ");
+                if (n->mid->kind == N_IF) {
+                    // else if (Recursão); o '#line' do else-if precisa começar uma linha
+                    if (cg_options.line_directives) fprintf(outf, "\n");
+                    gen_statement(n->mid, fn_def);
+                } else {
+                    fprintf(outf, "{\n");
+                    Node *else_stmt = n->mid;
+                    while (else_stmt) {
+                        gen_statement(else_stmt->left, fn_def);
+                        else_stmt = else_stmt->right;
+                    }
+                    fprintf(outf, "    }");
+                }
+            }
+            fprintf(outf, "\n");
+            break;
+        }
+
+        case N_RETURN:
+            if (is_self_tail_call(n, fn_def)) {
+                gen_self_tail_call(n, fn_def);
+                break;
+            }
+            if (gen_current) {
+                gen_generator_return(n);
+                break;
+            }
+            if (!n->left && strcmp(sauce_type_to_c(fn_def ? fn_def->typeName : "void"), "void") != 0) {
+                fprintf(stderr, "Erro Semântico: 'return' sem valor em '%s', que devolve %s.\n",
+                        fn_def->name, fn_def->typeName);
+                exit(1);
+            }
+
+            fprintf(outf, "    return ");
+            
+            if (n->explicitReturnType[0] != '\0') {
+                const char *c_type = sauce_type_to_c(n->explicitReturnType);
+                fprintf(outf, "(%s)", c_type);
+            }
+            
+            if (n->left && n->left->kind == N_VAR && has_text_buf(n->left->name, fn_def)) {
+                // O buffer passa para quem chamou em vez de ser liberado na saída
+                fprintf(outf, "_sauce_textbuf_take(&_sauce_tb_%s, %s);\n", n->left->name, n->left->name);
+                break;
+            }
+            gen_expr(n->left, fn_def);
+            fprintf(outf, ";\n");
+            break;
+
+        case N_EXPR_STMT:
+            // Dentro de bench, o resultado vai para um sink opaco (não pode ser eliminado pelo cc)
+            if (in_bench_body && strcmp(sauce_type_to_c(get_expr_type(n->left, fn_def)), "void") != 0) {
+                fprintf(outf, "    { %s _sink = ", sauce_type_to_c(get_expr_type(n->left, fn_def)));
+                gen_expr(n->left, fn_def);
+                fprintf(outf, "; ");
+                gen_bench_sink("_sink");
+                fprintf(outf, " }\n");
+                break;
+            }
+            // join(t) solto: só espera a tarefa
+            fprintf(outf, n->left->kind == N_JOIN ? "    (void)" : "    ");
+            gen_expr(n->left, fn_def);
+            fprintf(outf, ";\n");
+            break;
+
+        case N_YIELD:
+            gen_yield(n);
+            break;
+
+        case N_SEND: {
+            const char *suffix = chan_value_suffix(n->left->name, fn_def);
+            const char *type = get_expr_type(n->right, fn_def);
+            int ok = strcmp(suffix, "text") == 0 ? strcmp(sauce_type_to_c(type), "char*") == 0
+                   : strcmp(suffix, "float") == 0 ? strcmp(type, "float") == 0 || strcmp(type, "int") == 0
+                   : strcmp(sauce_type_to_c(type), "int") == 0;
+            if (!ok) {
+                fprintf(stderr, "Erro Semântico: send(%s, ...): valor %s não combina com o tipo do canal.\n",
+                        n->left->name, type);
+                exit(1);
+            }
+            fprintf(outf, "    _sauce_send_%s(%s, ", suffix, n->left->name);
+            gen_expr(n->right, fn_def);
+            fprintf(outf, ");\n");
+            break;
+        }
+
+        case N_CLOSE:
+            chan_value_suffix(n->left->name, fn_def); // Valida que é um canal
+            fprintf(outf, "    _sauce_chan_close(%s);\n", n->left->name);
+            break;
+
+        case N_STAGE: {
+            Node *call = n->left;
+            if (!find_function_def(call->name)) {
+                fprintf(stderr, "Erro Semântico: 'stage %s': função não definida.\n", call->name);
+                exit(1);
+            }
+            fprintf(outf, "    _sauce_stage_%s(", get_c_fn_name(call->name));
+            for (Node *a = call->left; a; a = a->right) {
+                gen_expr(a->left, fn_def);
+                if (a->right) fprintf(outf, ", ");
+            }
+            fprintf(outf, ");\n");
+            break;
+        }
+
+        case N_IMPORT:
+            // Resolvido pelo driver de módulos (module.c)
+            break;
+
+        case N_BENCH:
+            // Só aparece em main: chama o corpo já emitido como _sauce_bench_<id>
+            if (cg_options.bench) {
+                fprintf(outf, "    _sauce_bench_run(\"%s\", _sauce_bench_%s);\n", n->text, n->name);
+            }
+            break;
+            
+        default:
+            fprintf(stderr, "Erro Interno: Comando de nó desconhecido para geração: %d\n", n->kind);
+            exit(1);
+    }
+}
+
+// ------------------------------------------
+// --- Instrumentação de Perfil (--profile) ---
+// ------------------------------------------
+
+// Contadores thread-local por função, pilha sombra para tempo inclusivo/exclusivo e
+// uma árvore de contextos de chamada (CCT) para as pilhas colapsadas (formato
+// flamegraph): entrada/saída inline em sauce_rt.h, relatórios em runtime/rt_prof.c.
+// O programa emite só a tabela de nomes e os contadores de desvio.
+
+static int fn_index(Node *fn_def) {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (fn_defs[i] == fn_def) return i;
+    }
+    return -1;
+}
+
+// Contadores de desvio: um par (verdadeiro, falso) por 'if' do fonte, identificado
+// pela posição linha:coluna, que é o que --use-profile procura na build seguinte.
+// Atômicos relaxados: ramos executados por tasks e estágios também entram na conta.
+static Node **profiled_ifs = NULL;
+static int profiledIfCount = 0, profiledIfCap = 0;
+
+static void collect_profiled_ifs(Node *n) {
+    if (!n) return;
+    if (n->kind == N_IF && n->line > 0) {
+        if (profiledIfCount == profiledIfCap) {
+            profiledIfCap = profiledIfCap ? profiledIfCap * 2 : 64;
+            profiled_ifs = realloc(profiled_ifs, sizeof(Node *) * profiledIfCap);
+            if (!profiled_ifs) { perror("realloc"); exit(1); }
+        }
+        profiled_ifs[profiledIfCount++] = n;
+    }
+    collect_profiled_ifs(n->left);
+    collect_profiled_ifs(n->mid);
+    collect_profiled_ifs(n->right);
+}
+
+static int profiled_branch_index(Node *n) {
+    for (int i = 0; i < profiledIfCount; i++) {
+        if (profiled_ifs[i] == n) return i;
+    }
+    return -1;
+}
+
+// Depois de prepare_program(): os 'if' eliminados pelo dobramento não recebem contador
+static void gen_branch_profile_runtime() {
+    profiledIfCount = 0;
+    for (int i = 0; i < fnDefCount; i++) collect_profiled_ifs(fn_defs[i]->mid);
+    for (int i = 0; i < globalStmtCount; i++) collect_profiled_ifs(global_stmts[i]);
+
+    fprintf(outf, "#define SAUCE_PROF_NBR %d\n", profiledIfCount > 0 ? profiledIfCount : 1);
+    fprintf(outf, "static const int _sauce_prof_br_pos[SAUCE_PROF_NBR][2] = {");
+    for (int i = 0; i < profiledIfCount; i++) {
+        fprintf(outf, "%s{%d, %d}", i ? ", " : "", profiled_ifs[i]->line, profiled_ifs[i]->col);
+    }
+    fprintf(outf, "};\n");
+    fprintf(outf, "static unsigned long long _sauce_prof_br[SAUCE_PROF_NBR][2];\n");
+    fprintf(outf, "static inline int _sauce_prof_branch(int id, int c) {\n");
+    fprintf(outf, "    __atomic_fetch_add(&_sauce_prof_br[id][!c], 1, __ATOMIC_RELAXED);\n");
+    fprintf(outf, "    return c;\n");
+    fprintf(outf, "}\n\n");
+}
+
+static void gen_profile_names() {
+    fprintf(outf, "#define SAUCE_PROF_NFN %d\n", fnDefCount > 0 ? fnDefCount : 1);
+    // As tabelas de contadores do runtime têm tamanho fixo: um runtime antigo falha aqui, não em memória
+    fprintf(outf, "_Static_assert(SAUCE_PROF_NFN <= SAUCE_PROF_MAX_FN, \"libsauce_rt.a: tabelas de --profile menores que o programa\");\n");
+    fprintf(outf, "static const char *const _sauce_prof_names[SAUCE_PROF_NFN] = {");
+    for (int i = 0; i < fnDefCount; i++) {
+        fprintf(outf, "%s\"%s\"", i ? ", " : "", fn_defs[i]->name);
+    }
+    fprintf(outf, "};\n");
+}
+
+// ------------------------------------------
+// --- Blocos bench (--bench) ---
+// ------------------------------------------
+
+// Valor calculado dentro de um bench (resultado descartado, declaração, atribuição):
+// um asm opaco o consome, então o cc não pode eliminar o cálculo
+static void gen_bench_sink(const char *value) {
+    fprintf(outf, "__asm__ volatile(\"\" : : \"g\"(%s) : \"memory\");", value);
+}
+
+// Emite um 'static void _sauce_bench_<id>(void)' por bloco (o runner está em
+// runtime/rt_bench.c). O corpo é gerado com uma N_FN_DEF sintética para que as
+// declarações locais sejam encontradas.
+static void gen_bench_blocks() {
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind != N_BENCH) continue;
+
+        snprintf(stmt->name, MAX_TOKEN_LEN, "%d", i);
+
+        Node *ctx = make_node(N_FN_DEF, "_sauce_bench", NULL, NULL, stmt->right, NULL);
+        strcpy(ctx->typeName, "void");
+
+        fprintf(outf, "\nstatic void _sauce_bench_%d(void) {\n", i);
+        in_bench_body = 1;
+        for (Node *w = stmt->right; w; w = w->right) {
+            gen_statement(w->left, ctx);
+        }
+        in_bench_body = 0;
+        gen_line_reset();
+        fprintf(outf, "}\n");
+    }
+}
+
+// ------------------------------------------
+// --- Qualificadores C a partir da Análise de Efeitos ---
+// ------------------------------------------
+
+#define INLINE_HINT_MAX_NODES 32
+
+// Todo o programa vai em um único output.c, então toda função pode ser 'static'.
+// Funções pequenas recebem também 'inline'. Com módulos, a ligação é externa.
+static const char *fn_c_linkage(Node *fn_def) {
+    if (cg_options.module_mode || unit_linkage) return ""; // Visível para as outras unidades
+    if (!fn_should_memoize(fn_def) && ast_size(fn_def->mid) <= INLINE_HINT_MAX_NODES) {
+        return "static inline ";
+    }
+    return "static ";
+}
+
+// const: só depende dos argumentos escalares; pure: pode ler globais/memória.
+// Não se aplica a funções void nem ao wrapper de memoização (escreve no cache).
+static const char *fn_purity_attribute(Node *fn_def) {
+    if (strcmp(sauce_type_to_c(fn_def->typeName), "void") == 0 || fn_should_memoize(fn_def)) return "";
+    if (!fn_is_pure(fn_def)) return "";
+    // Cada chamada devolve uma cópia nova: duas chamadas não podem virar uma só
+    if (fn_def->flags & NODE_FLAG_FRESH_TEXT) return "";
+    if (strcmp(sauce_type_to_c(fn_def->typeName), "char*") == 0 && uses_text_concat(fn_def->mid, fn_def)) return "";
+
+    int scalar_params = 1;
+    Node *param_wrapper = fn_def->left;
+    while (param_wrapper) {
+        if (strcmp(sauce_type_to_c(param_wrapper->left->typeName), "char*") == 0) scalar_params = 0;
+        param_wrapper = param_wrapper->right;
+    }
+
+    if (fn_is_const(fn_def) && scalar_params && strcmp(sauce_type_to_c(fn_def->typeName), "char*") != 0) {
+        return " __attribute__((const))";
+    }
+    return " __attribute__((pure))";
+}
+
+// cold: só alcançada por ramos frios (ver annotate_branches); o cc a tira do caminho quente
+static const char *fn_c_attributes(Node *fn_def) {
+    static char attrs[64];
+    snprintf(attrs, sizeof(attrs), "%s%s", fn_purity_attribute(fn_def),
+             (fn_def->flags & NODE_FLAG_COLD) ? " __attribute__((cold))" : "");
+    return attrs;
+}
+
+static void gen_fn_definition(Node *n) {
+    if (n->flags & NODE_FLAG_GENERATOR) {
+        gen_generator_definition(n);
+        return;
+    }
+    const char *return_type = sauce_type_to_c(n->typeName);
+    const char *fn_name_c = get_c_fn_name(n->name); 
+    int memoize = fn_should_memoize(n);
+
+    fprintf(outf, "\n");
+    gen_line_directive(n);
+
+    // Funções memoizadas: o corpo vira '<nome>__impl' e o nome público é o wrapper com cache
+    if (memoize) {
+        fprintf(outf, "static %s %s__impl(", return_type, fn_name_c);
+    } else {
+        fprintf(outf, "%s%s %s(", fn_c_linkage(n), return_type, fn_name_c);
+    }
+
+    Node *param_wrapper = n->left;
+    while (param_wrapper) {
+        Node *param = param_wrapper->left;
         const char *c_type = sauce_type_to_c(param->typeName);
         
         // Passa strings por ponteiro
@@ -476,12 +2301,30 @@ static void gen_fn_definition(Node *n) {
         }
     }
     fprintf(outf, ") {\n");
+    gen_text_bufs(n);
+    select_arena_vars(n);
+
+    // Ponto de reentrada para chamadas de cauda próprias (ver gen_self_tail_call)
+    if (has_self_tail_call(n->mid, n)) {
+        fprintf(outf, "_tco_entry: ;\n");
+    }
+
+    // Hook de entrada; a saída roda via cleanup em qualquer return (e no goto da TCO)
+    if (cg_options.profile) {
+        fprintf(outf, "    int _sauce_pf __attribute__((cleanup(_sauce_prof_exit))) = _sauce_prof_enter(%d);\n", fn_index(n));
+    }
+
+    // Marca do arena: volta a ela em qualquer return e no goto da TCO
+    if (arenaCount > 0 || arenaTemps) {
+        fprintf(outf, "    _sauce_arena_mark _sauce_am __attribute__((cleanup(_sauce_arena_release))) = _sauce_arena_save();\n");
+    }
 
     Node *stmt_wrapper = n->mid;
     while (stmt_wrapper) {
         gen_statement(stmt_wrapper->left, n);
         stmt_wrapper = stmt_wrapper->right;
     }
+    gen_line_reset();
     
     // Retorno de segurança
     if (strcmp(return_type, "void") != 0 && !ends_with_return(n->mid)) {
@@ -496,19 +2339,274 @@ static void gen_fn_definition(Node *n) {
     }
 
     fprintf(outf, "}\n");
+
+    if (memoize) {
+        gen_memo_wrapper(n);
+    }
+}
+
+// Wrapper de memoização: tabela de mapeamento direto com SAUCE_MEMO_SIZE entradas.
+// Colisões sobrescrevem a entrada antiga (tamanho limitado, despejo implícito).
+static void gen_memo_wrapper(Node *n) {
+    const char *return_type = sauce_type_to_c(n->typeName);
+    const char *fn_name_c = get_c_fn_name(n->name);
+    Node *param_wrapper;
+    int idx;
+
+    // 1. Tipo da entrada e tabela estática
+    fprintf(outf, "\ntypedef struct { int used; ");
+    idx = 0;
+    for (param_wrapper = n->left; param_wrapper; param_wrapper = param_wrapper->right) {
+        fprintf(outf, "%s k%d; ", sauce_type_to_c(param_wrapper->left->typeName), idx++);
+    }
+    fprintf(outf, "%s val; } _memo_%s_entry;\n", return_type, fn_name_c);
+    // Com tarefas, cada thread tem a sua tabela (entradas não são escritas atomicamente)
+    fprintf(outf, "static %s_memo_%s_entry _memo_%s[SAUCE_MEMO_SIZE];\n",
+            cg_options.threads || cg_options.channels || program_uses_tasks() || program_uses_channels() ? "_Thread_local " : "", fn_name_c, fn_name_c);
+
+    // 2. Assinatura pública
+    fprintf(outf, "\n%s%s %s(", fn_c_linkage(n), return_type, fn_name_c);
+    for (param_wrapper = n->left; param_wrapper; param_wrapper = param_wrapper->right) {
+        Node *param = param_wrapper->left;
+        fprintf(outf, "%s %s%s", sauce_type_to_c(param->typeName), param->name, param_wrapper->right ? ", " : "");
+    }
+    fprintf(outf, ") {\n");
+
+    // 3. Hash da chave
+    fprintf(outf, "    unsigned long long _h = 1469598103934665603ULL;\n");
+    for (param_wrapper = n->left; param_wrapper; param_wrapper = param_wrapper->right) {
+        Node *param = param_wrapper->left;
+        if (strcmp(sauce_type_to_c(param->typeName), "double") == 0) {
+            fprintf(outf, "    _h = _sauce_memo_mix(_h, _sauce_memo_dbits(%s));\n", param->name);
+        } else {
+            fprintf(outf, "    _h = _sauce_memo_mix(_h, (unsigned long long)(long long)%s);\n", param->name);
+        }
+    }
+    fprintf(outf, "    _memo_%s_entry *_e = &_memo_%s[_h & (SAUCE_MEMO_SIZE - 1)];\n", fn_name_c, fn_name_c);
+
+    // 4. Acerto no cache
+    fprintf(outf, "    if (_e->used");
+    idx = 0;
+    for (param_wrapper = n->left; param_wrapper; param_wrapper = param_wrapper->right) {
+        fprintf(outf, " && _e->k%d == %s", idx++, param_wrapper->left->name);
+    }
+    fprintf(outf, ") return _e->val;\n");
+
+    // 5. Falha: calcula e grava (a entrada pode ter sido reutilizada pela recursão)
+    fprintf(outf, "    %s _r = %s__impl(", return_type, fn_name_c);
+    for (param_wrapper = n->left; param_wrapper; param_wrapper = param_wrapper->right) {
+        fprintf(outf, "%s%s", param_wrapper->left->name, param_wrapper->right ? ", " : "");
+    }
+    fprintf(outf, ");\n");
+    fprintf(outf, "    _e->used = 1;\n");
+    idx = 0;
+    for (param_wrapper = n->left; param_wrapper; param_wrapper = param_wrapper->right) {
+        fprintf(outf, "    _e->k%d = %s;\n", idx++, param_wrapper->left->name);
+    }
+    fprintf(outf, "    _e->val = _r;\n");
+    fprintf(outf, "    return _r;\n");
+    fprintf(outf, "}\n");
 }
 
 
 // ------------------------------------------
-// --- Ponto de Entrada Global da Geração de Código ---
+// --- Protótipos e Interfaces de Módulo ---
 // ------------------------------------------
 
-void generate_code(const char *out_c, Node *program_root) {
-    (void)program_root; 
+static void gen_prototype(Node *fn) {
+    if (fn->flags & NODE_FLAG_GENERATOR) {
+        // Gerador: o símbolo público é o construtor no heap
+        fprintf(outf, "%s_sauce_gen *_sauce_gen_%s_new(", fn_c_linkage(fn), get_c_fn_name(fn->name));
+        for (Node *p = fn->left; p; p = p->right) {
+            fprintf(outf, "%s%s", p == fn->left ? "" : ", ", sauce_type_to_c(p->left->typeName));
+        }
+        fprintf(outf, "%s) __attribute__((unused));\n", fn->left ? "" : "void");
+        return;
+    }
+    fprintf(outf, "%s%s %s(", fn_c_linkage(fn), sauce_type_to_c(fn->typeName), get_c_fn_name(fn->name));
 
-    outf = fopen(out_c, "w");
-    if (!outf) { perror("Erro ao abrir arquivo de saída"); exit(1); }
+    Node *param_wrapper = fn->left;
+    while (param_wrapper) {
+        Node *param = param_wrapper->left;
+        fprintf(outf, "%s", sauce_type_to_c(param->typeName));
+        param_wrapper = param_wrapper->right;
+        if (param_wrapper) {
+            fprintf(outf, ", ");
+        }
+    }
+    // 'unused': o dobramento de constantes pode eliminar todas as chamadas
+    fprintf(outf, ")%s __attribute__((unused));\n", fn_c_attributes(fn));
+}
+
+static void gen_prototypes() {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (fn_defs[i]->flags & NODE_FLAG_EXTERN) continue;
+        gen_prototype(fn_defs[i]);
+    }
+    fprintf(outf, "\n");
+}
+
+// Interface exportada de um módulo: protótipos das funções não-EXTERN.
+// Deve rodar depois de generate_code (tipos de retorno e efeitos já calculados).
+void generate_interface(const char *out_h, const char *guard) {
+    outf = fopen(out_h, "w");
+    if (!outf) { perror("Erro ao abrir arquivo de interface"); exit(1); }
+
+    fprintf(outf, "/* Interface gerada pelo compilador Sauce */\n");
+    fprintf(outf, "#ifndef %s\n", guard);
+    fprintf(outf, "#define %s\n\n", guard);
+    gen_prototypes();
+    fprintf(outf, "#endif\n");
+
+    fclose(outf);
+}
+
+// ------------------------------------------
+// --- Preparação da AST (comum aos backends) ---
+// ------------------------------------------
+
+// 'optimize' = 0 (builds de depuração): só o necessário para gerar código correto
+void prepare_program(int optimize) {
+    // 1. INFERÊNCIA DE TIPO DE RETORNO (Necessária antes dos protótipos)
+    stats_enter(PHASE_ANALYSIS);
+    for (int i = 0; i < fnDefCount; i++) {
+        infer_function_return_type(fn_defs[i]);
+    }
+
+    // 1.1 Análise de efeitos (pureza), usada pela memoização e pelos atributos C
+    analyze_effects();
+
+    // 1.2 Canais SPSC ou MPMC (muda a representação: roda também sem otimização)
+    analyze_channels();
+
+    if (optimize) {
+        // 1.3 Inlining de funções pequenas e puras na AST
+        inline_small_functions();
+
+        // 1.4 Avaliação de chamadas puras com argumentos constantes e de inicializadores globais
+        fold_constants();
+    }
+
+    // 1.5 Dicas de desvio vindas do perfil e funções só alcançadas por ramos frios
+    annotate_branches();
+
+    // 1.6 Funções text que devolvem valores novos: quem chama assume sem copiar
+    mark_fresh_text_results();
+    stats_leave();
+}
+
+// ------------------------------------------
+// --- Inicialização Estática de Globais ---
+// ------------------------------------------
+
+// Globais com inicializador literal viram dados estáticos em vez de atribuições
+// no início do main(). Índices: posição em global_stmts.
+static char global_static_init[MAX_FN_DEFS]; // Inicializada no próprio ponto de definição
+static char global_readonly[MAX_FN_DEFS];    // E nunca reatribuída: 'const' (text vai para .rodata)
+
+static int global_index_by_name(const char *name) {
+    for (int i = 0; i < globalSymbolCount; i++) {
+        if (strcmp(global_symbols[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static int is_literal_node(Node *n) {
+    return n && (n->kind == N_INT || n->kind == N_FLOAT || n->kind == N_BOOL || n->kind == N_STRING);
+}
+
+static int is_text_type(const char *sauce_type) {
+    return strcmp(sauce_type_to_c(sauce_type), "char*") == 0;
+}
+
+// Conta destinos (declaração, atribuição, hear, recv, next) e registra o primeiro comando global
+// que cita cada global ('stmt' = -1 dentro de funções)
+static void scan_global_uses(Node *n, int stmt, int *assigns, int *first_use) {
+    if (!n) return;
+    const char *target = NULL;
+    if (n->kind == N_VAR_ASSIGN || n->kind == N_VAR_DECL) target = n->name;
+    else if (n->kind == N_HEAR || n->kind == N_JOIN) target = n->left->name;
+    else if (n->kind == N_RECV || n->kind == N_NEXT) target = n->right->name;
+    if (target) {
+        int g = global_index_by_name(target);
+        if (g >= 0) assigns[g]++;
+    }
+    if (stmt >= 0 && (n->kind == N_VAR || n->kind == N_VAR_ASSIGN)) {
+        int g = global_index_by_name(n->name);
+        if (g >= 0 && first_use[g] > stmt) first_use[g] = stmt;
+    }
+    scan_global_uses(n->left, stmt, assigns, first_use);
+    scan_global_uses(n->mid, stmt, assigns, first_use);
+    scan_global_uses(n->right, stmt, assigns, first_use);
+}
+
+// Lida dentro de um bench: sem 'const', para o cc não dobrar a entrada medida
+static void scan_bench_reads(Node *n, char *bench_read) {
+    if (!n) return;
+    if (n->kind == N_VAR) {
+        int g = global_index_by_name(n->name);
+        if (g >= 0) bench_read[g] = 1;
+    }
+    scan_bench_reads(n->left, bench_read);
+    scan_bench_reads(n->mid, bench_read);
+    scan_bench_reads(n->right, bench_read);
+}
+
+static int contains_call(Node *n) {
+    if (!n) return 0;
+    if (n->kind == N_FN_CALL) return 1;
+    return contains_call(n->left) || contains_call(n->mid) || contains_call(n->right);
+}
+
+// Estático só se nenhum comando anterior pode observar o valor 0/NULL antigo:
+// nada antes cita a global nem chama funções (que poderiam lê-la). text só quando
+// nunca reatribuída: o literal não pode passar pelo free() das atribuições.
+static void classify_globals() {
+    int *assigns = calloc(MAX_SYMBOLS, sizeof(int));
+    int *first_use = malloc(sizeof(int) * MAX_SYMBOLS);
+    for (int g = 0; g < MAX_SYMBOLS; g++) first_use[g] = globalStmtCount;
+
+    for (int i = 0; i < fnDefCount; i++) {
+        scan_global_uses(fn_defs[i]->mid, -1, assigns, first_use);
+    }
+    char *bench_read = calloc(MAX_SYMBOLS, 1);
+    int first_call = globalStmtCount;
+    for (int i = 0; i < globalStmtCount; i++) {
+        scan_global_uses(global_stmts[i], i, assigns, first_use);
+        if (cg_options.bench && global_stmts[i]->kind == N_BENCH) scan_bench_reads(global_stmts[i]->right, bench_read);
+        if (first_call == globalStmtCount && contains_call(global_stmts[i])) first_call = i;
+    }
+
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        global_static_init[i] = 0;
+        global_readonly[i] = 0;
+        if (stmt->kind != N_VAR_DECL || !is_literal_node(stmt->left)) continue;
+
+        int g = global_index_by_name(stmt->name);
+        if (g < 0 || first_use[g] < i || first_call < i) continue;
+        global_readonly[i] = assigns[g] == 1 && !bench_read[g];
+        global_static_init[i] = global_readonly[i] || !is_text_type(stmt->typeName);
+    }
+    free(assigns);
+    free(first_use);
+    free(bench_read);
+}
+
+// Tipo C da definição/declaração da global (com const quando nunca reatribuída)
+static const char *global_c_decl_type(int stmt) {
+    const char *c_type = sauce_type_to_c(global_stmts[stmt]->typeName);
+    if (!global_readonly[stmt]) return c_type;
+    if (strcmp(c_type, "char*") == 0) return "char *const";
+    if (strcmp(c_type, "double") == 0) return "const double";
+    return "const int";
+}
+
+// ------------------------------------------
+// --- Partes Comuns do Arquivo C ---
+// ------------------------------------------
 
+static void gen_includes() {
     fprintf(outf, "/* Código C gerado pelo compilador Sauce (AST-based) */\n");
     
     // Includes
@@ -522,81 +2620,97 @@ void generate_code(const char *out_c, Node *program_root) {
     fprintf(outf, "#include <stdbool.h>\n"); // Usado indiretamente
     fprintf(outf, "#include <ctype.h>\n"); // Adicionado para manipulação de I/O
     fprintf(outf, "\n");
-    
-    // 1. INFERÊNCIA DE TIPO DE RETORNO (Necessária antes dos protótipos)
-    for (int i = 0; i < fnDefCount; i++) {
-        infer_function_return_type(fn_defs[i]);
-    }
-    
-    // 2. Protótipos de Funções
-    for (int i = 0; i < fnDefCount; i++) {
-        Node *fn = fn_defs[i];
-        fprintf(outf, "%s %s(", sauce_type_to_c(fn->typeName), get_c_fn_name(fn->name));
 
-        Node *param_wrapper = fn->left;
-        while (param_wrapper) {
-            Node *param = param_wrapper->left;
-            fprintf(outf, "%s", sauce_type_to_c(param->typeName));
-            param_wrapper = param_wrapper->right;
-            if (param_wrapper) {
-                fprintf(outf, ", ");
-            }
-        }
-        fprintf(outf, ");\n");
-    }
+    // Runtime: tipos e caminhos rápidos inline; o resto vem de libsauce_rt.a
+    fprintf(outf, "#include \"sauce_rt.h\"\n");
     fprintf(outf, "\n");
-    
-    // 3. Variáveis Globais (Declaração C no escopo global e registro de símbolo)
+}
+
+// Registra as globais em global_symbols; com 'define', emite também as definições C
+static void gen_global_variables(int define) {
     globalSymbolCount = 0; 
     
     for (int i = 0; i < globalStmtCount; i++) {
         Node *stmt = global_stmts[i];
-        if (stmt->kind == N_VAR_DECL) {
-            const char *sauce_type = stmt->typeName;
-            const char *c_type = sauce_type_to_c(sauce_type);
-            
+        if (stmt->kind == N_VAR_DECL && globalSymbolCount < MAX_SYMBOLS) {
             // Registra no símbolo global
-            if (globalSymbolCount < MAX_SYMBOLS) {
-                strcpy(global_symbols[globalSymbolCount].name, stmt->name);
-                strcpy(global_symbols[globalSymbolCount].type, sauce_type);
-                globalSymbolCount++;
-            }
-            
-            // Apenas declara e inicializa em 0/NULL
-            if (strcmp(c_type, "char*") == 0) {
-                fprintf(outf, "%s %s = NULL;\n", c_type, stmt->name);
-            } else {
-                fprintf(outf, "%s %s = 0;\n", c_type, stmt->name); 
-            }
+            strcpy(global_symbols[globalSymbolCount].name, stmt->name);
+            strcpy(global_symbols[globalSymbolCount].type, stmt->typeName);
+            globalSymbolCount++;
         }
     }
-    fprintf(outf, "\n");
-    
-    // 4. Geração de Definições de Funções (corpo)
-    for (int i = 0; i < fnDefCount; i++) {
-        gen_fn_definition(fn_defs[i]);
+    classify_globals();
+    if (!define) return;
+
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind != N_VAR_DECL) continue;
+
+        if (global_static_init[i]) {
+            // Constante de compilação: dado estático ('static const' se nunca reatribuída;
+            // nas unidades por função a ligação precisa ser externa)
+            // ('unused': o dobramento pode substituir todas as leituras pelo literal)
+            int is_static = global_readonly[i] && !unit_linkage;
+            fprintf(outf, "%s%s %s%s = ", is_static ? "static " : "", global_c_decl_type(i), stmt->name,
+                    is_static ? " __attribute__((unused))" : "");
+            gen_expr(stmt->left, NULL);
+            fprintf(outf, ";\n");
+        } else if (is_text_type(stmt->typeName)) {
+            // Apenas declara e inicializa em 0/NULL
+            fprintf(outf, "char* %s = NULL;\n", stmt->name);
+        } else {
+            fprintf(outf, "%s %s = 0;\n", sauce_type_to_c(stmt->typeName), stmt->name); 
+        }
     }
-    
-    // 5. Bloco principal (main)
+}
+
+static void gen_main_function() {
     fprintf(outf, "\nint main(void) {\n");
+    if (cg_options.profile) {
+        fprintf(outf, "    _sauce_prof_start(_sauce_prof_names, SAUCE_PROF_NFN, _sauce_prof_br_pos, _sauce_prof_br, SAUCE_PROF_NBR);\n");
+    }
     
+    // Temporários de concatenação dos comandos globais: arena liberado na saída do main
+    mainArenaTemps = 0;
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (global_stmts[i]->kind != N_BENCH && uses_concat_temps(global_stmts[i], NULL)) mainArenaTemps = 1;
+    }
+    if (mainArenaTemps) {
+        fprintf(outf, "    _sauce_arena_mark _sauce_am __attribute__((cleanup(_sauce_arena_release))) = _sauce_arena_save();\n");
+    }
+
     // Percorre todos os comandos globais na ORDEM ORIGINAL
     for (int i = 0; i < globalStmtCount; i++) {
         Node *stmt = global_stmts[i];
         
-        if (stmt->kind == N_VAR_DECL && stmt->left) {
-            // Se for N_VAR_DECL COM inicializador, geramos a ATRIBUIÇÃO (respeita a ordem global)
+        if (stmt->kind == N_VAR_DECL && is_gen_decl(stmt)) {
+            gen_line_directive(stmt);
+            gen_generator_decl(stmt, NULL, 1);
+        }
+        else if (stmt->kind == N_VAR_DECL && is_chan_decl(stmt)) {
+            // Canal global: criado na posição da declaração
+            check_chan_decl(stmt);
+            gen_line_directive(stmt);
+            fprintf(outf, "    %s = _sauce_chan_new(SAUCE_CHAN_CAPACITY, %d);\n", stmt->name,
+                    (stmt->flags & NODE_FLAG_SPSC) ? 1 : 0);
+        }
+        else if (stmt->kind == N_VAR_DECL && stmt->left && !global_static_init[i]) {
+            // Se for N_VAR_DECL COM inicializador dinâmico, geramos a ATRIBUIÇÃO (respeita a ordem global)
+            gen_line_directive(stmt);
             const char *var_name = stmt->name;
             const char *sauce_type = lookup_variable_type(var_name, NULL); 
+            check_task_value(var_name, sauce_type, stmt->left, NULL);
             
-            if (strcmp(sauce_type, "text") == 0 || strcmp(sauce_type, "string") == 0) {
-                // Atribuição de string (free + strdup)
-                fprintf(outf, "    if (%s != NULL) free(%s);\n", var_name, var_name);
-                fprintf(outf, "    %s = strdup(", var_name);
-                
-                gen_expr(stmt->left, NULL); // Sem contexto de função
-                
-                fprintf(outf, ");\n");
+            if (is_text_concat(stmt->left, NULL)) {
+                fprintf(outf, "    { char *_t = ");
+                gen_concat(stmt->left, NULL);
+                fprintf(outf, "; _sauce_text_free(%s); %s = _t; }\n", var_name, var_name);
+            } else if (strcmp(sauce_type, "text") == 0 || strcmp(sauce_type, "string") == 0) {
+                // Atribuição de string (libera a antiga + cópia)
+                fprintf(outf, "    _sauce_text_free(%s);\n", var_name);
+                fprintf(outf, "    %s = ", var_name);
+                gen_text_copy(stmt->left, NULL); // Sem contexto de função
+                fprintf(outf, ";\n");
             } else {
                 // Atribuição simples
                 fprintf(outf, "    %s = ", var_name);
@@ -610,17 +2724,209 @@ void generate_code(const char *out_c, Node *program_root) {
         }
     }
     
+    gen_line_reset();
+
+    // Estágios ainda rodando terminam antes da saída (e antes dos free abaixo)
+    if (cg_options.channels || program_uses_channels()) {
+        fprintf(outf, "    _sauce_stage_wait_all();\n");
+    }
+
     // Cleanup (free) para strings globais alocadas
     for (int i = 0; i < globalStmtCount; i++) {
         Node *stmt = global_stmts[i];
-        if (stmt->kind == N_VAR_DECL && (strcmp(stmt->typeName, "text") == 0 || strcmp(stmt->typeName, "string") == 0)) {
-            fprintf(outf, "    if (%s != NULL) free(%s);\n", stmt->name, stmt->name);
+        if (stmt->kind == N_VAR_DECL && !global_readonly[i] &&
+            (strcmp(stmt->typeName, "text") == 0 || strcmp(stmt->typeName, "string") == 0)) {
+            fprintf(outf, "    _sauce_text_free(%s);\n", stmt->name);
         }
     }
     
     // Fim do main
     fprintf(outf, "    return 0;\n");
     fprintf(outf, "}\n");
+    mainArenaTemps = 0;
+}
+
+// ------------------------------------------
+// --- Ponto de Entrada Global da Geração de Código ---
+// ------------------------------------------
+
+void generate_code(const char *out_c, Node *program_root) {
+    (void)program_root; 
+    stats_enter(PHASE_CODEGEN);
+
+    outf = fopen(out_c, "w");
+    if (!outf) { perror("Erro ao abrir arquivo de saída"); exit(1); }
+    begin_output(out_c);
+
+    gen_includes();
+
+    if (cg_options.profile) {
+        gen_profile_names();
+    }
+    
+    // 1. Inferência de tipos, efeitos e otimizações na AST
+    prepare_program(1);
 
+    if (cg_options.profile) {
+        gen_branch_profile_runtime();
+    }
+
+    textLiteralCount = 0;
+    for (int i = 0; i < fnDefCount; i++) {
+        if (!(fn_defs[i]->flags & NODE_FLAG_EXTERN)) collect_text_literals(fn_defs[i]->mid);
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        collect_text_literals(global_stmts[i]);
+    }
+    
+    // 2. Protótipos de Funções (as de outros módulos vêm das interfaces importadas)
+    if (cg_options.module_includes) {
+        fprintf(outf, "%s", cg_options.module_includes);
+    }
+    gen_prototypes();
+
+    // 2.1 Estado e construtor na pilha dos geradores definidos aqui
+    for (int i = 0; i < fnDefCount; i++) {
+        if (!(fn_defs[i]->flags & NODE_FLAG_EXTERN) && (fn_defs[i]->flags & NODE_FLAG_GENERATOR)) {
+            gen_generator_types(fn_defs[i]);
+        }
+    }
+    
+    // 3. Literais text e Variáveis Globais (Declaração C no escopo global e registro de símbolo)
+    gen_text_literals();
+    gen_global_variables(1);
+    fprintf(outf, "\n");
+
+    // 3.1 Wrappers de spawn das funções publicadas como tarefas neste arquivo
+    Node *roots[MAX_FN_DEFS * 2];
+    int root_count = 0;
+    for (int i = 0; i < fnDefCount; i++) {
+        if (!(fn_defs[i]->flags & NODE_FLAG_EXTERN)) roots[root_count++] = fn_defs[i]->mid;
+    }
+    for (int i = 0; i < globalStmtCount; i++) roots[root_count++] = global_stmts[i];
+    gen_spawn_wrappers(roots, root_count);
+    
+    // 4. Geração de Definições de Funções (corpo)
+    for (int i = 0; i < fnDefCount; i++) {
+        if (fn_defs[i]->flags & NODE_FLAG_EXTERN) continue;
+        gen_fn_definition(fn_defs[i]);
+    }
+
+    // Módulo importado: só funções, sem main()
+    if (cg_options.module_mode && !cg_options.module_is_main) {
+        stats.c_bytes += ftell(outf);
+        fclose(outf);
+        stats_leave();
+        return;
+    }
+    
+    // 4.1 Corpos dos blocos bench (apenas com --bench)
+    if (cg_options.bench) {
+        gen_bench_blocks();
+    }
+
+    // 5. Bloco principal (main)
+    gen_main_function();
+
+    stats.c_bytes += ftell(outf);
+    fclose(outf);
+    stats_leave();
+}
+
+// ------------------------------------------
+// --- Unidades por Função (servidor de compilação) ---
+// ------------------------------------------
+
+static int fn_index_by_name(const char *name) {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (strcmp(fn_defs[i]->name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// Marca as funções chamadas e as globais citadas (um local homônimo só gera um extern a mais)
+static void mark_unit_refs(Node *n, char *calls, char *globals) {
+    if (!n) return;
+    if (n->kind == N_FN_CALL) {
+        int f = fn_index_by_name(n->name);
+        if (f >= 0) calls[f] = 1;
+    } else if (n->kind == N_VAR || n->kind == N_VAR_ASSIGN) {
+        int g = global_index_by_name(n->name);
+        if (g >= 0) globals[g] = 1;
+    }
+    mark_unit_refs(n->left, calls, globals);
+    mark_unit_refs(n->mid, calls, globals);
+    mark_unit_refs(n->right, calls, globals);
+}
+
+// Uma unidade de tradução do build por função: fn >= 0 emite só fn_defs[fn];
+// fn = -1 emite as globais e o main(). Cada unidade declara apenas as funções
+// que chama e as globais que usa, então o seu texto só muda quando uma edição
+// de fato a afeta. Espera prepare_program(1) já executado.
+void generate_unit(const char *out_c, int fn) {
+    stats_enter(PHASE_CODEGEN);
+
+    outf = fopen(out_c, "w");
+    if (!outf) { perror("Erro ao abrir arquivo de saída"); exit(1); }
+    begin_output(out_c);
+
+    gen_includes();
+    textLiteralCount = 0;
+    if (fn >= 0) {
+        collect_text_literals(fn_defs[fn]->mid);
+    } else {
+        for (int i = 0; i < globalStmtCount; i++) {
+            collect_text_literals(global_stmts[i]);
+        }
+    }
+
+    unit_linkage = 1;
+    unit_fn = fn >= 0 ? fn_defs[fn] : NULL;
+    gen_global_variables(0);
+
+    char calls[MAX_FN_DEFS] = {0};
+    char globals[MAX_SYMBOLS] = {0};
+    if (fn >= 0) {
+        calls[fn] = 1;
+        mark_unit_refs(fn_defs[fn]->mid, calls, globals);
+    } else {
+        for (int i = 0; i < globalStmtCount; i++) {
+            mark_unit_refs(global_stmts[i], calls, globals);
+        }
+    }
+    for (int i = 0; i < fnDefCount; i++) {
+        if (calls[i]) gen_prototype(fn_defs[i]);
+    }
+    if (fn >= 0 && (fn_defs[fn]->flags & NODE_FLAG_GENERATOR)) {
+        gen_generator_types(fn_defs[fn]);
+    }
+    fprintf(outf, "\n");
+    gen_text_literals();
+    if (fn >= 0) {
+        gen_spawn_wrappers(&fn_defs[fn]->mid, 1);
+    } else {
+        gen_spawn_wrappers(global_stmts, globalStmtCount);
+    }
+
+    if (fn >= 0) {
+        for (int i = 0; i < globalStmtCount; i++) {
+            Node *stmt = global_stmts[i];
+            if (stmt->kind != N_VAR_DECL) continue;
+            int g = global_index_by_name(stmt->name);
+            if (globals[g]) {
+                fprintf(outf, "extern %s %s;\n", global_c_decl_type(i), stmt->name);
+                globals[g] = 0; // Redeclaração homônima: um extern basta
+            }
+        }
+        gen_fn_definition(fn_defs[fn]);
+    } else {
+        gen_global_variables(1);
+        gen_main_function();
+    }
+    unit_linkage = 0;
+    unit_fn = NULL;
+
+    stats.c_bytes += ftell(outf);
     fclose(outf);
-}
\ No newline at end of file
+    stats_leave();
+}
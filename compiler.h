@@ -15,7 +15,7 @@
 
 #define MAX_TOKEN_LEN 256
 #define MAX_SYM 1024
-#define MAX_FN_DEFS 256
+#define MAX_FN_DEFS 4096 // Também limita os comandos globais (e portanto as globais) por arquivo; = SAUCE_PROF_MAX_FN do runtime
 
 // --- Tipos de Token ---
 
@@ -33,12 +33,27 @@ typedef enum {
     TOK_AND, // and
     TOK_OR,  // or
     TOK_NOT, // not
+    TOK_MEMO, // memo (anotação de função)
+    TOK_BENCH, // bench "nome" { ... }
+    TOK_IMPORT, // import "arquivo.sauce"
+    TOK_SPAWN, // spawn f(args): inicializa uma variável task
+    TOK_JOIN,  // join(t)
+    TOK_SEND,  // send(c, expr)
+    TOK_RECV,  // recv(c, x)
+    TOK_CLOSE, // close(c)
+    TOK_STAGE, // stage f(args): roda f em uma thread própria
+    TOK_YIELD, // yield expr: transforma a função em gerador
+    TOK_NEXT,  // next(g, x)
+    TOK_LIKELY,   // if likely (cond): dica de desvio
+    TOK_UNLIKELY, // if unlikely (cond)
     
 } TokenType;
 
 typedef struct {
     TokenType type;
     char lexeme[MAX_TOKEN_LEN];
+    int line; // Posição do primeiro caractere no .sauce (1-based)
+    int col;
 } Token;
 
 /* Tipos de Nó da Abstract Syntax Tree (AST) */
@@ -61,7 +76,17 @@ typedef enum {
     N_ADD, N_SUB, N_MUL, N_DIV,
     N_GT, N_LT, N_EQ_CMP, N_NEQ, N_AND, N_OR, N_NOT,// OPERADOR UNÁRIO
     N_GTE, // Novo: Greater Than or Equal (>=)
-    N_LTE // Novo: Less Than or Equal (<=)
+    N_LTE, // Novo: Less Than or Equal (<=)
+    N_BENCH, // bench "nome" { ... } (text = nome, right = corpo)
+    N_IMPORT, // import "arquivo.sauce" (text = caminho)
+    N_SPAWN, // spawn f(args) (left = N_FN_CALL); só como valor de uma variável task
+    N_JOIN,  // join(t) (left = N_VAR da task): espera e devolve o resultado
+    N_SEND,  // send(c, expr) (left = N_VAR do canal, right = valor)
+    N_RECV,  // recv(c, x) (left = canal, right = N_VAR destino): false se fechado e vazio
+    N_CLOSE, // close(c) (left = N_VAR do canal)
+    N_STAGE, // stage f(args) (left = N_FN_CALL): estágio de pipeline em thread dedicada
+    N_YIELD, // yield expr (left = valor): suspende o gerador
+    N_NEXT   // next(g, x) (left = N_VAR do gerador, right = N_VAR destino): false quando terminou
 } NodeKind;
 
 // --- Estrutura do Nó da AST (CORRIGIDA) ---
@@ -73,12 +98,31 @@ typedef struct Node {
     
     // NOVO CAMPO: Tipo de retorno explícito (usado para return[tipo] valor)
     char explicitReturnType[MAX_TOKEN_LEN]; 
+
+    int line, col; // Posição no .sauce (comandos e funções: primeiro token; 0 = nó sintético)
+    int flags;   // Anotações do parser (NODE_FLAG_*)
+    int effects; // Efeitos calculados pela análise (FX_*), apenas em N_FN_DEF
     
     struct Node *left;  // Expressão / Parâmetros
     struct Node *mid;   // Corpo da função / Bloco ELSE
     struct Node *right; // Próximo na lista / Bloco THEN
 } Node;
 
+// Anotações de nó (campo 'flags')
+#define NODE_FLAG_MEMO (1 << 0) // memo fn ...: memoização explícita
+#define NODE_FLAG_EXTERN (1 << 1) // Função definida em outro módulo (só protótipo)
+#define NODE_FLAG_CHAN_SEND   (1 << 2) // Parâmetro canal: a função envia por ele (na própria thread)
+#define NODE_FLAG_CHAN_RECV   (1 << 3) // Parâmetro canal: a função recebe dele
+#define NODE_FLAG_CHAN_ESCAPE (1 << 4) // Parâmetro canal: vai para outras threads (spawn/stage)
+#define NODE_FLAG_SPSC        (1 << 5) // Declaração de canal com no máximo um produtor e um consumidor
+#define NODE_FLAG_GENERATOR   (1 << 6) // Função com 'yield': a chamada cria um gen<T>
+#define NODE_FLAG_LIKELY      (1 << 7) // if likely (...): o ramo 'then' é o quente
+#define NODE_FLAG_UNLIKELY    (1 << 8) // if unlikely (...): o ramo 'then' é o frio
+#define NODE_FLAG_PROF_LIKELY   (1 << 9)  // Mesma dica, deduzida do perfil (--use-profile)
+#define NODE_FLAG_PROF_UNLIKELY (1 << 10)
+#define NODE_FLAG_COLD        (1 << 11) // Função só alcançada por caminhos frios: __attribute__((cold))
+#define NODE_FLAG_FRESH_TEXT  (1 << 12) // Função text cujo resultado ninguém mais guarda: quem chama assume sem copiar
+
 // --- Prototipos da AST (CORRIGIDOS) ---
 
 // Funções de utilidade para a AST
@@ -97,11 +141,115 @@ extern int fnDefCount;
 extern Node *global_stmts[MAX_FN_DEFS];
 extern int globalStmtCount;
 
+// Análise de Efeitos (analysis.c)
+#define FX_IO             (1 << 0) // say / hear
+#define FX_WRITES_GLOBAL  (1 << 1) // atribui a variável global (diretamente ou via chamadas)
+#define FX_READS_GLOBAL   (1 << 2) // lê variável global
+#define FX_CALLS_IMPURE   (1 << 3) // chama função impura ou desconhecida
+#define FX_SELF_RECURSIVE (1 << 4) // chama a si mesma fora de posição de cauda
+#define FX_SPAWNS         (1 << 5) // cria tarefas (spawn): nunca é pura
+#define FX_YIELDS         (1 << 6) // gerador: a chamada cria estado mutável
+
+void analyze_effects();
+int fn_is_pure(Node *fn_def);  // sem E/S, sem escrita global, só chama funções puras
+int fn_is_const(Node *fn_def); // pura e sem leitura de globais
+int fn_should_memoize(Node *fn_def);
+int ast_size(Node *n);
+int uses_tasks(Node *n);    // A subárvore contém spawn/join
+int program_uses_tasks();   // Alguma função ou comando global usa spawn/join (runtime de threads)
+int uses_channels(Node *n); // A subárvore usa canais (send/recv/close/stage ou declaração chan<T>)
+int program_uses_channels();
+void analyze_channels();    // Marca NODE_FLAG_SPSC nas declarações de canal (depois de analyze_effects)
+int uses_generators(Node *n); // A subárvore usa geradores (yield/next ou tipo gen<T>)
+int program_uses_generators();
+
+// Otimizações na AST (optimize.c)
+void inline_small_functions();
+void annotate_branches(); // Dicas do perfil (cg_options.branch_profile) e funções frias
+int if_branch_hint(Node *if_node); // 1: 'then' quente, -1: 'then' frio, 0: sem dica
+
+// Avaliação em tempo de compilação (consteval.c)
+void fold_constants();
+
+// Utilidades semânticas (codegen.c)
+const char *sauce_type_to_c(const char *sauce_type);
+const char *get_expr_type(Node *expr, Node *fn_context);
+
+// Auto-profiling do compilador (stats.c)
+typedef enum {
+    PHASE_READ, PHASE_LEX, PHASE_PARSE, PHASE_ANALYSIS, PHASE_CODEGEN, PHASE_CC,
+    PHASE_COUNT
+} Phase;
+
+typedef struct {
+    double phase_time[PHASE_COUNT]; // Segundos (exclusivos) por fase
+    long source_bytes;
+    long tokens;
+    long ast_nodes;
+    long ast_bytes;
+    long symbol_lookups;
+    long c_bytes;
+} CompilerStats;
+
+extern CompilerStats stats;
+extern int stats_enabled; // Liga a medição de tempo (contadores são sempre atualizados)
+
+void stats_enter(Phase phase);
+void stats_leave();
+void stats_report(FILE *out, int timings, int counters, int json);
+
 // Prototipos da Geração de Código
+typedef struct {
+    int profile; // --profile: hooks de entrada/saída e relatório por função
+    int bench;   // --bench: executa blocos 'bench' (removidos em builds normais)
+    int line_directives;     // -g: '#line' de volta ao .sauce (perf, gdb, flamegraphs)
+    int minimal_io;          // --static: say/hear por read/write no runtime, sem stdio
+    const char *source_file; // Caminho do .sauce usado nos '#line'
+    const char *branch_profile; // --use-profile: contagens de desvios de uma execução com --profile
+
+    // Compilação por módulos (module.c)
+    int module_mode;             // Funções com ligação externa, sem corpos de NODE_FLAG_EXTERN
+    int module_is_main;          // Emite o main() do C
+    const char *module_includes; // Linhas #include das interfaces importadas
+    int threads;                 // Algum módulo usa spawn/join: estado do runtime por thread
+    int channels;                // Algum módulo usa canais/stage: o main espera os estágios
+} CodegenOptions;
+
+extern CodegenOptions cg_options;
+
+void prepare_program(int optimize); // Tipos de retorno, efeitos e (se optimize) inlining e dobramento
 void generate_code(const char *out_c, Node *program_root);
+void generate_interface(const char *out_h, const char *guard);
+void generate_unit(const char *out_c, int fn); // Build por função: fn_defs[fn], ou -1 para globais + main()
+
+// Backend x86-64 direto (asmgen.c)
+void generate_asm(const char *out_s);
+
+// Bytecode + interpretador para 'sauce run' (vm.c)
+int vm_run_program(); // Retorna o código de saída do programa
+
+// Módulos (module.c)
+int program_has_imports();
+int build_modules(const char *main_file, const char *cc_flags, int jobs, const char *outfile);
+int run_commands_parallel(char **cmds, int count, int jobs); // 1 se todos terminaram com sucesso
+char *read_file(const char *path);                            // Conteúdo inteiro (malloc) ou NULL
+int file_exists(const char *path);
+int replace_if_changed(const char *tmp, const char *path);    // 1 se o conteúdo mudou
+int write_if_changed(const char *path, const char *content);  // Idem, com o conteúdo em memória
+
+// Servidor de compilação (server.c)
+int load_source(const char *path); // Lê e parseia um .sauce (AST em cache no servidor); 0 se não leu
+int server_main(const char *socket_path, int (*driver)(int argc, char **argv));
+int server_request(const char *socket_path, int argc, char **argv); // < 0: servidor indisponível
+int server_worker_active();
+int build_function_units(const char *cc_flags, int jobs, const char *outfile);
+
+// Driver (main.c)
+const char *runtime_dir(); // Onde estão runtime/sauce_rt.h e libsauce_rt.a (SAUCE_RT_DIR ou o dir. do compilador)
 
 // Lexer (Prototipos existentes)
 void parse_all();
+void parse_program(); // Só constrói a AST (sem gerar código)
 extern Token curtok;
 Token next_token();
 void lexer_init_from_string(const char* s);
@@ -0,0 +1,588 @@
+// consteval.c -- Avaliação em tempo de compilação (interpretador da AST)
+//
+// Chamadas a funções 'const' com argumentos literais e expressões formadas só
+// por literais são avaliadas aqui e substituídas pelo literal resultante.
+// A semântica segue a do C gerado (int de 32 bits, double, conversões implícitas);
+// qualquer caso duvidoso (divisão por zero, ordem ou concatenação de text,
+// estouro de orçamento) simplesmente desiste e mantém a expressão original.
+
+#include "compiler.h"
+#include <limits.h>
+#include <math.h>
+
+#define INTERP_STEP_BUDGET 1000000 // Passos por tentativa de avaliação
+#define INTERP_MAX_DEPTH 512       // Profundidade máxima de chamadas
+#define INTERP_MAX_BINDINGS 4096   // Variáveis vivas (todas as chamadas)
+
+typedef enum { V_INT, V_FLOAT, V_BOOL, V_TEXT } ValueKind;
+
+typedef struct {
+    ValueKind kind;
+    int i;         // V_INT e V_BOOL
+    double f;      // V_FLOAT
+    const char *s; // V_TEXT (aponta para o texto de um nó N_STRING)
+} Value;
+
+typedef struct {
+    const char *name;
+    Value val;
+} Binding;
+
+static Binding bindings[INTERP_MAX_BINDINGS];
+static int bindingCount = 0;
+static int frameBase = 0; // Início das variáveis da chamada atual
+static long steps = 0;
+static int depth = 0;
+
+// Resultado da execução de comandos
+enum { EXEC_FAIL, EXEC_NEXT, EXEC_RETURN };
+
+static int eval(Node *n, Value *out);
+
+// --- Utilidades ---
+
+static Node *find_fn(const char *name) {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (strcmp(fn_defs[i]->name, name) == 0) return fn_defs[i];
+    }
+    return NULL;
+}
+
+static int tick() {
+    return --steps > 0;
+}
+
+static Binding *lookup(const char *name) {
+    for (int i = bindingCount - 1; i >= frameBase; i--) {
+        if (strcmp(bindings[i].name, name) == 0) return &bindings[i];
+    }
+    return NULL;
+}
+
+static int bind(const char *name, Value v) {
+    if (bindingCount >= INTERP_MAX_BINDINGS) return 0;
+    bindings[bindingCount].name = name;
+    bindings[bindingCount].val = v;
+    bindingCount++;
+    return 1;
+}
+
+// Aritmética de int em 32 bits com wrap (evita UB no próprio compilador)
+static int wrap_int(long long v) {
+    return (int)(unsigned int)(unsigned long long)v;
+}
+
+static int is_numeric(Value v) {
+    return v.kind == V_INT || v.kind == V_BOOL || v.kind == V_FLOAT;
+}
+
+static double as_double(Value v) {
+    return v.kind == V_FLOAT ? v.f : (double)v.i;
+}
+
+// Conversão implícita para um tipo Sauce (parâmetro, declaração, retorno)
+static int coerce(Value *v, const char *sauce_type) {
+    const char *c_type = sauce_type_to_c(sauce_type);
+
+    if (strcmp(c_type, "char*") == 0) {
+        return v->kind == V_TEXT;
+    }
+    if (v->kind == V_TEXT) return 0;
+
+    if (strcmp(c_type, "double") == 0) {
+        v->f = as_double(*v);
+        v->kind = V_FLOAT;
+        return 1;
+    }
+    if (strcmp(c_type, "int") == 0) {
+        if (v->kind == V_FLOAT) {
+            if (!(v->f > (double)INT_MIN - 1.0 && v->f < (double)INT_MAX + 1.0)) return 0;
+            v->i = (int)v->f;
+        }
+        int is_bool = strcmp(sauce_type, "boolean") == 0 || strcmp(sauce_type, "bool") == 0;
+        v->kind = is_bool ? V_BOOL : V_INT;
+        return 1;
+    }
+    return 0;
+}
+
+static int truthy(Value v, int *out) {
+    if (v.kind == V_TEXT) return 0;
+    *out = v.kind == V_FLOAT ? v.f != 0.0 : v.i != 0;
+    return 1;
+}
+
+// ------------------------------------------
+// --- Expressões ---
+// ------------------------------------------
+
+static int eval_binary(Node *n, Value *out) {
+    Value l, r;
+
+    // and/or com curto-circuito, como no C
+    if (n->kind == N_AND || n->kind == N_OR) {
+        int lt, rt;
+        if (!eval(n->left, &l) || !truthy(l, &lt)) return 0;
+        out->kind = V_BOOL;
+        if (n->kind == N_AND && !lt) { out->i = 0; return 1; }
+        if (n->kind == N_OR && lt) { out->i = 1; return 1; }
+        if (!eval(n->right, &r) || !truthy(r, &rt)) return 0;
+        out->i = rt;
+        return 1;
+    }
+
+    if (!eval(n->left, &l) || !eval(n->right, &r)) return 0;
+
+    // text: só igualdade (o conteúdo é o texto do nó; com escapes, textos diferentes
+    // ainda podem ser iguais depois da interpretação do C: desiste)
+    if (l.kind == V_TEXT && r.kind == V_TEXT && (n->kind == N_EQ_CMP || n->kind == N_NEQ)) {
+        int same = strcmp(l.s, r.s) == 0;
+        if (!same && (strchr(l.s, '\\') || strchr(r.s, '\\'))) return 0;
+        out->kind = V_BOOL;
+        out->i = (n->kind == N_EQ_CMP) == same;
+        return 1;
+    }
+    if (!is_numeric(l) || !is_numeric(r)) return 0; // text: concatenação/ordem não são avaliadas
+
+    int use_float = l.kind == V_FLOAT || r.kind == V_FLOAT;
+
+    switch (n->kind) {
+        case N_ADD: case N_SUB: case N_MUL: case N_DIV:
+            if (use_float) {
+                double a = as_double(l), b = as_double(r);
+                out->kind = V_FLOAT;
+                if (n->kind == N_ADD) out->f = a + b;
+                else if (n->kind == N_SUB) out->f = a - b;
+                else if (n->kind == N_MUL) out->f = a * b;
+                else out->f = a / b;
+                return isfinite(out->f);
+            }
+            out->kind = V_INT;
+            if (n->kind == N_ADD) out->i = wrap_int((long long)l.i + r.i);
+            else if (n->kind == N_SUB) out->i = wrap_int((long long)l.i - r.i);
+            else if (n->kind == N_MUL) out->i = wrap_int((long long)l.i * r.i);
+            else {
+                if (r.i == 0 || (l.i == INT_MIN && r.i == -1)) return 0;
+                out->i = l.i / r.i;
+            }
+            return 1;
+
+        default: {
+            out->kind = V_BOOL;
+            double a = as_double(l), b = as_double(r);
+            if (n->kind == N_GT) out->i = use_float ? a > b : l.i > r.i;
+            else if (n->kind == N_LT) out->i = use_float ? a < b : l.i < r.i;
+            else if (n->kind == N_GTE) out->i = use_float ? a >= b : l.i >= r.i;
+            else if (n->kind == N_LTE) out->i = use_float ? a <= b : l.i <= r.i;
+            else if (n->kind == N_EQ_CMP) out->i = use_float ? a == b : l.i == r.i;
+            else if (n->kind == N_NEQ) out->i = use_float ? a != b : l.i != r.i;
+            else return 0;
+            return 1;
+        }
+    }
+}
+
+static int exec_block(Node *block, Node *fn, Value *ret);
+
+static int eval_call(Node *call, Value *out) {
+    Node *fn = find_fn(call->name);
+    if (!fn || !fn_is_const(fn)) return 0;
+    if (fn->flags & NODE_FLAG_EXTERN) return 0; // Corpo de outro módulo pode mudar sem recompilar este
+    if (strcmp(sauce_type_to_c(fn->typeName), "void") == 0) return 0;
+    if (depth >= INTERP_MAX_DEPTH) return 0;
+
+    // Avalia os argumentos no frame do chamador
+    Value args[64];
+    int argc = 0;
+    Node *p = fn->left, *a = call->left;
+    while (p && a) {
+        if (argc >= 64 || !eval(a->left, &args[argc])) return 0;
+        if (!coerce(&args[argc], p->left->typeName)) return 0;
+        argc++;
+        p = p->right;
+        a = a->right;
+    }
+    if (p || a) return 0;
+
+    // Novo frame
+    int saved_base = frameBase, saved_count = bindingCount;
+    frameBase = bindingCount;
+    depth++;
+
+    int ok = 1;
+    p = fn->left;
+    for (int i = 0; i < argc; i++, p = p->right) {
+        if (!bind(p->left->name, args[i])) { ok = 0; break; }
+    }
+
+    Value ret;
+    int status = ok ? exec_block(fn->mid, fn, &ret) : EXEC_FAIL;
+
+    depth--;
+    frameBase = saved_base;
+    bindingCount = saved_count;
+
+    if (status == EXEC_FAIL) return 0;
+    if (status == EXEC_NEXT) {
+        // Retorno de segurança do codegen (0 / 0.0 / NULL)
+        ret.kind = V_INT;
+        ret.i = 0;
+        if (strcmp(sauce_type_to_c(fn->typeName), "char*") == 0) return 0;
+    }
+    if (!coerce(&ret, fn->typeName)) return 0;
+    *out = ret;
+    return 1;
+}
+
+static int eval(Node *n, Value *out) {
+    if (!n || !tick()) return 0;
+
+    switch (n->kind) {
+        case N_INT: {
+            long long v = strtoll(n->text, NULL, 10);
+            if (v > INT_MAX || v < INT_MIN) return 0;
+            out->kind = V_INT;
+            out->i = (int)v;
+            return 1;
+        }
+        case N_FLOAT:
+            out->kind = V_FLOAT;
+            out->f = strtod(n->text, NULL);
+            return 1;
+        case N_BOOL:
+            out->kind = V_BOOL;
+            out->i = strcmp(n->text, "true") == 0;
+            return 1;
+        case N_STRING:
+            out->kind = V_TEXT;
+            out->s = n->text;
+            return 1;
+
+        case N_VAR: {
+            Binding *b = lookup(n->name);
+            if (!b || (b->val.kind == V_TEXT && !b->val.s)) return 0;
+            *out = b->val;
+            return 1;
+        }
+
+        case N_NOT: {
+            Value v;
+            int t;
+            if (!eval(n->left, &v) || !truthy(v, &t)) return 0;
+            out->kind = V_BOOL;
+            out->i = !t;
+            return 1;
+        }
+
+        case N_FN_CALL:
+            return eval_call(n, out);
+
+        case N_ADD: case N_SUB: case N_MUL: case N_DIV:
+        case N_GT: case N_LT: case N_EQ_CMP: case N_NEQ:
+        case N_GTE: case N_LTE: case N_AND: case N_OR:
+            return eval_binary(n, out);
+
+        default:
+            return 0;
+    }
+}
+
+// ------------------------------------------
+// --- Comandos ---
+// ------------------------------------------
+
+static int exec_stmt(Node *n, Node *fn, Value *ret) {
+    if (!n || !tick()) return EXEC_FAIL;
+
+    switch (n->kind) {
+        case N_VAR_DECL: {
+            Value v;
+            if (n->left) {
+                if (!eval(n->left, &v)) return EXEC_FAIL;
+            } else {
+                v.kind = V_INT;
+                v.i = 0;
+                v.f = 0.0;
+                v.s = NULL;
+                if (strcmp(sauce_type_to_c(n->typeName), "char*") == 0) v.kind = V_TEXT;
+            }
+            if (!coerce(&v, n->typeName) || !bind(n->name, v)) return EXEC_FAIL;
+            return EXEC_NEXT;
+        }
+
+        case N_VAR_ASSIGN: {
+            Binding *b = lookup(n->name);
+            if (!b) return EXEC_FAIL; // Atribuição a global: não é 'const'
+            Value v;
+            if (!eval(n->left, &v)) return EXEC_FAIL;
+            ValueKind declared = b->val.kind;
+            const char *type = declared == V_TEXT ? "text" : declared == V_FLOAT ? "float" :
+                               declared == V_BOOL ? "boolean" : "int";
+            if (!coerce(&v, type)) return EXEC_FAIL;
+            b->val = v;
+            return EXEC_NEXT;
+        }
+
+        case N_IF: {
+            Value c;
+            int t;
+            if (!eval(n->left, &c) || !truthy(c, &t)) return EXEC_FAIL;
+            Node *branch = t ? n->right : n->mid;
+            if (!branch) return EXEC_NEXT;
+            if (branch->kind == N_IF) return exec_stmt(branch, fn, ret); // else if
+            return exec_block(branch, fn, ret);
+        }
+
+        case N_RETURN:
+            if (!eval(n->left, ret)) return EXEC_FAIL;
+            if (n->explicitReturnType[0] != '\0' && !coerce(ret, n->explicitReturnType)) return EXEC_FAIL;
+            return EXEC_RETURN;
+
+        case N_EXPR_STMT: {
+            Value ignored;
+            return eval(n->left, &ignored) ? EXEC_NEXT : EXEC_FAIL;
+        }
+
+        default:
+            return EXEC_FAIL; // say/hear e afins nunca são avaliados
+    }
+}
+
+// Blocos C têm escopo próprio: declarações internas somem ao sair
+static int exec_block(Node *block, Node *fn, Value *ret) {
+    int saved_count = bindingCount;
+    int status = EXEC_NEXT;
+    for (Node *w = block; w && status == EXEC_NEXT; w = w->right) {
+        status = exec_stmt(w->left, fn, ret);
+    }
+    bindingCount = saved_count;
+    return status;
+}
+
+// ------------------------------------------
+// --- Dobramento na AST ---
+// ------------------------------------------
+
+static int is_literal(Node *n) {
+    return n && (n->kind == N_INT || n->kind == N_FLOAT || n->kind == N_BOOL || n->kind == N_STRING);
+}
+
+static int is_foldable_kind(NodeKind k) {
+    switch (k) {
+        case N_FN_CALL: case N_NOT:
+        case N_ADD: case N_SUB: case N_MUL: case N_DIV:
+        case N_GT: case N_LT: case N_EQ_CMP: case N_NEQ:
+        case N_GTE: case N_LTE: case N_AND: case N_OR:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int operands_are_literals(Node *n) {
+    if (n->kind == N_FN_CALL) {
+        for (Node *a = n->left; a; a = a->right) {
+            if (!is_literal(a->left)) return 0;
+        }
+        return 1;
+    }
+    if (n->kind == N_NOT) return is_literal(n->left);
+    return is_literal(n->left) && is_literal(n->right);
+}
+
+static Node *value_to_literal(Value v) {
+    char buf[64];
+    switch (v.kind) {
+        case V_INT:
+            if (v.i == INT_MIN) return NULL; // -2147483648 não é um literal int em C
+            snprintf(buf, sizeof(buf), "%d", v.i);
+            return make_node(N_INT, NULL, buf, NULL, NULL, NULL);
+        case V_BOOL:
+            if (v.i != 0 && v.i != 1) return NULL;
+            return make_node(N_BOOL, NULL, v.i ? "true" : "false", NULL, NULL, NULL);
+        case V_FLOAT:
+            if (!isfinite(v.f)) return NULL;
+            snprintf(buf, sizeof(buf), "%.17g", v.f);
+            // Garante que o C leia como double
+            if (!strchr(buf, '.') && !strchr(buf, 'e')) strcat(buf, ".0");
+            return make_node(N_FLOAT, NULL, buf, NULL, NULL, NULL);
+        case V_TEXT:
+            return v.s ? make_node(N_STRING, NULL, v.s, NULL, NULL, NULL) : NULL;
+    }
+    return NULL;
+}
+
+static Node *try_fold(Node *n) {
+    Value v;
+    steps = INTERP_STEP_BUDGET;
+    depth = 0;
+    bindingCount = 0;
+    frameBase = 0;
+    if (!eval(n, &v)) return NULL;
+    return value_to_literal(v);
+}
+
+// Pós-ordem: dobra primeiro os filhos, depois o próprio nó se os operandos viraram literais.
+// O resultado de N_EXPR_STMT é descartado, então a chamada não é substituída.
+static void fold_tree(Node **slot) {
+    Node *n = *slot;
+    if (!n) return;
+
+    // spawn/stage precisam da chamada: só os argumentos são dobrados
+    if (n->kind == N_SPAWN || n->kind == N_STAGE) {
+        fold_tree(&n->left->left);
+        return;
+    }
+
+    fold_tree(&n->left);
+    fold_tree(&n->mid);
+    fold_tree(&n->right);
+
+    if (n->kind == N_EXPR_STMT) return;
+
+    if (is_foldable_kind(n->kind) && operands_are_literals(n)) {
+        Node *lit = try_fold(n);
+        if (lit) *slot = lit;
+    }
+}
+
+// N_EXPR_STMT: dobra só os argumentos da chamada
+static void fold_stmt_tree(Node **slot) {
+    Node *n = *slot;
+    if (!n) return;
+    if (n->kind == N_EXPR_STMT && n->left && n->left->kind == N_FN_CALL) {
+        fold_tree(&n->left->left);
+        return;
+    }
+    if (n->kind == N_STMT_LIST) {
+        fold_stmt_tree(&n->left);
+        fold_stmt_tree(&n->right);
+        return;
+    }
+    // Blocos bench medem o código como escrito
+    if (n->kind == N_BENCH) return;
+    if (n->kind == N_IF) {
+        fold_tree(&n->left);
+        fold_stmt_tree(&n->mid);
+        fold_stmt_tree(&n->right);
+        return;
+    }
+    fold_tree(slot);
+}
+
+// --- Globais constantes ---
+
+// Quantas vezes cada nome é destino de declaração, atribuição, hear, join, recv ou next no programa.
+// Tabela hash (endereçamento aberto) para não percorrer a AST inteira por global.
+typedef struct {
+    const char *name;
+    int count;
+} AssignCount;
+
+static AssignCount *assign_table = NULL;
+static size_t assign_capacity = 0;
+
+static size_t count_assign_targets(Node *n) {
+    if (!n) return 0;
+    size_t self = (n->kind == N_VAR_ASSIGN || n->kind == N_VAR_DECL || n->kind == N_HEAR || n->kind == N_JOIN ||
+                   n->kind == N_RECV || n->kind == N_NEXT) ? 1 : 0;
+    return self + count_assign_targets(n->left) + count_assign_targets(n->mid) + count_assign_targets(n->right);
+}
+
+static AssignCount *assign_slot(const char *name) {
+    size_t h = 5381;
+    for (const char *c = name; *c; c++) h = h * 33 + (unsigned char)*c;
+    for (size_t i = h & (assign_capacity - 1);; i = (i + 1) & (assign_capacity - 1)) {
+        if (!assign_table[i].name || strcmp(assign_table[i].name, name) == 0) return &assign_table[i];
+    }
+}
+
+// delta = +1 registra os destinos da árvore, -1 os remove
+static void tally_assigns(Node *n, int delta) {
+    if (!n) return;
+    const char *target = NULL;
+    if (n->kind == N_VAR_ASSIGN || n->kind == N_VAR_DECL) target = n->name;
+    else if (n->kind == N_HEAR || n->kind == N_JOIN) target = n->left->name;
+    else if (n->kind == N_RECV || n->kind == N_NEXT) target = n->right->name;
+    if (target) {
+        AssignCount *slot = assign_slot(target);
+        slot->name = target;
+        slot->count += delta;
+    }
+    tally_assigns(n->left, delta);
+    tally_assigns(n->mid, delta);
+    tally_assigns(n->right, delta);
+}
+
+static void build_assign_table() {
+    size_t total = 0;
+    for (int i = 0; i < globalStmtCount; i++) total += count_assign_targets(global_stmts[i]);
+    for (int i = 0; i < fnDefCount; i++) total += count_assign_targets(fn_defs[i]->mid);
+
+    assign_capacity = 16;
+    while (assign_capacity < 2 * total) assign_capacity *= 2;
+    assign_table = calloc(assign_capacity, sizeof(AssignCount));
+    if (!assign_table) { perror("calloc"); exit(1); }
+
+    for (int i = 0; i < globalStmtCount; i++) tally_assigns(global_stmts[i], 1);
+    for (int i = 0; i < fnDefCount; i++) tally_assigns(fn_defs[i]->mid, 1);
+}
+
+// Global escalar inicializada com literal e nunca reatribuída (nem por hear, nem
+// por outra declaração). Funções podem declarar locais com o mesmo nome, então
+// qualquer N_VAR_DECL homônimo também a desqualifica (conservador).
+// A própria declaração é o único destino permitido (inicializador literal não tem filhos).
+static int is_constant_global(int decl_index) {
+    Node *decl = global_stmts[decl_index];
+    if (decl->kind != N_VAR_DECL || !is_literal(decl->left)) return 0;
+    if (strcmp(sauce_type_to_c(decl->typeName), "char*") == 0) return 0;
+    return assign_slot(decl->name)->count == 1;
+}
+
+// Substitui leituras da global constante nos comandos globais seguintes
+static void propagate_global(Node **slot, Node *decl) {
+    Node *n = *slot;
+    if (!n) return;
+    if (n->kind == N_VAR && strcmp(n->name, decl->name) == 0) {
+        Value v;
+        Node *lit = NULL;
+        steps = INTERP_STEP_BUDGET;
+        if (eval(decl->left, &v) && coerce(&v, decl->typeName)) lit = value_to_literal(v);
+        if (lit) *slot = lit;
+        return;
+    }
+    if (n->kind == N_BENCH) return; // Blocos bench medem o código como escrito
+    // hear(x), join(t), recv(c, x) e next(g, x) precisam do N_VAR como destino (e close(c) como canal)
+    if (n->kind == N_HEAR || n->kind == N_JOIN || n->kind == N_RECV || n->kind == N_NEXT || n->kind == N_CLOSE) return;
+    if (n->kind == N_SEND) { // O canal também precisa continuar um N_VAR
+        propagate_global(&n->right, decl);
+        return;
+    }
+    propagate_global(&n->left, decl);
+    propagate_global(&n->mid, decl);
+    propagate_global(&n->right, decl);
+}
+
+// Deve rodar depois de analyze_effects() e do inlining
+void fold_constants() {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (fn_defs[i]->flags & NODE_FLAG_EXTERN) continue;
+        fold_stmt_tree(&fn_defs[i]->mid);
+    }
+
+    // Comandos globais em ordem: globais constantes alimentam os inicializadores seguintes.
+    // O dobramento pode eliminar ramos (e atribuições): a contagem do comando é refeita.
+    build_assign_table();
+    for (int i = 0; i < globalStmtCount; i++) {
+        tally_assigns(global_stmts[i], -1);
+        fold_stmt_tree(&global_stmts[i]);
+        tally_assigns(global_stmts[i], 1);
+        if (is_constant_global(i)) {
+            for (int j = i + 1; j < globalStmtCount; j++) {
+                propagate_global(&global_stmts[j], global_stmts[i]);
+            }
+        }
+    }
+    free(assign_table);
+    assign_table = NULL;
+}
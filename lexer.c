@@ -2,6 +2,8 @@
 
 static const char *SRC = NULL;
 static int POS = 0;
+static int LINE = 1; // Posição do próximo caractere
+static int COL = 1;
 
 static int peek() {
     return SRC[POS];
@@ -11,6 +13,12 @@ static int nextchar() {
     int c = SRC[POS];
     if (c != '\0')
         POS++;
+    if (c == '\n') {
+        LINE++;
+        COL = 1;
+    } else if (c != '\0') {
+        COL++;
+    }
     return c;
 }
 
@@ -29,14 +37,28 @@ static void skip_spaces() {
 void lexer_init_from_string(const char *s) {
     SRC = s;
     POS = 0;
+    LINE = 1;
+    COL = 1;
 }
 
+static Token lex_token();
+
 Token next_token() {
+    stats_enter(PHASE_LEX);
+    Token tok = lex_token();
+    stats_leave();
+    stats.tokens++;
+    return tok;
+}
+
+static Token lex_token() {
     Token tok;
     tok.lexeme[0] = '\0';
     tok.type = TOK_EOF;
 
     skip_spaces();
+    tok.line = LINE;
+    tok.col = COL;
 
     int c = peek();
 
@@ -80,11 +102,27 @@ Token next_token() {
         else if (strcmp(tok.lexeme, "and") == 0) { tok.type = TOK_AND; return tok; }
         else if (strcmp(tok.lexeme, "or") == 0) { tok.type = TOK_OR; return tok; }
         else if (strcmp(tok.lexeme, "not") == 0) { tok.type = TOK_NOT; return tok; }
+        else if (strcmp(tok.lexeme, "memo") == 0) { tok.type = TOK_MEMO; return tok; }
+        else if (strcmp(tok.lexeme, "bench") == 0) { tok.type = TOK_BENCH; return tok; }
+        else if (strcmp(tok.lexeme, "import") == 0) { tok.type = TOK_IMPORT; return tok; }
+        else if (strcmp(tok.lexeme, "spawn") == 0) { tok.type = TOK_SPAWN; return tok; }
+        else if (strcmp(tok.lexeme, "join") == 0) { tok.type = TOK_JOIN; return tok; }
+        else if (strcmp(tok.lexeme, "send") == 0) { tok.type = TOK_SEND; return tok; }
+        else if (strcmp(tok.lexeme, "recv") == 0) { tok.type = TOK_RECV; return tok; }
+        else if (strcmp(tok.lexeme, "close") == 0) { tok.type = TOK_CLOSE; return tok; }
+        else if (strcmp(tok.lexeme, "stage") == 0) { tok.type = TOK_STAGE; return tok; }
+        else if (strcmp(tok.lexeme, "yield") == 0) { tok.type = TOK_YIELD; return tok; }
+        else if (strcmp(tok.lexeme, "next") == 0) { tok.type = TOK_NEXT; return tok; }
+        else if (strcmp(tok.lexeme, "likely") == 0) { tok.type = TOK_LIKELY; return tok; }
+        else if (strcmp(tok.lexeme, "unlikely") == 0) { tok.type = TOK_UNLIKELY; return tok; }
         // types
         else if (!strcmp(tok.lexeme, "int") ||
             !strcmp(tok.lexeme, "float") ||
             !strcmp(tok.lexeme, "text") ||
-            !strcmp(tok.lexeme, "boolean"))
+            !strcmp(tok.lexeme, "boolean") ||
+            !strcmp(tok.lexeme, "task") ||
+            !strcmp(tok.lexeme, "chan") ||
+            !strcmp(tok.lexeme, "gen"))
         {
             tok.type = TOK_TYPE;
             return tok;
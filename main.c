@@ -1,46 +1,390 @@
 // compiler.c -- Orquestra o Lexer, Parser e Codegen (Fluxo AST)
 
 #include "compiler.h"
+#include <time.h>
+#include <unistd.h>
 
-#define MAX_SRC 65536
+#define MAX_CMD 4096
+#define PGO_DIR "sauce-pgo"
+#define PGO_TIMING_RUNS 3
 
 extern void lexer_init_from_string(const char*);
 // extern Token next_token(); // Não é necessário aqui, usado por advance()
 // extern void cg_finalize(); // Não é mais necessário no fluxo AST
 // extern void parse_all(); // Protótipo já está em compiler.h
 
-int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Uso: %s file.sauce\n", argv[0]);
-        return 1;
+// --- Opções do Driver ---
+typedef struct {
+    const char *infile;
+    const char *outfile;   // -o <arquivo> (padrão: app)
+    int opt_level;         // -O0 ... -O3 (padrão: 2)
+    int native;            // -march=native
+    int lto;               // -flto
+    int debug_info;        // -g: '#line' para o .sauce, símbolos e frame pointers (perf/gdb)
+    int static_link;       // --static: link estático, GC de seções, sem símbolos e say/hear sem stdio
+    const char *pgo_input; // --pgo <entrada de treino>
+    int profile;           // --profile
+    const char *use_profile; // --use-profile <sauce-profile.branches>
+    int bench;             // --bench
+    int time_passes;       // --time-passes
+    int print_stats;       // --stats
+    int stats_json;        // --stats-json (tempos + contadores em JSON)
+    int jobs;              // -j N: processos cc simultâneos na build por módulos
+    int asm_backend;       // --asm: backend x86-64 direto (as + link, sem cc)
+    int run;               // 'run': executa em bytecode, sem gerar executável
+    const char *server;    // --server <socket>: envia o build para 'compiler serve'
+} DriverOptions;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [opções] file.sauce\n", prog);
+    fprintf(stderr, "     %s run [opções] file.sauce   (executa direto, sem compilar C)\n", prog);
+    fprintf(stderr, "     %s serve <socket>            (servidor de compilação com estado em memória)\n", prog);
+    fprintf(stderr, "Opções:\n");
+    fprintf(stderr, "  -O0 | -O1 | -O2 | -O3   Nível de otimização do C gerado (padrão: -O2)\n");
+    fprintf(stderr, "  -march=native           Otimiza para a CPU da máquina atual\n");
+    fprintf(stderr, "  -flto                   Habilita link-time optimization\n");
+    fprintf(stderr, "  -g                      Build para perf/gdb: linhas do .sauce, símbolos e frame pointers\n");
+    fprintf(stderr, "  --static                Inicialização mínima: link estático, binário enxuto, say/hear sem stdio\n");
+    fprintf(stderr, "  -o <arquivo>            Caminho do executável (padrão: app)\n");
+    fprintf(stderr, "  -j <N>                  Compila até N módulos em paralelo (padrão: nº de CPUs)\n");
+    fprintf(stderr, "  --asm                   Backend x86-64 direto: build de depuração sem compilador C\n");
+    fprintf(stderr, "  --server <socket>       Compila via 'serve' (se indisponível, compila localmente)\n");
+    fprintf(stderr, "  --pgo <entrada>         Build guiado por perfil usando <entrada> como stdin de treino\n");
+    fprintf(stderr, "  --profile               Instrumenta funções e desvios (sauce-profile.txt / .folded / .branches)\n");
+    fprintf(stderr, "  --use-profile <arquivo> Marca ramos quentes/frios e funções frias a partir de sauce-profile.branches\n");
+    fprintf(stderr, "  --bench                 Gera um app que, ao ser executado, roda os blocos 'bench' (mediana/p99 em ns)\n");
+    fprintf(stderr, "  --time-passes           Mostra o tempo de cada fase do compilador\n");
+    fprintf(stderr, "  --stats                 Mostra contadores (tokens, nós da AST, bytes de C...)\n");
+    fprintf(stderr, "  --stats-json            Tempos e contadores em JSON (para CI)\n");
+}
+
+static int parse_options(int argc, char **argv, DriverOptions *opts) {
+    opts->infile = NULL;
+    opts->outfile = "app";
+    opts->opt_level = 2;
+    opts->native = 0;
+    opts->lto = 0;
+    opts->debug_info = 0;
+    opts->static_link = 0;
+    opts->pgo_input = NULL;
+    opts->profile = 0;
+    opts->use_profile = NULL;
+    opts->bench = 0;
+    opts->time_passes = 0;
+    opts->print_stats = 0;
+    opts->stats_json = 0;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    opts->jobs = cpus > 0 ? (int)cpus : 1;
+    opts->asm_backend = 0;
+    opts->run = 0;
+    opts->server = NULL;
+
+    int first = 1;
+    if (argc > 1 && strcmp(argv[1], "run") == 0) {
+        opts->run = 1;
+        first = 2;
+    }
+
+    for (int i = first; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strlen(arg) == 3 && strncmp(arg, "-O", 2) == 0 && arg[2] >= '0' && arg[2] <= '3') {
+            opts->opt_level = arg[2] - '0';
+        } else if (strcmp(arg, "-march=native") == 0) {
+            opts->native = 1;
+        } else if (strcmp(arg, "-flto") == 0) {
+            opts->lto = 1;
+        } else if (strcmp(arg, "-g") == 0) {
+            opts->debug_info = 1;
+        } else if (strcmp(arg, "--static") == 0) {
+            opts->static_link = 1;
+        } else if (strcmp(arg, "-o") == 0 && i + 1 < argc) {
+            opts->outfile = argv[++i];
+        } else if (strcmp(arg, "-j") == 0 && i + 1 < argc) {
+            opts->jobs = atoi(argv[++i]);
+            if (opts->jobs < 1) opts->jobs = 1;
+        } else if (strcmp(arg, "--asm") == 0) {
+            opts->asm_backend = 1;
+        } else if (strcmp(arg, "--server") == 0 && i + 1 < argc) {
+            opts->server = argv[++i];
+        } else if (strcmp(arg, "--pgo") == 0 && i + 1 < argc) {
+            opts->pgo_input = argv[++i];
+        } else if (strcmp(arg, "--profile") == 0) {
+            opts->profile = 1;
+        } else if (strcmp(arg, "--use-profile") == 0 && i + 1 < argc) {
+            opts->use_profile = argv[++i];
+        } else if (strcmp(arg, "--bench") == 0) {
+            opts->bench = 1;
+        } else if (strcmp(arg, "--time-passes") == 0) {
+            opts->time_passes = 1;
+        } else if (strcmp(arg, "--stats") == 0) {
+            opts->print_stats = 1;
+        } else if (strcmp(arg, "--stats-json") == 0) {
+            opts->stats_json = 1;
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "Opção desconhecida: %s\n", arg);
+            return 0;
+        } else if (!opts->infile) {
+            opts->infile = arg;
+        } else {
+            fprintf(stderr, "Apenas um arquivo de entrada é suportado: %s\n", arg);
+            return 0;
+        }
     }
-    const char *infile = argv[1];
-    
-    // 1. Leitura do arquivo fonte
-    FILE *f = fopen(infile, "r");
-    if (!f) { perror("fopen"); return 1; }
-    char *buf = malloc(MAX_SRC);
-    size_t r = fread(buf,1,MAX_SRC-1,f);
-    buf[r] = '\0';
-    fclose(f);
-    
-    // 2. Inicializa Lexer
-    lexer_init_from_string(buf);
-    
-    // 3. Parser (Constrói a AST e chama generate_code internamente)
-    // FIX: parse_all não recebe mais parâmetros
-    parse_all(); 
-
-    free(buf);
-    
-    // 4. Compila output.c -> app (mantido como estava no seu original)
-    fprintf(stderr, "Compiling output.c -> app\n");
-    int rc = system("cc -std=c11 -Wall -Wextra -O2 output.c -o app");
+    return opts->infile != NULL;
+}
+
+// O runtime é compilado junto com o compilador (make): por padrão fica ao lado do executável
+const char *runtime_dir() {
+    static char dir[MAX_CMD / 4];
+    if (dir[0]) return dir;
+    const char *env = getenv("SAUCE_RT_DIR");
+    if (env && env[0]) {
+        snprintf(dir, sizeof(dir), "%s", env);
+        return dir;
+    }
+    ssize_t n = readlink("/proc/self/exe", dir, sizeof(dir) - 1);
+    if (n <= 0) {
+        strcpy(dir, ".");
+        return dir;
+    }
+    dir[n] = '\0';
+    char *slash = strrchr(dir, '/');
+    if (slash) *slash = '\0';
+    return dir;
+}
+
+static int runtime_available() {
+    char lib[MAX_CMD / 2];
+    snprintf(lib, sizeof(lib), "%s/libsauce_rt.a", runtime_dir());
+    if (file_exists(lib)) return 1;
+    fprintf(stderr, "Erro: runtime '%s' não encontrado (rode 'make' ou defina SAUCE_RT_DIR).\n", lib);
+    return 0;
+}
+
+// --static: sem o carregador dinâmico; as seções não usadas (inclusive do runtime) saem no link
+#define STATIC_LINK_FLAGS " -static -ffunction-sections -fdata-sections -Wl,--gc-sections"
+
+// Flags do cc comuns a todas as builds; 'extra' acrescenta flags da fase (ex.: PGO)
+static void build_cc_flags(char *flags, size_t size, const DriverOptions *opts, const char *extra) {
+    snprintf(flags, size, "-std=c11 -Wall -Wextra -O%d -I'%s/runtime'%s%s%s%s%s%s%s%s",
+             opts->opt_level, runtime_dir(),
+             opts->native ? " -march=native" : "",
+             opts->lto ? " -flto" : "",
+             opts->debug_info ? " -g -fno-omit-frame-pointer" : "",
+             opts->static_link ? STATIC_LINK_FLAGS : "",
+             opts->static_link && !opts->debug_info ? " -s" : "", // -g pede os símbolos
+             program_uses_tasks() || program_uses_channels() ? " -pthread" : "",
+             extra[0] ? " " : "", extra);
+}
+
+// Monta a linha de comando do cc para o programa de arquivo único
+static void build_cc_command(char *cmd, size_t size, const DriverOptions *opts, const char *out, const char *extra) {
+    char flags[MAX_CMD / 2];
+    build_cc_flags(flags, sizeof(flags), opts, extra);
+    snprintf(cmd, size, "cc %s output.c '%s/libsauce_rt.a' -o '%s'", flags, runtime_dir(), out);
+}
+
+static int run_cc(const DriverOptions *opts, const char *out, const char *extra) {
+    char cmd[MAX_CMD];
+    build_cc_command(cmd, sizeof(cmd), opts, out, extra);
+    int rc = system(cmd);
     if (rc != 0) {
         fprintf(stderr, "Compilation of output.c failed with error code %d\n", rc);
+        return 0;
+    }
+    return 1;
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Executa o binário com a entrada de treino; retorna o melhor tempo de 'runs' execuções (ou < 0 em erro)
+static double run_with_input(const char *exe, const char *input, int runs) {
+    char cmd[MAX_CMD];
+    const char *prefix = strchr(exe, '/') ? "" : "./";
+    snprintf(cmd, sizeof(cmd), "%s'%s' < '%s' > /dev/null", prefix, exe, input);
+
+    double best = -1.0;
+    for (int i = 0; i < runs; i++) {
+        double start = now_seconds();
+        int rc = system(cmd);
+        double elapsed = now_seconds() - start;
+        if (rc != 0) {
+            fprintf(stderr, "Execução de '%s' falhou com código %d\n", exe, rc);
+            return -1.0;
+        }
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+// Pipeline PGO: baseline -> instrumentado -> treino -> rebuild com perfil -> medição.
+// O gcc dá ao .gcda o nome da saída do link: o instrumentado e o rebuild usam o
+// mesmo -o, senão o -fprofile-use não acha o perfil do treino.
+static int build_with_pgo(const DriverOptions *opts) {
+    char base_exe[MAX_CMD];
+    snprintf(base_exe, sizeof(base_exe), "%s.base", opts->outfile);
+
+    fprintf(stderr, "[pgo] Building baseline -> %s\n", base_exe);
+    if (!run_cc(opts, base_exe, "")) return 0;
+
+    fprintf(stderr, "[pgo] Building instrumented binary -> %s\n", opts->outfile);
+    system("rm -rf " PGO_DIR);
+    if (!run_cc(opts, opts->outfile, "-fprofile-generate=" PGO_DIR)) return 0;
+
+    fprintf(stderr, "[pgo] Training on %s\n", opts->pgo_input);
+    if (run_with_input(opts->outfile, opts->pgo_input, 1) < 0) return 0;
+
+    // Perfil ausente ou de outra unidade é erro: um rebuild sem perfil só mediria ruído
+    fprintf(stderr, "[pgo] Rebuilding with profile -> %s\n", opts->outfile);
+    if (!run_cc(opts, opts->outfile, "-fprofile-use=" PGO_DIR " -fprofile-correction -Werror=missing-profile")) return 0;
+
+    double base_time = run_with_input(base_exe, opts->pgo_input, PGO_TIMING_RUNS);
+    double pgo_time = run_with_input(opts->outfile, opts->pgo_input, PGO_TIMING_RUNS);
+    if (base_time > 0 && pgo_time > 0) {
+        fprintf(stderr, "[pgo] Baseline: %.3f ms, PGO: %.3f ms, speedup: %.2fx\n",
+                base_time * 1e3, pgo_time * 1e3, base_time / pgo_time);
+    }
+
+    remove(base_exe);
+    return 1;
+}
+
+static int build_with_asm(const DriverOptions *opts) {
+    generate_asm("output.s");
+
+    stats_enter(PHASE_CC);
+    char cmd[MAX_CMD];
+    snprintf(cmd, sizeof(cmd), "as -o output.o output.s && cc -o '%s' output.o", opts->outfile);
+    fprintf(stderr, "Assembling output.s -> %s\n", opts->outfile);
+    int rc = system(cmd);
+    stats_leave();
+    if (rc != 0) {
+        fprintf(stderr, "Assembly of output.s failed with error code %d\n", rc);
+        return 0;
+    }
+    return 1;
+}
+
+static int driver_main(int argc, char **argv) {
+    DriverOptions opts;
+    if (!parse_options(argc, argv, &opts)) {
+        usage(argv[0]);
         return 1;
     }
-    
-    fprintf(stderr, "Success! Executable 'app' created.\n");
+    const char *infile = opts.infile;
+    stats_enabled = opts.time_passes || opts.stats_json;
+
+    // run e --pgo executam o programa (terminal do cliente) e as unidades do servidor não geram
+    // o main de --bench: esses builds ficam locais
+    if (opts.server && !server_worker_active() && !opts.run && !opts.bench && !opts.pgo_input) {
+        int rc = server_request(opts.server, argc, argv);
+        if (rc >= 0) return rc;
+        fprintf(stderr, "Aviso: servidor '%s' indisponível; compilando localmente.\n", opts.server);
+    }
+
+    // 1. Leitura e parsing do arquivo fonte (o servidor reaproveita a AST se nada mudou)
+    if (!load_source(infile)) { perror("fopen"); return 1; }
+
+    cg_options.profile = opts.profile;
+    cg_options.branch_profile = opts.use_profile;
+    cg_options.bench = opts.bench;
+    cg_options.line_directives = opts.debug_info;
+    cg_options.minimal_io = opts.static_link;
+    cg_options.source_file = infile;
+
+    // 'run': bytecode interpretado no próprio processo
+    if (opts.run) {
+        if (program_has_imports() || program_uses_tasks() || program_uses_channels() || program_uses_generators()) {
+            fprintf(stderr, "Erro: 'run' ainda não suporta programas com 'import', spawn/join, canais nem geradores.\n");
+            return 1;
+        }
+        int rc = vm_run_program();
+        if (opts.time_passes || opts.print_stats || opts.stats_json) {
+            stats_report(stderr, opts.time_passes, opts.print_stats, opts.stats_json);
+        }
+        return rc;
+    }
+
+    // Backend direto: output.s -> as -> link (o cc só é usado como driver do ld)
+    if (opts.asm_backend) {
+        if (opts.pgo_input || opts.profile || opts.bench || opts.static_link || program_has_imports() ||
+            program_uses_tasks() || program_uses_channels() || program_uses_generators()) {
+            fprintf(stderr, "Erro: --asm não suporta --pgo, --profile, --bench, --static, 'import', spawn/join, canais nem geradores; use o backend C.\n");
+            return 1;
+        }
+        if (!build_with_asm(&opts)) return 1;
+
+        if (opts.time_passes || opts.print_stats || opts.stats_json) {
+            stats_report(stderr, opts.time_passes, opts.print_stats, opts.stats_json);
+        }
+        fprintf(stderr, "Success! Executable '%s' created.\n", opts.outfile);
+        return 0;
+    }
+
+    if (!runtime_available()) return 1;
+
+    // Programa com 'import': uma unidade de tradução por módulo em sauce-build/
+    if (program_has_imports()) {
+        if (opts.pgo_input || opts.profile || opts.use_profile) {
+            fprintf(stderr, "Erro: --pgo, --profile e --use-profile ainda não suportam programas com 'import'.\n");
+            return 1;
+        }
+        char flags[MAX_CMD];
+        build_cc_flags(flags, sizeof(flags), &opts, "");
+        if (!build_modules(infile, flags, opts.jobs, opts.outfile)) return 1;
+
+        if (opts.time_passes || opts.print_stats || opts.stats_json) {
+            stats_report(stderr, opts.time_passes, opts.print_stats, opts.stats_json);
+        }
+        fprintf(stderr, "Success! Executable '%s' created.\n", opts.outfile);
+        return 0;
+    }
+
+    // Dentro do servidor: uma unidade por função, só as afetadas são recompiladas
+    if (server_worker_active() && !opts.pgo_input && !opts.profile && !opts.bench) {
+        char flags[MAX_CMD];
+        build_cc_flags(flags, sizeof(flags), &opts, "");
+        if (!build_function_units(flags, opts.jobs, opts.outfile)) return 1;
+
+        if (opts.time_passes || opts.print_stats || opts.stats_json) {
+            stats_report(stderr, opts.time_passes, opts.print_stats, opts.stats_json);
+        }
+        fprintf(stderr, "Success! Executable '%s' created.\n", opts.outfile);
+        return 0;
+    }
+
+    // 2. Gera output.c a partir da AST
+    generate_code("output.c", NULL);
+
+    // 3. Compila output.c -> executável
+    stats_enter(PHASE_CC);
+    if (opts.pgo_input) {
+        if (!build_with_pgo(&opts)) return 1;
+    } else {
+        fprintf(stderr, "Compiling output.c -> %s\n", opts.outfile);
+        if (!run_cc(&opts, opts.outfile, "")) return 1;
+    }
+    stats_leave();
+
+    if (opts.time_passes || opts.print_stats || opts.stats_json) {
+        stats_report(stderr, opts.time_passes, opts.print_stats, opts.stats_json);
+    }
+
+    fprintf(stderr, "Success! Executable '%s' created.\n", opts.outfile);
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        if (argc != 3) {
+            usage(argv[0]);
+            return 1;
+        }
+        return server_main(argv[2], driver_main);
+    }
+    return driver_main(argc, argv);
+}
@@ -0,0 +1,415 @@
+// module.c -- Compilação por módulos: import, uma unidade de tradução por arquivo,
+// interfaces exportadas, recompilação incremental e cc em paralelo.
+//
+// Cada arquivo .sauce vira sauce-build/<módulo>.c, .h (interface) e .o.
+// Um módulo só é recompilado quando o seu .c gerado mudou, quando a interface
+// de algum módulo importado mudou, quando as flags do cc mudaram (guardadas em
+// sauce-build/cc-flags) ou quando o .o não existe. Módulos importados só podem
+// conter funções (e outros imports), e cada módulo só chama funções próprias ou
+// dos módulos que importa diretamente.
+
+#include "compiler.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_MODULES 64
+#define MAX_PATH 1024
+#define MAX_CMD 8192
+#define BUILD_DIR "sauce-build"
+
+typedef struct {
+    char path[MAX_PATH];           // Caminho do .sauce
+    char name[MAX_TOKEN_LEN];      // Nome base (sem diretório e extensão)
+    Node *fns[MAX_FN_DEFS];
+    int fnCount;
+    Node *stmts[MAX_FN_DEFS];
+    int stmtCount;
+    int imports[MAX_MODULES];      // Índices dos módulos importados diretamente
+    int importCount;
+    int c_changed;                 // .c gerado mudou nesta build
+    int h_changed;                 // Interface mudou nesta build
+    int needs_compile;
+} Module;
+
+static Module modules[MAX_MODULES];
+static int moduleCount = 0;
+
+// --- Utilidades de Arquivo ---
+
+char *read_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return NULL;
+    size_t cap = 4096, len = 0, got;
+    char *buf = malloc(cap);
+    while ((got = fread(buf + len, 1, cap - len - 1, f)) > 0) {
+        len += got;
+        if (len + 1 == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+            if (!buf) { perror("realloc"); exit(1); }
+        }
+    }
+    buf[len] = '\0';
+    fclose(f);
+    return buf;
+}
+
+int file_exists(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+// Substitui 'path' por 'tmp' apenas se o conteúdo mudou (preserva o mtime). Retorna 1 se mudou.
+int replace_if_changed(const char *tmp, const char *path) {
+    char *new_content = read_file(tmp);
+    char *old_content = read_file(path);
+    int changed = !old_content || !new_content || strcmp(old_content, new_content) != 0;
+    free(new_content);
+    free(old_content);
+
+    if (changed) {
+        if (rename(tmp, path) != 0) { perror("rename"); exit(1); }
+    } else {
+        remove(tmp);
+    }
+    return changed;
+}
+
+int write_if_changed(const char *path, const char *content) {
+    char tmp[MAX_PATH + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) { perror("fopen"); exit(1); }
+    fputs(content, f);
+    fclose(f);
+    return replace_if_changed(tmp, path);
+}
+
+static void module_name_from_path(const char *path, char *out) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    strncpy(out, base, MAX_TOKEN_LEN - 1);
+    out[MAX_TOKEN_LEN - 1] = '\0';
+    char *dot = strrchr(out, '.');
+    if (dot) *dot = '\0';
+    // Nome precisa ser um identificador C válido (usado no include guard)
+    for (char *c = out; *c; c++) {
+        if (!isalnum((unsigned char)*c) && *c != '_') *c = '_';
+    }
+}
+
+// Caminho do import relativo ao diretório do módulo que importa
+static void resolve_import(const char *importer, const char *target, char *out) {
+    const char *slash = strrchr(importer, '/');
+    if (target[0] == '/' || !slash) {
+        snprintf(out, MAX_PATH, "%s", target);
+    } else {
+        snprintf(out, MAX_PATH, "%.*s/%s", (int)(slash - importer), importer, target);
+    }
+}
+
+// --- Carga dos Módulos ---
+
+static int find_module(const char *path) {
+    for (int i = 0; i < moduleCount; i++) {
+        if (strcmp(modules[i].path, path) == 0) return i;
+    }
+    return -1;
+}
+
+// Guarda as tabelas globais do parser no módulo e as zera para o próximo arquivo
+static void snapshot_parser(Module *m) {
+    m->fnCount = fnDefCount;
+    memcpy(m->fns, fn_defs, sizeof(Node *) * fnDefCount);
+    m->stmtCount = globalStmtCount;
+    memcpy(m->stmts, global_stmts, sizeof(Node *) * globalStmtCount);
+    fnDefCount = 0;
+    globalStmtCount = 0;
+}
+
+static int add_module(const char *path) {
+    if (moduleCount >= MAX_MODULES) {
+        fprintf(stderr, "Erro: Limite de módulos excedido.\n");
+        exit(1);
+    }
+    Module *m = &modules[moduleCount];
+    memset(m, 0, sizeof(Module));
+    snprintf(m->path, MAX_PATH, "%s", path);
+    module_name_from_path(path, m->name);
+
+    for (int i = 0; i < moduleCount; i++) {
+        if (strcmp(modules[i].name, m->name) == 0) {
+            fprintf(stderr, "Erro: Módulos '%s' e '%s' têm o mesmo nome.\n", modules[i].path, path);
+            exit(1);
+        }
+    }
+    return moduleCount++;
+}
+
+static void load_module(int idx) {
+    Module *m = &modules[idx];
+    if (!load_source(m->path)) {
+        fprintf(stderr, "Erro: Não foi possível ler o módulo '%s'.\n", m->path);
+        exit(1);
+    }
+    snapshot_parser(m);
+}
+
+// Percorre os imports em largura; o módulo 0 (principal) já foi parseado
+static void load_imports() {
+    for (int i = 0; i < moduleCount; i++) {
+        for (int s = 0; s < modules[i].stmtCount; s++) {
+            Node *stmt = modules[i].stmts[s];
+            if (stmt->kind != N_IMPORT) {
+                if (i != 0) {
+                    fprintf(stderr, "Erro: Módulo importado '%s' só pode conter funções e imports.\n", modules[i].path);
+                    exit(1);
+                }
+                continue;
+            }
+            char path[MAX_PATH];
+            resolve_import(modules[i].path, stmt->text, path);
+            int dep = find_module(path);
+            if (dep < 0) {
+                dep = add_module(path);
+                load_module(dep);
+            }
+            modules[i].imports[modules[i].importCount++] = dep;
+        }
+    }
+}
+
+// Módulo que define a função 'name' (-1 se nenhum)
+static int module_of_fn(const char *name) {
+    for (int i = 0; i < moduleCount; i++) {
+        for (int f = 0; f < modules[i].fnCount; f++) {
+            if (strcmp(modules[i].fns[f]->name, name) == 0) return i;
+        }
+    }
+    return -1;
+}
+
+// Só as interfaces dos imports diretos entram no .c do módulo: chamar uma função de
+// um módulo importado apenas indiretamente viraria declaração implícita no cc
+static void check_calls_imported(Node *n, int idx) {
+    if (!n) return;
+    if (n->kind == N_FN_CALL) {
+        int owner = module_of_fn(n->name);
+        int visible = owner < 0 || owner == idx;
+        for (int k = 0; !visible && k < modules[idx].importCount; k++) {
+            visible = modules[idx].imports[k] == owner;
+        }
+        if (!visible) {
+            fprintf(stderr, "Erro Semântico (%s:%d:%d): Função '%s' é do módulo '%s', que não foi importado aqui.\n",
+                    modules[idx].path, n->line, n->col, n->name, modules[owner].path);
+            exit(1);
+        }
+    }
+    check_calls_imported(n->left, idx);
+    check_calls_imported(n->mid, idx);
+    check_calls_imported(n->right, idx);
+}
+
+// --- Geração ---
+
+// Reconstrói as tabelas globais com TODAS as funções; as de outros módulos ficam EXTERN
+static void select_module(int idx) {
+    fnDefCount = 0;
+    for (int i = 0; i < moduleCount; i++) {
+        for (int f = 0; f < modules[i].fnCount; f++) {
+            Node *fn = modules[i].fns[f];
+            if (i == idx) fn->flags &= ~NODE_FLAG_EXTERN;
+            else fn->flags |= NODE_FLAG_EXTERN;
+            fn_defs[fnDefCount++] = fn;
+        }
+    }
+    globalStmtCount = modules[idx].stmtCount;
+    memcpy(global_stmts, modules[idx].stmts, sizeof(Node *) * globalStmtCount);
+}
+
+static void generate_module(int idx) {
+    Module *m = &modules[idx];
+    char includes[MAX_CMD] = "";
+    for (int i = 0; i < m->importCount; i++) {
+        size_t len = strlen(includes);
+        snprintf(includes + len, sizeof(includes) - len, "#include \"%s.h\"\n", modules[m->imports[i]].name);
+    }
+
+    select_module(idx);
+    cg_options.module_mode = 1;
+    cg_options.module_is_main = idx == 0;
+    cg_options.module_includes = includes;
+    cg_options.source_file = m->path;
+
+    char path[MAX_PATH], tmp[MAX_PATH + 8], guard[MAX_TOKEN_LEN + 32];
+
+    snprintf(path, sizeof(path), BUILD_DIR "/%s.c", m->name);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    generate_code(tmp, NULL);
+    m->c_changed = replace_if_changed(tmp, path);
+
+    snprintf(path, sizeof(path), BUILD_DIR "/%s.h", m->name);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    snprintf(guard, sizeof(guard), "SAUCE_MODULE_%s_H", m->name);
+    generate_interface(tmp, guard);
+    m->h_changed = replace_if_changed(tmp, path);
+}
+
+// --- Compilação Paralela ---
+
+static pid_t spawn(const char *cmd) {
+    pid_t pid = fork();
+    if (pid < 0) { perror("fork"); exit(1); }
+    if (pid == 0) {
+        execl("/bin/sh", "sh", "-c", cmd, (char *)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+// Executa os comandos com no máximo 'jobs' processos simultâneos; para de lançar no primeiro erro
+int run_commands_parallel(char **cmds, int count, int jobs) {
+    int running = 0, failed = 0, next = 0;
+
+    while (next < count || running > 0) {
+        while (!failed && running < jobs && next < count) {
+            spawn(cmds[next++]);
+            running++;
+        }
+        if (running == 0) break;
+
+        int status;
+        if (wait(&status) > 0) {
+            running--;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+        }
+    }
+    return !failed;
+}
+
+// Compila os módulos marcados com no máximo 'jobs' processos cc simultâneos
+static int compile_modules(const char *cc_flags, int jobs) {
+    char *cmds[MAX_MODULES];
+    int count = 0;
+    for (int i = 0; i < moduleCount; i++) {
+        Module *m = &modules[i];
+        if (!m->needs_compile) continue;
+        char obj[MAX_PATH];
+        snprintf(obj, sizeof(obj), BUILD_DIR "/%s.o", m->name);
+        remove(obj); // Se o cc falhar, o .o antigo não pode parecer atualizado
+        cmds[count] = malloc(MAX_CMD);
+        snprintf(cmds[count++], MAX_CMD, "cc %s -c " BUILD_DIR "/%s.c -o " BUILD_DIR "/%s.o", cc_flags, m->name, m->name);
+        fprintf(stderr, "  [cc] %s.c\n", m->name);
+    }
+    int ok = run_commands_parallel(cmds, count, jobs);
+    for (int i = 0; i < count; i++) free(cmds[i]);
+    return ok;
+}
+
+// ------------------------------------------
+// --- API Pública ---
+// ------------------------------------------
+
+// Chamada depois de parse_program() do arquivo principal
+int program_has_imports() {
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (global_stmts[i]->kind == N_IMPORT) return 1;
+    }
+    return 0;
+}
+
+// Espera que o arquivo principal já tenha sido parseado (tabelas globais preenchidas)
+int build_modules(const char *main_file, const char *cc_flags, int jobs, const char *outfile) {
+    mkdir(BUILD_DIR, 0755);
+
+    int root = add_module(main_file);
+    snapshot_parser(&modules[root]);
+    load_imports();
+
+    // Nomes de função precisam ser únicos no programa inteiro
+    for (int i = 0; i < moduleCount; i++) {
+        for (int f = 0; f < modules[i].fnCount; f++) {
+            for (int j = i; j < moduleCount; j++) {
+                for (int g = (j == i ? f + 1 : 0); g < modules[j].fnCount; g++) {
+                    if (strcmp(modules[i].fns[f]->name, modules[j].fns[g]->name) == 0) {
+                        fprintf(stderr, "Erro: Função '%s' definida em '%s' e '%s'.\n",
+                                modules[i].fns[f]->name, modules[i].path, modules[j].path);
+                        exit(1);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < moduleCount; i++) {
+        for (int f = 0; f < modules[i].fnCount; f++) check_calls_imported(modules[i].fns[f]->mid, i);
+        for (int s = 0; s < modules[i].stmtCount; s++) check_calls_imported(modules[i].stmts[s], i);
+    }
+
+    // spawn/join ou canais em qualquer módulo: -pthread em todos (o runtime vem de libsauce_rt.a)
+    int threads = 0, channels = 0;
+    for (int i = 0; i < moduleCount; i++) {
+        for (int f = 0; f < modules[i].fnCount; f++) {
+            threads |= uses_tasks(modules[i].fns[f]->mid);
+            channels |= uses_channels(modules[i].fns[f]->left) || uses_channels(modules[i].fns[f]->mid);
+        }
+        for (int s = 0; s < modules[i].stmtCount; s++) {
+            threads |= uses_tasks(modules[i].stmts[s]);
+            channels |= uses_channels(modules[i].stmts[s]);
+        }
+    }
+    cg_options.threads = threads;
+    cg_options.channels = channels;
+    char flags[MAX_CMD / 2];
+    snprintf(flags, sizeof(flags), "%s%s", cc_flags, (threads || channels) && !strstr(cc_flags, "-pthread") ? " -pthread" : "");
+    cc_flags = flags;
+
+    for (int i = 0; i < moduleCount; i++) {
+        generate_module(i);
+    }
+
+    // Decide o que recompilar (flags diferentes, ex.: -O3 ou -flto, invalidam todos os objetos)
+    int flags_changed = write_if_changed(BUILD_DIR "/cc-flags", cc_flags);
+    int any_compiled = 0;
+    for (int i = 0; i < moduleCount; i++) {
+        Module *m = &modules[i];
+        char obj[MAX_PATH];
+        snprintf(obj, sizeof(obj), BUILD_DIR "/%s.o", m->name);
+        m->needs_compile = m->c_changed || flags_changed || !file_exists(obj);
+        for (int k = 0; k < m->importCount; k++) {
+            if (modules[m->imports[k]].h_changed) m->needs_compile = 1;
+        }
+        any_compiled |= m->needs_compile;
+    }
+
+    stats_enter(PHASE_CC);
+    fprintf(stderr, "Compiling %d module(s) with up to %d job(s)\n", moduleCount, jobs);
+    if (!compile_modules(cc_flags, jobs)) {
+        fprintf(stderr, "Compilation of modules failed\n");
+        stats_leave();
+        return 0;
+    }
+
+    // Link apenas se algum objeto mudou ou o executável não existe
+    if (any_compiled || !file_exists(outfile)) {
+        char cmd[MAX_CMD];
+        int len = snprintf(cmd, sizeof(cmd), "cc %s", cc_flags);
+        for (int i = 0; i < moduleCount && len < (int)sizeof(cmd); i++) {
+            len += snprintf(cmd + len, sizeof(cmd) - len, " " BUILD_DIR "/%s.o", modules[i].name);
+        }
+        snprintf(cmd + len, sizeof(cmd) - len, " '%s/libsauce_rt.a' -o '%s'", runtime_dir(), outfile);
+        fprintf(stderr, "  [ld] %s\n", outfile);
+        int rc = system(cmd);
+        if (rc != 0) {
+            fprintf(stderr, "Link failed with error code %d\n", rc);
+            stats_leave();
+            return 0;
+        }
+    } else {
+        fprintf(stderr, "  '%s' está atualizado\n", outfile);
+    }
+    stats_leave();
+    return 1;
+}
@@ -0,0 +1,313 @@
+// optimize.c -- Otimizações feitas diretamente na AST, antes da geração de C
+
+#include "compiler.h"
+
+#define INLINE_MAX_NODES 16 // Tamanho máximo da expressão de retorno inlinável
+#define INLINE_MAX_DEPTH 8  // Limite para cadeias de inlining (f -> g -> h ...)
+
+// --- Utilidades ---
+
+static Node *find_fn(const char *name) {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (strcmp(fn_defs[i]->name, name) == 0) return fn_defs[i];
+    }
+    return NULL;
+}
+
+static Node *clone_tree(Node *n) {
+    if (!n) return NULL;
+    Node *c = make_node(n->kind, n->name, n->text, clone_tree(n->left), clone_tree(n->mid), clone_tree(n->right));
+    strcpy(c->typeName, n->typeName);
+    strcpy(c->explicitReturnType, n->explicitReturnType);
+    c->flags = n->flags;
+    c->effects = n->effects;
+    c->line = n->line;
+    c->col = n->col;
+    return c;
+}
+
+static int count_var_uses(Node *n, const char *name) {
+    if (!n) return 0;
+    int uses = (n->kind == N_VAR && strcmp(n->name, name) == 0) ? 1 : 0;
+    return uses + count_var_uses(n->left, name) + count_var_uses(n->mid, name) + count_var_uses(n->right, name);
+}
+
+static int calls_fn(Node *n, const char *name) {
+    if (!n) return 0;
+    if (n->kind == N_FN_CALL && strcmp(n->name, name) == 0) return 1;
+    return calls_fn(n->left, name) || calls_fn(n->mid, name) || calls_fn(n->right, name);
+}
+
+// Argumentos triviais podem ser duplicados ou descartados sem mudar a semântica
+static int is_trivial(Node *n) {
+    return n->kind == N_VAR || n->kind == N_INT || n->kind == N_FLOAT ||
+           n->kind == N_BOOL || n->kind == N_STRING;
+}
+
+// Uso sob o lado direito de and/or: só é avaliado se o lado esquerdo não decidir
+static int used_conditionally(Node *n, const char *name) {
+    if (!n) return 0;
+    if ((n->kind == N_AND || n->kind == N_OR) && count_var_uses(n->right, name) > 0) return 1;
+    return used_conditionally(n->left, name) || used_conditionally(n->mid, name) || used_conditionally(n->right, name);
+}
+
+// Expressão sem efeitos: pode deixar de ser avaliada sem mudar o programa
+static int has_effects(Node *n) {
+    if (!n) return 0;
+    if (n->kind == N_RECV || n->kind == N_NEXT || n->kind == N_JOIN || n->kind == N_HEAR || n->kind == N_SPAWN) return 1;
+    if (n->kind == N_FN_CALL) {
+        Node *callee = find_fn(n->name);
+        if (!callee || !fn_is_pure(callee)) return 1;
+    }
+    return has_effects(n->left) || has_effects(n->mid) || has_effects(n->right);
+}
+
+static int same_c_type(const char *a, const char *b) {
+    return strcmp(sauce_type_to_c(a), sauce_type_to_c(b)) == 0;
+}
+
+// Substitui os parâmetros (N_VAR) pelos argumentos correspondentes
+static Node *substitute(Node *n, Node *params, Node *args) {
+    if (!n) return NULL;
+    if (n->kind == N_VAR) {
+        Node *p = params, *a = args;
+        while (p && a) {
+            if (strcmp(p->left->name, n->name) == 0) return clone_tree(a->left);
+            p = p->right;
+            a = a->right;
+        }
+    }
+    Node *c = make_node(n->kind, n->name, n->text, substitute(n->left, params, args),
+                        substitute(n->mid, params, args), substitute(n->right, params, args));
+    strcpy(c->typeName, n->typeName);
+    strcpy(c->explicitReturnType, n->explicitReturnType);
+    c->line = n->line;
+    c->col = n->col;
+    return c;
+}
+
+// ------------------------------------------
+// --- Inlining de Funções Pequenas ---
+// ------------------------------------------
+
+// Candidata: corpo é um único 'return expr' de função 'const' e não recursiva,
+// cuja expressão já tem exatamente o tipo de retorno declarado (sem conversão implícita).
+static Node *inline_body(Node *fn) {
+    Node *body = fn->mid;
+    if (!body || body->right || !body->left || body->left->kind != N_RETURN) return NULL;
+
+    Node *ret = body->left;
+    if (!ret->left || ret->explicitReturnType[0] != '\0') return NULL;
+    if (!fn_is_const(fn) || fn_should_memoize(fn) || calls_fn(ret->left, fn->name)) return NULL;
+    if (ast_size(ret->left) > INLINE_MAX_NODES) return NULL;
+    if (!same_c_type(get_expr_type(ret->left, fn), fn->typeName)) return NULL;
+    return ret->left;
+}
+
+static Node *try_inline_call(Node *call, Node *ctx) {
+    Node *callee = find_fn(call->name);
+    if (!callee || (callee->flags & NODE_FLAG_EXTERN)) return NULL; // Sem inlining entre módulos
+    Node *expr = inline_body(callee);
+    if (!expr) return NULL;
+
+    Node *p = callee->left, *a = call->left;
+    while (p && a) {
+        // Sem conversão implícita de argumento
+        if (!same_c_type(get_expr_type(a->left, ctx), p->left->typeName)) return NULL;
+
+        // Argumento não trivial só pode ser usado exatamente uma vez
+        int uses = count_var_uses(expr, p->left->name);
+        if (uses != 1 && !is_trivial(a->left)) return NULL;
+        // A chamada original sempre avalia o argumento: com efeitos, não pode ir para trás de and/or
+        if (used_conditionally(expr, p->left->name) && has_effects(a->left)) return NULL;
+
+        p = p->right;
+        a = a->right;
+    }
+    if (p || a) return NULL; // Aridade incorreta: deixa o erro para o compilador C
+
+    return substitute(expr, callee->left, call->left);
+}
+
+static void inline_in_tree(Node **slot, Node *ctx, int depth) {
+    Node *n = *slot;
+    if (!n) return;
+
+    // Resultado descartado (N_EXPR_STMT): mantém a chamada
+    if (n->kind == N_EXPR_STMT) {
+        if (n->left && n->left->kind == N_FN_CALL) {
+            inline_in_tree(&n->left->left, ctx, depth);
+        }
+        inline_in_tree(&n->right, ctx, depth);
+        return;
+    }
+
+    // spawn/stage precisam da chamada: só os argumentos são inlinados
+    if (n->kind == N_SPAWN || n->kind == N_STAGE) {
+        inline_in_tree(&n->left->left, ctx, depth);
+        return;
+    }
+
+    inline_in_tree(&n->left, ctx, depth);
+    inline_in_tree(&n->mid, ctx, depth);
+    inline_in_tree(&n->right, ctx, depth);
+
+    if (n->kind == N_FN_CALL && depth < INLINE_MAX_DEPTH) {
+        Node *inlined = try_inline_call(n, ctx);
+        if (inlined) {
+            *slot = inlined;
+            // A expressão inlinada pode conter novas chamadas candidatas
+            inline_in_tree(slot, ctx, depth + 1);
+        }
+    }
+}
+
+// Deve rodar depois de analyze_effects() (usa a classificação de pureza)
+void inline_small_functions() {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (fn_defs[i]->flags & NODE_FLAG_EXTERN) continue;
+        inline_in_tree(&fn_defs[i]->mid, fn_defs[i], 0);
+    }
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (global_stmts[i]->kind == N_BENCH) continue; // Blocos bench medem o código como escrito
+        inline_in_tree(&global_stmts[i], NULL, 0);
+    }
+}
+
+// ------------------------------------------
+// --- Dicas de Desvio e Funções Frias ---
+// ------------------------------------------
+
+#define BRANCH_MIN_SAMPLES 16 // Menos execuções que isso: o perfil não decide nada
+#define BRANCH_HOT_PERCENT 90 // Um lado com >= 90% das execuções é o quente
+
+typedef struct { int line, col; unsigned long long taken, not_taken; } BranchCount;
+
+static BranchCount *branch_counts = NULL;
+static int branchCountLen = 0;
+
+// Formato de sauce-profile.branches (escrito por --profile): "linha:coluna verdadeiro falso"
+static void load_branch_profile(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Erro: não foi possível ler o perfil de desvios '%s'.\n", path);
+        exit(1);
+    }
+    free(branch_counts);
+    branch_counts = NULL;
+    branchCountLen = 0;
+    int cap = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        BranchCount b;
+        if (line[0] == '#' || sscanf(line, "%d:%d %llu %llu", &b.line, &b.col, &b.taken, &b.not_taken) != 4) continue;
+        if (branchCountLen == cap) {
+            cap = cap ? cap * 2 : 64;
+            branch_counts = realloc(branch_counts, sizeof(BranchCount) * cap);
+            if (!branch_counts) { perror("realloc"); exit(1); }
+        }
+        branch_counts[branchCountLen++] = b;
+    }
+    fclose(f);
+}
+
+static BranchCount *find_branch_count(Node *n) {
+    for (int i = 0; i < branchCountLen; i++) {
+        if (branch_counts[i].line == n->line && branch_counts[i].col == n->col) return &branch_counts[i];
+    }
+    return NULL;
+}
+
+int if_branch_hint(Node *n) {
+    if (n->flags & NODE_FLAG_LIKELY) return 1;
+    if (n->flags & NODE_FLAG_UNLIKELY) return -1;
+    if (n->flags & NODE_FLAG_PROF_LIKELY) return 1;
+    if (n->flags & NODE_FLAG_PROF_UNLIKELY) return -1;
+    return 0;
+}
+
+// Dicas escritas no fonte têm prioridade; o perfil só preenche os if sem dica
+static void apply_branch_profile(Node *n) {
+    if (!n) return;
+    if (n->kind == N_IF && n->line > 0 && !(n->flags & (NODE_FLAG_LIKELY | NODE_FLAG_UNLIKELY))) {
+        BranchCount *b = find_branch_count(n);
+        unsigned long long total = b ? b->taken + b->not_taken : 0;
+        if (total >= BRANCH_MIN_SAMPLES) {
+            if (b->taken * 100 >= total * BRANCH_HOT_PERCENT) n->flags |= NODE_FLAG_PROF_LIKELY;
+            else if (b->not_taken * 100 >= total * BRANCH_HOT_PERCENT) n->flags |= NODE_FLAG_PROF_UNLIKELY;
+        }
+    }
+    apply_branch_profile(n->left);
+    apply_branch_profile(n->mid);
+    apply_branch_profile(n->right);
+}
+
+static void clear_derived_flags(Node *n) {
+    if (!n) return;
+    n->flags &= ~(NODE_FLAG_PROF_LIKELY | NODE_FLAG_PROF_UNLIKELY | NODE_FLAG_COLD);
+    clear_derived_flags(n->left);
+    clear_derived_flags(n->mid);
+    clear_derived_flags(n->right);
+}
+
+static int hot_calls[MAX_FN_DEFS], cold_calls[MAX_FN_DEFS];
+
+// Conta as chamadas de cada função; 'cold' = o ponto da chamada está num ramo frio
+static void count_call_sites(Node *n, Node *self, int cold) {
+    if (!n) return;
+    if (n->kind == N_IF) {
+        int hint = if_branch_hint(n);
+        count_call_sites(n->left, self, cold);
+        count_call_sites(n->right, self, cold || hint < 0);
+        count_call_sites(n->mid, self, cold || hint > 0);
+        return;
+    }
+    if (n->kind == N_FN_CALL) {
+        for (int i = 0; i < fnDefCount; i++) {
+            if (fn_defs[i] == self || strcmp(fn_defs[i]->name, n->name) != 0) continue;
+            if (cold) cold_calls[i]++;
+            else hot_calls[i]++;
+        }
+    }
+    count_call_sites(n->left, self, cold);
+    count_call_sites(n->mid, self, cold);
+    count_call_sites(n->right, self, cold);
+}
+
+// Fria: chamada ao menos uma vez e só de ramos frios ou de outras funções frias.
+// O conjunto só cresce, então a iteração termina.
+static void mark_cold_functions() {
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        memset(hot_calls, 0, sizeof(hot_calls));
+        memset(cold_calls, 0, sizeof(cold_calls));
+        for (int i = 0; i < fnDefCount; i++) {
+            count_call_sites(fn_defs[i]->mid, fn_defs[i], (fn_defs[i]->flags & NODE_FLAG_COLD) != 0);
+        }
+        for (int i = 0; i < globalStmtCount; i++) {
+            count_call_sites(global_stmts[i], NULL, 0);
+        }
+        for (int i = 0; i < fnDefCount; i++) {
+            if (!(fn_defs[i]->flags & NODE_FLAG_COLD) && cold_calls[i] > 0 && hot_calls[i] == 0) {
+                fn_defs[i]->flags |= NODE_FLAG_COLD;
+                changed = 1;
+            }
+        }
+    }
+}
+
+// Recalcula tudo a cada build: o servidor reaproveita a AST entre pedidos
+void annotate_branches() {
+    for (int i = 0; i < fnDefCount; i++) clear_derived_flags(fn_defs[i]);
+    for (int i = 0; i < globalStmtCount; i++) clear_derived_flags(global_stmts[i]);
+
+    if (cg_options.branch_profile) {
+        load_branch_profile(cg_options.branch_profile);
+        for (int i = 0; i < fnDefCount; i++) apply_branch_profile(fn_defs[i]->mid);
+        for (int i = 0; i < globalStmtCount; i++) apply_branch_profile(global_stmts[i]);
+    }
+
+    // Com módulos, uma função exportada pode ter chamadas quentes em outro módulo
+    if (!cg_options.module_mode) mark_cold_functions();
+}
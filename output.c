@@ -0,0 +1,57 @@
+/* Código C gerado pelo compilador Sauce (AST-based) */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L // Para strdup e free
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+#include "sauce_rt.h"
+
+static int scan(int, int, int) __attribute__((const)) __attribute__((unused));
+
+static const struct { _sauce_text_hdr hdr; char s[sizeof("user:")]; } _sauce_lit0 __attribute__((unused)) = {{0xdd86787a56ba3aeeULL, sizeof("user:") - 1, SAUCE_TEXT_STATIC}, "user:"};
+static const struct { _sauce_text_hdr hdr; char s[sizeof(":")]; } _sauce_lit1 __attribute__((unused)) = {{0x44bd61d473cd535bULL, sizeof(":") - 1, SAUCE_TEXT_STATIC}, ":"};
+static const struct { _sauce_text_hdr hdr; char s[sizeof("user:7:")]; } _sauce_lit2 __attribute__((unused)) = {{0x8c4faff37bb37533ULL, sizeof("user:7:") - 1, SAUCE_TEXT_STATIC}, "user:7:"};
+
+int n = 0;
+
+
+static int scan(int i, int n, int hits) {
+_tco_entry: ;
+    _sauce_arena_mark _sauce_am __attribute__((cleanup(_sauce_arena_release))) = _sauce_arena_save();
+    if ((i == n)) {
+    return hits;
+    }
+    char* key = _sauce_concat_with(_sauce_arena_alloc, 4, (const char *[]){((char *)_sauce_lit0.s), _sauce_text_int(&(_sauce_text_intbuf){.hdr = {0, 0}}, i), ((char *)_sauce_lit1.s), _sauce_text_int(&(_sauce_text_intbuf){.hdr = {0, 0}}, n)});
+    if ((_sauce_text_eq(key, _sauce_concat_with(_sauce_arena_alloc, 2, (const char *[]){((char *)_sauce_lit2.s), _sauce_text_int(&(_sauce_text_intbuf){.hdr = {0, 0}}, n)})))) {
+    {
+    int _tco0 = (i + 1);
+    int _tco1 = n;
+    int _tco2 = (hits + 1);
+    i = _tco0;
+    n = _tco1;
+    hits = _tco2;
+    goto _tco_entry;
+    }
+    }
+    {
+    int _tco0 = (i + 1);
+    int _tco1 = n;
+    int _tco2 = hits;
+    i = _tco0;
+    n = _tco1;
+    hits = _tco2;
+    goto _tco_entry;
+    }
+}
+
+int main(void) {
+    printf("\n> ");
+    if (scanf("%d", &n) != 1) { /* erro na leitura de int */ } 
+    { int _c; while((_c = getchar()) != '\n' && _c != EOF); }
+    printf("%d\n", scan(0, n, 0));
+    return 0;
+}
@@ -10,13 +10,18 @@ int globalStmtCount = 0;
 
 // Variável para o token atual
 Token curtok;
+static int last_line = 0, last_col = 0; // Posição do último token consumido (usada por make_node)
 
 // Helper para criar um novo nó da AST
 Node *make_node(NodeKind kind, const char *name, const char *text, Node *left, Node *mid, Node *right) {
     Node *n = (Node *)malloc(sizeof(Node));
     if (!n) { perror("Erro ao alocar nó da AST"); exit(1); }
     memset(n, 0, sizeof(Node));
+    stats.ast_nodes++;
+    stats.ast_bytes += sizeof(Node);
     n->kind = kind;
+    n->line = last_line;
+    n->col = last_col;
     if (name) strncpy(n->name, name, MAX_TOKEN_LEN-1);
     if (text) strncpy(n->text, text, MAX_TOKEN_LEN-1);
     n->explicitReturnType[0] = '\0'; 
@@ -44,10 +49,15 @@ Node *make_return_node_with_type(const char *typeName, Node *expr) {
 // FUNÇÕES DE UTILIDADE E DE AVANÇO (AGORA MAIS ROBUSTAS)
 // ------------------------------------------------------------
 
-void advance() { curtok = next_token(); }
+void advance() {
+    last_line = curtok.line;
+    last_col = curtok.col;
+    curtok = next_token();
+}
 void expect(TokenType t) {
     if (curtok.type != t) {
-        fprintf(stderr, "Parse error: expected token %d but got token %d ('%s')\n", t, curtok.type, curtok.lexeme);
+        fprintf(stderr, "Parse error (%d:%d): expected token %d but got token %d ('%s')\n",
+                curtok.line, curtok.col, t, curtok.type, curtok.lexeme);
         exit(1);
     }
 }
@@ -67,9 +77,12 @@ static Node *parse_factor();
 static Node *parse_literal();    
 
 static Node *parse_call(const char *fn_name);
+static Node *parse_initializer();
+static void parse_type(char *out);
 static Node *parse_condition();
 static Node *parse_block_list();
 static Node *parse_statement(int is_global);
+static Node *parse_statement_body(int is_global);
 static Node *parse_function_definition();
 
 
@@ -186,6 +199,35 @@ static Node *parse_factor() {
         
         return make_node(N_VAR, name, NULL, NULL, NULL, NULL);
         
+    } else if (curtok.type == TOK_JOIN) {
+        // join(t): mesma forma de hear(x), a task é o N_VAR em 'left'
+        advance();
+        expect(TOK_LPAREN); advance();
+        expect(TOK_ID);
+        Node *task = make_node(N_VAR, curtok.lexeme, NULL, NULL, NULL, NULL);
+        advance();
+        skip_newlines();
+        expect(TOK_RPAREN); advance();
+        return make_node(N_JOIN, NULL, NULL, task, NULL, NULL);
+
+    } else if (curtok.type == TOK_RECV || curtok.type == TOK_NEXT) {
+        // recv(c, x): grava o próximo valor em x; false quando o canal está fechado e vazio
+        // next(g, x): mesma forma; false quando o gerador terminou
+        NodeKind kind = curtok.type == TOK_RECV ? N_RECV : N_NEXT;
+        advance();
+        expect(TOK_LPAREN); advance();
+        expect(TOK_ID);
+        Node *chan = make_node(N_VAR, curtok.lexeme, NULL, NULL, NULL, NULL);
+        advance();
+        expect(TOK_COMMA); advance();
+        skip_newlines();
+        expect(TOK_ID);
+        Node *target = make_node(N_VAR, curtok.lexeme, NULL, NULL, NULL, NULL);
+        advance();
+        skip_newlines();
+        expect(TOK_RPAREN); advance();
+        return make_node(kind, NULL, NULL, chan, NULL, target);
+
     } else if (curtok.type == TOK_LPAREN) {
         advance();
         Node *expr = parse_and_or(); 
@@ -262,13 +304,78 @@ static Node *parse_condition() {
     return parse_and_or(); 
 }
 
+// Tipo de variável ou parâmetro: TYPE, chan<TYPE> ou gen<TYPE> (elemento escalar ou text)
+static void parse_type(char *out) {
+    expect(TOK_TYPE);
+    strcpy(out, curtok.lexeme);
+    advance();
+    if (strcmp(out, "chan") != 0 && strcmp(out, "gen") != 0) return;
+
+    char outer[8]; strcpy(outer, out);
+    if (curtok.type != TOK_OPERATOR || strcmp(curtok.lexeme, "<") != 0) {
+        fprintf(stderr, "Erro de sintaxe (%d:%d): esperado '%s<tipo>'.\n", curtok.line, curtok.col, outer);
+        exit(1);
+    }
+    advance();
+    expect(TOK_TYPE);
+    if (strcmp(curtok.lexeme, "chan") == 0 || strcmp(curtok.lexeme, "task") == 0 || strcmp(curtok.lexeme, "gen") == 0) {
+        fprintf(stderr, "Erro de sintaxe (%d:%d): '%s' só transporta int, float, boolean ou text.\n",
+                curtok.line, curtok.col, outer);
+        exit(1);
+    }
+    snprintf(out, MAX_TOKEN_LEN, "%.4s<%.*s>", outer, MAX_TOKEN_LEN - 7, curtok.lexeme);
+    advance();
+    if (curtok.type != TOK_OPERATOR || strcmp(curtok.lexeme, ">") != 0) {
+        fprintf(stderr, "Erro de sintaxe (%d:%d): esperado '>' em '%s<tipo>'.\n", curtok.line, curtok.col, outer);
+        exit(1);
+    }
+    advance();
+}
+
+static int contains_yield(Node *n) {
+    if (!n) return 0;
+    return n->kind == N_YIELD || contains_yield(n->left) || contains_yield(n->mid) || contains_yield(n->right);
+}
+
+// Valor de declaração/atribuição: 'spawn f(args)' só pode aparecer aqui
+// (uma tarefa sempre tem uma variável task para o join)
+static Node *parse_initializer() {
+    if (curtok.type != TOK_SPAWN) return parse_and_or();
+    int line = curtok.line, col = curtok.col;
+    advance();
+    expect(TOK_ID);
+    char fn_name[MAX_TOKEN_LEN]; strcpy(fn_name, curtok.lexeme);
+    advance();
+    if (curtok.type != TOK_LPAREN) {
+        fprintf(stderr, "Erro de sintaxe (%d:%d): 'spawn' espera uma chamada de função.\n", curtok.line, curtok.col);
+        exit(1);
+    }
+    Node *spawn = make_node(N_SPAWN, NULL, NULL, parse_call(fn_name), NULL, NULL);
+    spawn->line = line;
+    spawn->col = col;
+    return spawn;
+}
+
 
 /* ------------------------------------------------------------
    STATEMENTS (Comandos) - Ajuste HEAR/SAY
    ------------------------------------------------------------ */
 
-// Analisa um comando que pode ser global ou local
+// O nó de um comando só é criado depois das suas expressões: recebe aqui a
+// posição do primeiro token (é ela que vai para os '#line' do C gerado)
 static Node *parse_statement(int is_global) {
+    skip_newlines();
+    int line = curtok.line, col = curtok.col;
+    Node *stmt = parse_statement_body(is_global);
+    if (stmt) {
+        stmt->line = line;
+        stmt->col = col;
+    }
+    return stmt;
+}
+
+// Analisa um comando que pode ser global ou local
+static Node *parse_statement_body(int is_global) {
     // skip_newlines() no início de parse_statement é NECESSÁRIO
     skip_newlines(); 
 
@@ -280,9 +387,8 @@ static Node *parse_statement(int is_global) {
         if (curtok.type == TOK_LBRACK) {
             // N_VAR_DECL: ID [ TYPE ] [ = EXPR ] <--- Permite declaração sem inicialização
             advance();
-            expect(TOK_TYPE);
-            char type[MAX_TOKEN_LEN]; strcpy(type, curtok.lexeme);
-            advance();
+            char type[MAX_TOKEN_LEN];
+            parse_type(type);
             expect(TOK_RBRACK); advance();
             
             // Permite newlines antes do '='
@@ -292,7 +398,7 @@ static Node *parse_statement(int is_global) {
             // Verifica se há inicialização com '='
             if (curtok.type == TOK_EQ) { 
                 advance(); // Consome '='
-                expr = parse_and_or(); 
+                expr = parse_initializer(); 
                 if (!expr) {
                     fprintf(stderr, "Erro de sintaxe: Expressão esperada após '=' em declaração.\n");
                     exit(1);
@@ -309,7 +415,7 @@ static Node *parse_statement(int is_global) {
         else if (curtok.type == TOK_EQ) {
             // N_VAR_ASSIGN: ID = EXPR
             advance();
-            Node *expr = parse_and_or(); 
+            Node *expr = parse_initializer(); 
             if (!expr) {
                 fprintf(stderr, "Erro de sintaxe: Expressão esperada após '=' em atribuição.\n");
                 exit(1);
@@ -375,8 +481,68 @@ static Node *parse_statement(int is_global) {
         return make_node(N_HEAR, NULL, NULL, make_node(N_VAR, varname, NULL, NULL, NULL, NULL), NULL, NULL);
     }
     
+    else if (curtok.type == TOK_JOIN || curtok.type == TOK_RECV || curtok.type == TOK_NEXT) {
+        // join(t) / recv(c, x) / next(g, x) como comando: o resultado é descartado
+        return make_node(N_EXPR_STMT, NULL, NULL, parse_and_or(), NULL, NULL);
+    }
+
+    else if (curtok.type == TOK_SEND || curtok.type == TOK_CLOSE) {
+        // send(c, expr) / close(c)
+        int is_send = curtok.type == TOK_SEND;
+        advance();
+        expect(TOK_LPAREN); advance();
+        expect(TOK_ID);
+        Node *chan = make_node(N_VAR, curtok.lexeme, NULL, NULL, NULL, NULL);
+        advance();
+        Node *value = NULL;
+        if (is_send) {
+            expect(TOK_COMMA); advance();
+            skip_newlines();
+            value = parse_and_or();
+            if (!value) {
+                fprintf(stderr, "Erro de sintaxe: Expressão esperada em 'send'.\n");
+                exit(1);
+            }
+        }
+        skip_newlines();
+        expect(TOK_RPAREN); advance();
+        return make_node(is_send ? N_SEND : N_CLOSE, NULL, NULL, chan, NULL, value);
+    }
+
+    else if (curtok.type == TOK_YIELD) {
+        // yield expr: só dentro de funções (a função vira gerador)
+        if (is_global) {
+            fprintf(stderr, "Erro de sintaxe (%d:%d): 'yield' só é permitido dentro de funções.\n", curtok.line, curtok.col);
+            exit(1);
+        }
+        advance();
+        Node *value = parse_and_or();
+        if (!value) {
+            fprintf(stderr, "Erro de sintaxe: Expressão esperada após 'yield'.\n");
+            exit(1);
+        }
+        return make_node(N_YIELD, NULL, NULL, value, NULL, NULL);
+    }
+
+    else if (curtok.type == TOK_STAGE) {
+        // stage f(args): estágio de pipeline (thread própria; o main espera todos no fim)
+        advance();
+        expect(TOK_ID);
+        char fn_name[MAX_TOKEN_LEN]; strcpy(fn_name, curtok.lexeme);
+        advance();
+        if (curtok.type != TOK_LPAREN) {
+            fprintf(stderr, "Erro de sintaxe (%d:%d): 'stage' espera uma chamada de função.\n", curtok.line, curtok.col);
+            exit(1);
+        }
+        return make_node(N_STAGE, NULL, NULL, parse_call(fn_name), NULL, NULL);
+    }
+
     else if (curtok.type == TOK_IF) {
         advance();
+        // if likely (...) / if unlikely (...): qual ramo é o quente
+        int hint = 0;
+        if (curtok.type == TOK_LIKELY) { hint = NODE_FLAG_LIKELY; advance(); }
+        else if (curtok.type == TOK_UNLIKELY) { hint = NODE_FLAG_UNLIKELY; advance(); }
         expect(TOK_LPAREN); advance();
         Node *cond = parse_condition();
         
@@ -406,7 +572,9 @@ static Node *parse_statement(int is_global) {
             }
         }
         
-        return make_node(N_IF, NULL, NULL, cond, else_block, then_block);
+        Node *if_node = make_node(N_IF, NULL, NULL, cond, else_block, then_block);
+        if_node->flags |= hint;
+        return if_node;
     }
     
     else if (curtok.type == TOK_RETURN) {
@@ -422,6 +590,12 @@ static Node *parse_statement(int is_global) {
             expect(TOK_RBRACK); advance();
         }
 
+        // 'return' sem valor: funções void e fim de geradores
+        if (explicit_type[0] == '\0' &&
+            (curtok.type == TOK_NEWLINE || curtok.type == TOK_RBRACE || curtok.type == TOK_EOF)) {
+            return make_return_node(NULL);
+        }
+
         Node *expr = parse_and_or(); 
         if (!expr) {
             fprintf(stderr, "Erro de sintaxe: Expressão esperada após 'return'.\n");
@@ -442,6 +616,39 @@ static Node *parse_statement(int is_global) {
         }
     }
     
+    else if (curtok.type == TOK_IMPORT) {
+        // N_IMPORT: import "arquivo.sauce" (apenas global)
+        if (!is_global) {
+            fprintf(stderr, "Erro de sintaxe: 'import' só é permitido no escopo global.\n");
+            exit(1);
+        }
+        advance();
+        expect(TOK_STRING);
+        Node *imp = make_node(N_IMPORT, NULL, curtok.lexeme, NULL, NULL, NULL);
+        advance();
+        return imp;
+    }
+
+    else if (curtok.type == TOK_BENCH) {
+        // N_BENCH: bench "nome" { BLOCO } (apenas global)
+        if (!is_global) {
+            fprintf(stderr, "Erro de sintaxe: 'bench' só é permitido no escopo global.\n");
+            exit(1);
+        }
+        advance();
+        expect(TOK_STRING);
+        char bench_name[MAX_TOKEN_LEN]; strcpy(bench_name, curtok.lexeme);
+        advance();
+
+        skip_newlines();
+
+        expect(TOK_LBRACE); advance();
+        Node *body = parse_block_list();
+        expect(TOK_RBRACE); advance();
+
+        return make_node(N_BENCH, NULL, bench_name, NULL, NULL, body);
+    }
+    
     else if (curtok.type == TOK_NEWLINE) {
         // Caso de múltiplas linhas vazias
         advance();
@@ -485,6 +692,7 @@ static Node *parse_block_list() {
 
 // Analisa a definição de uma função
 static Node *parse_function_definition() {
+    int line = curtok.line, col = curtok.col;
     expect(TOK_FN); advance();
     expect(TOK_ID);
     char fname[MAX_TOKEN_LEN]; strcpy(fname, curtok.lexeme);
@@ -501,9 +709,8 @@ static Node *parse_function_definition() {
         char param_name[MAX_TOKEN_LEN]; strcpy(param_name, curtok.lexeme);
         advance();
         expect(TOK_LBRACK); advance();
-        expect(TOK_TYPE);
-        char param_type[MAX_TOKEN_LEN]; strcpy(param_type, curtok.lexeme);
-        advance();
+        char param_type[MAX_TOKEN_LEN];
+        parse_type(param_type);
         expect(TOK_RBRACK); advance();
         
         Node *param_node = make_node(N_VAR_DECL, param_name, NULL, NULL, NULL, NULL);
@@ -522,9 +729,7 @@ static Node *parse_function_definition() {
             strcpy(param_name, curtok.lexeme);
             advance();
             expect(TOK_LBRACK); advance();
-            expect(TOK_TYPE);
-            strcpy(param_type, curtok.lexeme);
-            advance();
+            parse_type(param_type);
             expect(TOK_RBRACK); advance();
 
             param_node = make_node(N_VAR_DECL, param_name, NULL, NULL, NULL, NULL);
@@ -562,6 +767,9 @@ static Node *parse_function_definition() {
 
     Node *fn_def = make_node(N_FN_DEF, fname, NULL, param_list, body_list, NULL);
     strncpy(fn_def->typeName, ret_type, MAX_TOKEN_LEN-1);
+    if (contains_yield(body_list)) fn_def->flags |= NODE_FLAG_GENERATOR;
+    fn_def->line = line;
+    fn_def->col = col;
 
     return fn_def;
 }
@@ -571,12 +779,26 @@ static Node *parse_function_definition() {
    PARSE ALL (Ponto de Entrada)
    ------------------------------------------------------------ */
 void parse_all() {
+    parse_program();
+    generate_code("output.c", NULL); 
+}
+
+void parse_program() {
+    stats_enter(PHASE_PARSE);
     advance();
     skip_newlines();
 
     while (curtok.type != TOK_EOF) {
-        if (curtok.type == TOK_FN) {
+        if (curtok.type == TOK_FN || curtok.type == TOK_MEMO) {
+            // Anotação opcional: memo fn nome(...) { ... }
+            int flags = 0;
+            if (curtok.type == TOK_MEMO) {
+                flags |= NODE_FLAG_MEMO;
+                advance();
+                skip_newlines();
+            }
             Node *fn_def = parse_function_definition();
+            fn_def->flags |= flags;
             if (fnDefCount < MAX_FN_DEFS) {
                 fn_defs[fnDefCount++] = fn_def;
             } else {
@@ -585,6 +807,10 @@ void parse_all() {
             }
         } else {
             Node *stmt = parse_statement(1);
+            if (contains_yield(stmt)) { // Ex.: dentro de um bloco bench
+                fprintf(stderr, "Erro de sintaxe (%d:%d): 'yield' só é permitido dentro de funções.\n", stmt->line, stmt->col);
+                exit(1);
+            }
             if (globalStmtCount < MAX_FN_DEFS) { 
                 global_stmts[globalStmtCount++] = stmt;
             } else {
@@ -594,6 +820,5 @@ void parse_all() {
         }
         skip_newlines(); 
     }
-    
-    generate_code("output.c", NULL); 
+    stats_leave();
 }
\ No newline at end of file
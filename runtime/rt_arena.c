@@ -0,0 +1,23 @@
+// rt_arena.c -- Estado por thread e crescimento do arena de text
+
+#include "sauce_rt.h"
+
+_Thread_local _sauce_arena_chunk *_sauce_arena_top;
+_Thread_local _sauce_arena_chunk *_sauce_arena_spare;
+
+// Bloco novo no topo da pilha: reaproveita o reserva se couber
+void *_sauce_arena_grow(size_t size) {
+    _sauce_arena_chunk *c = _sauce_arena_spare;
+    if (c && size <= c->cap) {
+        _sauce_arena_spare = NULL;
+    } else {
+        size_t cap = size > SAUCE_ARENA_CHUNK ? size : SAUCE_ARENA_CHUNK;
+        c = malloc(sizeof(_sauce_arena_chunk) + cap);
+        if (SAUCE_UNLIKELY(!c)) { perror("malloc"); exit(1); }
+        c->cap = cap;
+    }
+    c->prev = _sauce_arena_top;
+    c->used = size;
+    _sauce_arena_top = c;
+    return c->data;
+}
@@ -0,0 +1,37 @@
+// rt_bench.c -- Runner dos blocos bench (--bench)
+
+#include "sauce_rt.h"
+
+#define SAUCE_BENCH_SAMPLES 101
+#define SAUCE_BENCH_TARGET_NS 1000000ULL
+
+static unsigned long long bench_now(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static int bench_cmp(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+// A calibração (dobra o lote até SAUCE_BENCH_TARGET_NS) serve de aquecimento;
+// depois coleta SAUCE_BENCH_SAMPLES amostras de ns/iteração e reporta mediana e p99.
+void _sauce_bench_run(const char *name, void (*body)(void)) {
+    unsigned long long batch = 1;
+    for (;;) {
+        unsigned long long t0 = bench_now();
+        for (unsigned long long i = 0; i < batch; i++) { body(); __asm__ volatile("" ::: "memory"); }
+        if (bench_now() - t0 >= SAUCE_BENCH_TARGET_NS || batch >= (1ULL << 40)) break;
+        batch *= 2;
+    }
+    double samples[SAUCE_BENCH_SAMPLES];
+    for (int k = 0; k < SAUCE_BENCH_SAMPLES; k++) {
+        unsigned long long t0 = bench_now();
+        for (unsigned long long i = 0; i < batch; i++) { body(); __asm__ volatile("" ::: "memory"); }
+        samples[k] = (double)(bench_now() - t0) / (double)batch;
+    }
+    qsort(samples, SAUCE_BENCH_SAMPLES, sizeof(double), bench_cmp);
+    fprintf(stderr, "bench %-24s median %12.1f ns/iter  p99 %12.1f ns/iter  (%llu iter/amostra)\n",
+            name, samples[SAUCE_BENCH_SAMPLES / 2], samples[(SAUCE_BENCH_SAMPLES * 99) / 100], batch);
+}
@@ -0,0 +1,113 @@
+// rt_chan.c -- Esperas dos canais e estágios
+//
+// Canais: anel limitado de Vyukov (número de sequência por célula). Com
+// NODE_FLAG_SPSC (um produtor e um consumidor, provado por analyze_channels) os
+// índices avançam com store simples em vez de CAS. A tentativa sem espera fica
+// inline em sauce_rt.h; aqui, quem não consegue enviar/receber gira um pouco e
+// depois dorme num futex. 'stage f(args)' roda f numa thread própria; o main
+// espera todos os estágios no fim.
+
+#include "sauce_rt.h"
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+long syscall(long number, ...);
+
+#define SAUCE_CHAN_SPINS 64
+
+_sauce_chan *_sauce_chan_new(size_t capacity, int spsc) {
+    _sauce_chan *c = calloc(1, sizeof(_sauce_chan) + capacity * sizeof(_sauce_cell));
+    if (SAUCE_UNLIKELY(!c)) { perror("calloc"); exit(1); }
+    c->spsc = spsc;
+    c->mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++) atomic_init(&c->cell[i].seq, i);
+    return c;
+}
+
+void _sauce_chan_futex_wake(atomic_uint *word, int count) {
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+// Dorme só se a palavra ainda vale 'seen': um wake entre a leitura e o wait não se perde
+static void chan_wait(atomic_uint *word, unsigned seen) {
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+}
+
+void _sauce_chan_send_wait(_sauce_chan *c, _sauce_value v) {
+    for (int spins = 0;; spins++) {
+        if (SAUCE_UNLIKELY(atomic_load(&c->closed))) {
+            fprintf(stderr, "Erro: send em um canal fechado.\n");
+            exit(1);
+        }
+        int sent = _sauce_chan_try_send(c, v);
+        if (!sent && spins < SAUCE_CHAN_SPINS) { sched_yield(); continue; }
+        if (!sent) {
+            unsigned seen = atomic_load(&c->not_full);
+            atomic_fetch_add(&c->send_waiters, 1);
+            sent = _sauce_chan_try_send(c, v);
+            if (!sent && !atomic_load(&c->closed)) chan_wait(&c->not_full, seen);
+            atomic_fetch_sub(&c->send_waiters, 1);
+        }
+        if (sent) { _sauce_chan_wake(&c->not_empty, &c->recv_waiters, 1); return; }
+    }
+}
+
+int _sauce_chan_recv_wait(_sauce_chan *c, _sauce_value *out) {
+    for (int spins = 0;; spins++) {
+        int got = _sauce_chan_try_recv(c, out);
+        if (!got && atomic_load(&c->closed)) {
+            // close vem depois do último send: uma nova tentativa decide
+            if (!_sauce_chan_try_recv(c, out)) return 0;
+            got = 1;
+        }
+        if (!got && spins < SAUCE_CHAN_SPINS) { sched_yield(); continue; }
+        if (!got) {
+            unsigned seen = atomic_load(&c->not_empty);
+            atomic_fetch_add(&c->recv_waiters, 1);
+            got = _sauce_chan_try_recv(c, out);
+            if (!got && !atomic_load(&c->closed)) chan_wait(&c->not_empty, seen);
+            atomic_fetch_sub(&c->recv_waiters, 1);
+        }
+        if (got) { _sauce_chan_wake(&c->not_full, &c->send_waiters, 1); return 1; }
+    }
+}
+
+void _sauce_chan_close(_sauce_chan *c) {
+    atomic_store(&c->closed, 1);
+    _sauce_chan_wake(&c->not_empty, &c->recv_waiters, INT_MAX);
+    _sauce_chan_wake(&c->not_full, &c->send_waiters, INT_MAX);
+}
+
+// Estágios em execução: o main faz join de todos antes de sair
+typedef struct _sauce_stage { pthread_t thread; struct _sauce_stage *next; } _sauce_stage;
+static _sauce_stage *stages;
+static pthread_mutex_t stage_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void _sauce_stage_start(void *(*run)(void *), void *args) {
+    _sauce_stage *st = malloc(sizeof *st);
+    if (SAUCE_UNLIKELY(!st)) { perror("malloc"); exit(1); }
+    if (SAUCE_UNLIKELY(pthread_create(&st->thread, NULL, run, args) != 0)) {
+        fprintf(stderr, "Erro: não foi possível criar a thread do estágio.\n");
+        exit(1);
+    }
+    pthread_mutex_lock(&stage_lock);
+    st->next = stages;
+    stages = st;
+    pthread_mutex_unlock(&stage_lock);
+}
+
+// Estágios podem criar estágios: repete até a lista ficar vazia
+void _sauce_stage_wait_all(void) {
+    for (;;) {
+        pthread_mutex_lock(&stage_lock);
+        _sauce_stage *st = stages;
+        if (st) stages = st->next;
+        pthread_mutex_unlock(&stage_lock);
+        if (!st) return;
+        pthread_join(st->thread, NULL);
+        free(st);
+    }
+}
@@ -0,0 +1,211 @@
+// rt_io.c -- say/hear sem stdio (perfil --static)
+//
+// A saída vai para um buffer próprio despejado com write(2) quando enche e na
+// saída do processo (num terminal, a cada linha, como o stdio); a entrada vem
+// de read(2) num buffer próprio. Cada say escreve a linha inteira sob o lock
+// (estágios e tarefas também imprimem). Os formatos e o consumo da entrada
+// seguem os do printf/scanf/fgets do perfil normal.
+
+#include "sauce_rt.h"
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define SAUCE_IO_BUF 65536
+#define SAUCE_HEAR_TEXT_MAX 1023 // Como o fgets de 1024 do perfil normal
+
+static char out_buf[SAUCE_IO_BUF];
+static size_t out_len;
+static int out_registered;
+static int out_tty;
+static atomic_flag out_lock = ATOMIC_FLAG_INIT;
+
+static char in_buf[SAUCE_IO_BUF];
+static size_t in_pos, in_len;
+static int in_eof;
+static atomic_flag in_lock = ATOMIC_FLAG_INIT;
+
+static void write_all(const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(1, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+}
+
+static void out_flush(void) {
+    write_all(out_buf, out_len);
+    out_len = 0;
+}
+
+// Outra thread pode ter chamado exit() no meio de um say: espera um pouco, não para sempre
+static void out_at_exit(void) {
+    for (int spins = 0; spins < 1000000 && atomic_flag_test_and_set_explicit(&out_lock, memory_order_acquire); spins++) {}
+    out_flush();
+}
+
+static void out_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&out_lock, memory_order_acquire)) {}
+    if (SAUCE_UNLIKELY(!out_registered)) {
+        out_registered = 1;
+        out_tty = isatty(1);
+        atexit(out_at_exit);
+    }
+}
+
+static void out_release(void) {
+    atomic_flag_clear_explicit(&out_lock, memory_order_release);
+}
+
+static void out_put(const char *s, size_t n) {
+    if (n > SAUCE_IO_BUF - out_len) {
+        out_flush();
+        if (n > SAUCE_IO_BUF) {
+            write_all(s, n);
+            return;
+        }
+    }
+    memcpy(out_buf + out_len, s, n);
+    out_len += n;
+}
+
+static void say_line(const char *s, size_t n) {
+    out_acquire();
+    out_put(s, n);
+    out_put("\n", 1);
+    if (out_tty) out_flush();
+    out_release();
+}
+
+void _sauce_say_int(int x) {
+    char b[16];
+    char *p = b + sizeof b;
+    unsigned v = x < 0 ? 0u - (unsigned)x : (unsigned)x;
+    do { *--p = (char)('0' + v % 10); v /= 10; } while (v);
+    if (x < 0) *--p = '-';
+    say_line(p, (size_t)(b + sizeof b - p));
+}
+
+void _sauce_say_float(double x) {
+    char b[SAUCE_FLOAT_CHARS];
+    int n = snprintf(b, sizeof b, "%f", x);
+    say_line(b, n > 0 ? (size_t)n : 0);
+}
+
+void _sauce_say_bool(int x) {
+    if (x) say_line("true", 4);
+    else say_line("false", 5);
+}
+
+void _sauce_say_text(const char *s) {
+    say_line(s ? s : "", s ? _SAUCE_TEXT_HDR(s)->len : 0);
+}
+
+// --- Entrada ---
+
+static void in_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&in_lock, memory_order_acquire)) {}
+}
+
+static void in_release(void) {
+    atomic_flag_clear_explicit(&in_lock, memory_order_release);
+}
+
+// -1 no fim da entrada
+static int in_peek(void) {
+    if (in_pos == in_len) {
+        if (in_eof) return -1;
+        ssize_t r;
+        do { r = read(0, in_buf, sizeof in_buf); } while (r < 0 && errno == EINTR);
+        if (r <= 0) {
+            in_eof = 1;
+            return -1;
+        }
+        in_pos = 0;
+        in_len = (size_t)r;
+    }
+    return (unsigned char)in_buf[in_pos];
+}
+
+static void in_skip_space(void) {
+    int c;
+    while ((c = in_peek()) >= 0 && isspace(c)) in_pos++;
+}
+
+// Descarta o resto da linha (inclusive o '\n'), como o laço de getchar do perfil normal
+static void in_skip_line(void) {
+    int c;
+    while ((c = in_peek()) >= 0) {
+        in_pos++;
+        if (c == '\n') return;
+    }
+}
+
+// O prompt só precisa sair antes da leitura quando alguém está olhando
+static void hear_prompt(void) {
+    out_acquire();
+    out_put("\n> ", 3);
+    if (out_tty) out_flush();
+    out_release();
+    in_acquire();
+}
+
+// Leitura sem número válido deixa a variável como estava (scanf devolvendo 0)
+void _sauce_hear_int(int *x) {
+    hear_prompt();
+    in_skip_space();
+    int c = in_peek(), neg = 0;
+    if (c == '-' || c == '+') {
+        neg = c == '-';
+        in_pos++;
+        c = in_peek();
+    }
+    if (c >= '0' && c <= '9') {
+        unsigned v = 0;
+        while ((c = in_peek()) >= '0' && c <= '9') {
+            v = v * 10 + (unsigned)(c - '0');
+            in_pos++;
+        }
+        *x = (int)(neg ? 0u - v : v);
+    }
+    in_skip_line();
+    in_release();
+}
+
+void _sauce_hear_float(double *x) {
+    char tok[512];
+    size_t n = 0;
+    int c;
+    hear_prompt();
+    in_skip_space();
+    while (n < sizeof tok - 1 && (c = in_peek()) >= 0 && !isspace(c)) {
+        tok[n++] = (char)c;
+        in_pos++;
+    }
+    tok[n] = '\0';
+    char *end;
+    double v = strtod(tok, &end);
+    if (end != tok) *x = v;
+    in_skip_line();
+    in_release();
+}
+
+// Pula espaços e linhas vazias e lê uma linha sem o '\n'
+char *_sauce_hear_text(char *(*alloc)(size_t)) {
+    char line[SAUCE_HEAR_TEXT_MAX];
+    size_t n = 0;
+    int c;
+    hear_prompt();
+    in_skip_space();
+    while (n < SAUCE_HEAR_TEXT_MAX && (c = in_peek()) >= 0) {
+        in_pos++;
+        if (c == '\n') break;
+        line[n++] = (char)c;
+    }
+    in_release();
+    return _sauce_text_new_with(alloc, line, n);
+}
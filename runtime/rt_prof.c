@@ -0,0 +1,90 @@
+// rt_prof.c -- Estado e relatórios do perfil (--profile)
+
+#include "sauce_rt.h"
+
+_Thread_local unsigned long long _sauce_prof_calls[SAUCE_PROF_MAX_FN];
+_Thread_local unsigned long long _sauce_prof_incl[SAUCE_PROF_MAX_FN];
+_Thread_local unsigned long long _sauce_prof_self[SAUCE_PROF_MAX_FN];
+_Thread_local int _sauce_prof_active[SAUCE_PROF_MAX_FN];
+_Thread_local _sauce_prof_frame _sauce_prof_stack[SAUCE_PROF_MAX_DEPTH];
+_Thread_local int _sauce_prof_depth = 0;
+_Thread_local _sauce_prof_node _sauce_prof_nodes[SAUCE_PROF_MAX_NODES] = {{-1, -1, -1, -1, 0}};
+static _Thread_local int prof_node_count = 1;
+
+// Tabelas do programa, registradas por _sauce_prof_start
+static const char *const *prof_names;
+static int prof_nfn;
+static const int (*prof_br_pos)[2];
+static unsigned long long (*prof_br)[2];
+static int prof_nbr;
+
+int _sauce_prof_child_node(int parent, int fn) {
+    int c = _sauce_prof_nodes[parent].child;
+    for (; c >= 0; c = _sauce_prof_nodes[c].sibling) if (_sauce_prof_nodes[c].fn == fn) return c;
+    if (prof_node_count >= SAUCE_PROF_MAX_NODES) return parent;
+    c = prof_node_count++;
+    _sauce_prof_nodes[c].fn = fn; _sauce_prof_nodes[c].parent = parent; _sauce_prof_nodes[c].child = -1;
+    _sauce_prof_nodes[c].sibling = _sauce_prof_nodes[parent].child; _sauce_prof_nodes[c].self = 0;
+    _sauce_prof_nodes[parent].child = c;
+    return c;
+}
+
+static int prof_cmp(const void *a, const void *b) {
+    unsigned long long x = _sauce_prof_self[*(const int *)a], y = _sauce_prof_self[*(const int *)b];
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void prof_write_stack(FILE *f, int node) {
+    if (node <= 0) { fputs("main", f); return; }
+    prof_write_stack(f, _sauce_prof_nodes[node].parent);
+    fprintf(f, ";%s", prof_names[_sauce_prof_nodes[node].fn]);
+}
+
+static void prof_branch_report(void) {
+    FILE *f = fopen("sauce-profile.branches", "w");
+    if (!f) return;
+    fprintf(f, "# linha:coluna verdadeiro falso\n");
+    for (int i = 0; i < prof_nbr; i++) {
+        if (!prof_br[i][0] && !prof_br[i][1]) continue;
+        fprintf(f, "%d:%d %llu %llu\n", prof_br_pos[i][0], prof_br_pos[i][1], prof_br[i][0], prof_br[i][1]);
+    }
+    fclose(f);
+}
+
+static void prof_report(void) {
+    int order[SAUCE_PROF_MAX_FN];
+    for (int i = 0; i < prof_nfn; i++) order[i] = i;
+    qsort(order, prof_nfn, sizeof(int), prof_cmp);
+    FILE *f = fopen("sauce-profile.txt", "w");
+    if (f) {
+        fprintf(f, "%-24s %12s %14s %14s\n", "function", "calls", "self_ms", "incl_ms");
+        for (int k = 0; k < prof_nfn; k++) {
+            int i = order[k];
+            if (!_sauce_prof_calls[i]) continue;
+            fprintf(f, "%-24s %12llu %14.3f %14.3f\n", prof_names[i], _sauce_prof_calls[i],
+                    _sauce_prof_self[i] / 1e6, _sauce_prof_incl[i] / 1e6);
+        }
+        fclose(f);
+    }
+    f = fopen("sauce-profile.folded", "w");
+    if (f) {
+        for (int n = 1; n < prof_node_count; n++) {
+            if (!_sauce_prof_nodes[n].self) continue;
+            prof_write_stack(f, n);
+            fprintf(f, " %llu\n", _sauce_prof_nodes[n].self);
+        }
+        fclose(f);
+    }
+    prof_branch_report();
+    fprintf(stderr, "[profile] sauce-profile.txt / sauce-profile.folded / sauce-profile.branches escritos\n");
+}
+
+void _sauce_prof_start(const char *const *names, int nfn, const int (*br_pos)[2],
+                       unsigned long long (*br)[2], int nbr) {
+    prof_names = names;
+    prof_nfn = nfn < SAUCE_PROF_MAX_FN ? nfn : SAUCE_PROF_MAX_FN;
+    prof_br_pos = br_pos;
+    prof_br = br;
+    prof_nbr = nbr;
+    atexit(prof_report);
+}
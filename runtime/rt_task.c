@@ -0,0 +1,197 @@
+// rt_task.c -- Pool de trabalho de spawn/join
+//
+// Cada trabalhador tem um deque Chase-Lev: o dono empilha e desempilha no fundo
+// (LIFO, localidade), ladrões tiram do topo (FIFO, tarefas maiores). A thread que
+// faz o primeiro spawn (main) é o trabalhador 0; join executa outras tarefas
+// enquanto espera, então nenhum trabalhador fica bloqueado. SAUCE_WORKERS define
+// o número de threads. Threads que não são do pool (estágios) executam o spawn na hora.
+
+#include "sauce_rt.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define SAUCE_MAX_WORKERS 64
+#define SAUCE_DEQUE_INITIAL 256
+#define SAUCE_IDLE_SPINS 64
+typedef struct { long mask; _Atomic(_sauce_task *) slot[]; } _sauce_ring;
+typedef struct {
+    _Alignas(64) atomic_long top;
+    _Alignas(64) atomic_long bottom;
+    _Atomic(_sauce_ring *) ring;
+} _sauce_deque;
+
+static _sauce_deque _sauce_deques[SAUCE_MAX_WORKERS];
+static int _sauce_nworkers;
+static _Thread_local int _sauce_worker_id = -1;
+static _Thread_local unsigned _sauce_steal_seed;
+static pthread_once_t _sauce_pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t _sauce_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _sauce_pool_wake = PTHREAD_COND_INITIALIZER;
+static atomic_int _sauce_sleepers;
+
+static _sauce_ring *_sauce_ring_new(long capacity) {
+    _sauce_ring *r = malloc(sizeof(_sauce_ring) + capacity * sizeof(r->slot[0]));
+    if (SAUCE_UNLIKELY(!r)) { perror("malloc"); exit(1); }
+    r->mask = capacity - 1;
+    return r;
+}
+
+// Só o dono do deque chama push/take
+static void _sauce_deque_push(_sauce_deque *d, _sauce_task *t) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    _sauce_ring *r = atomic_load_explicit(&d->ring, memory_order_relaxed);
+    if (b - top > r->mask) {
+        // Cheio: dobra o anel. O antigo não é liberado (um ladrão ainda pode lê-lo)
+        _sauce_ring *bigger = _sauce_ring_new(2 * (r->mask + 1));
+        for (long i = top; i < b; i++) {
+            atomic_store_explicit(&bigger->slot[i & bigger->mask],
+                                  atomic_load_explicit(&r->slot[i & r->mask], memory_order_relaxed), memory_order_relaxed);
+        }
+        atomic_store_explicit(&d->ring, bigger, memory_order_release);
+        r = bigger;
+    }
+    atomic_store_explicit(&r->slot[b & r->mask], t, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+}
+
+static _sauce_task *_sauce_deque_take(_sauce_deque *d) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    _sauce_ring *r = atomic_load_explicit(&d->ring, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (top > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    _sauce_task *t = atomic_load_explicit(&r->slot[b & r->mask], memory_order_relaxed);
+    if (top == b) {
+        // Último elemento: disputa com os ladrões pelo topo
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) t = NULL;
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return t;
+}
+
+static _sauce_task *_sauce_deque_steal(_sauce_deque *d) {
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (top >= b) return NULL;
+    _sauce_ring *r = atomic_load_explicit(&d->ring, memory_order_acquire);
+    _sauce_task *t = atomic_load_explicit(&r->slot[top & r->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) return NULL;
+    return t;
+}
+
+// Primeiro o próprio deque; depois rouba a partir de uma vítima aleatória
+static _sauce_task *_sauce_find_task(void) {
+    int self = _sauce_worker_id;
+    _sauce_task *t = _sauce_deque_take(&_sauce_deques[self]);
+    if (t || _sauce_nworkers < 2) return t;
+    unsigned x = _sauce_steal_seed;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    _sauce_steal_seed = x;
+    for (int k = 0; k < _sauce_nworkers; k++) {
+        int victim = (int)((x + (unsigned)k) % (unsigned)_sauce_nworkers);
+        if (victim == self) continue;
+        t = _sauce_deque_steal(&_sauce_deques[victim]);
+        if (t) return t;
+    }
+    return NULL;
+}
+
+static void _sauce_run_task(_sauce_task *t) {
+    t->run(t);
+    atomic_store_explicit(&t->done, 1, memory_order_release);
+}
+
+static int _sauce_pool_has_work(void) {
+    atomic_thread_fence(memory_order_seq_cst);
+    for (int v = 0; v < _sauce_nworkers; v++) {
+        if (atomic_load_explicit(&_sauce_deques[v].bottom, memory_order_relaxed) >
+            atomic_load_explicit(&_sauce_deques[v].top, memory_order_relaxed)) return 1;
+    }
+    return 0;
+}
+
+static void *_sauce_worker_main(void *arg) {
+    _sauce_worker_id = (int)(long)arg;
+    _sauce_steal_seed = 2654435761u * (unsigned)(_sauce_worker_id + 1);
+    int idle = 0;
+    for (;;) {
+        _sauce_task *t = _sauce_find_task();
+        if (t) { _sauce_run_task(t); idle = 0; continue; }
+        if (++idle < SAUCE_IDLE_SPINS) { sched_yield(); continue; }
+        // Dorme até o próximo spawn; o timeout cobre um aviso perdido
+        pthread_mutex_lock(&_sauce_pool_lock);
+        atomic_fetch_add(&_sauce_sleepers, 1);
+        if (!_sauce_pool_has_work()) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += 10000000L;
+            if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+            pthread_cond_timedwait(&_sauce_pool_wake, &_sauce_pool_lock, &ts);
+        }
+        atomic_fetch_sub(&_sauce_sleepers, 1);
+        pthread_mutex_unlock(&_sauce_pool_lock);
+        idle = 0;
+    }
+    return NULL;
+}
+
+static void _sauce_pool_init(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *env = getenv("SAUCE_WORKERS");
+    if (env && atoi(env) > 0) n = atoi(env);
+    if (n < 1) n = 1;
+    if (n > SAUCE_MAX_WORKERS) n = SAUCE_MAX_WORKERS;
+    _sauce_nworkers = (int)n;
+    for (int i = 0; i < _sauce_nworkers; i++) {
+        atomic_store(&_sauce_deques[i].ring, _sauce_ring_new(SAUCE_DEQUE_INITIAL));
+    }
+    _sauce_worker_id = 0;
+    _sauce_steal_seed = 2654435761u;
+    for (int i = 1; i < _sauce_nworkers; i++) {
+        pthread_t th;
+        if (SAUCE_UNLIKELY(pthread_create(&th, NULL, _sauce_worker_main, (void *)(long)i) != 0)) {
+            fprintf(stderr, "Erro: não foi possível criar a thread de trabalho %d.\n", i);
+            exit(1);
+        }
+        pthread_detach(th);
+    }
+}
+
+void _sauce_task_submit(_sauce_task *t, void (*run)(_sauce_task *)) {
+    pthread_once(&_sauce_pool_once, _sauce_pool_init);
+    t->run = run;
+    atomic_init(&t->done, 0);
+    if (_sauce_worker_id < 0) { _sauce_run_task(t); return; }
+    _sauce_deque_push(&_sauce_deques[_sauce_worker_id], t);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&_sauce_sleepers, memory_order_relaxed) > 0) {
+        pthread_mutex_lock(&_sauce_pool_lock);
+        pthread_cond_signal(&_sauce_pool_wake);
+        pthread_mutex_unlock(&_sauce_pool_lock);
+    }
+}
+
+// Consome a task: a variável volta a NULL (um segundo join é erro)
+_sauce_value _sauce_join(_sauce_task **slot) {
+    _sauce_task *t = *slot;
+    if (SAUCE_UNLIKELY(!t)) {
+        fprintf(stderr, "Erro: join de uma task vazia (sem spawn ou já consumida).\n");
+        exit(1);
+    }
+    while (!atomic_load_explicit(&t->done, memory_order_acquire)) {
+        _sauce_task *other = _sauce_find_task();
+        if (other) _sauce_run_task(other);
+        else sched_yield();
+    }
+    _sauce_value v = t->result;
+    free(t);
+    *slot = NULL;
+    return v;
+}
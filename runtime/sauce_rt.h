@@ -0,0 +1,452 @@
+// sauce_rt.h -- Interface do runtime dos programas Sauce
+//
+// O C gerado inclui este cabeçalho em vez de receber o runtime colado em cada
+// output.c. Aqui ficam os tipos e os caminhos rápidos 'static inline' (text,
+// concatenação, arena, memoização, contadores do perfil, envio/recebimento em
+// canais); o resto (pool de tarefas, esperas dos canais, estágios, relatórios
+// do perfil, runner de bench) é compilado uma vez em libsauce_rt.a. Cada parte
+// da biblioteca é um objeto separado: o link só puxa o que o programa usa.
+
+#ifndef SAUCE_RT_H
+#define SAUCE_RT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// Dicas de desvio: 'if likely/unlikely', perfil e verificações de erro do runtime
+#define SAUCE_LIKELY(x) __builtin_expect(!!(x), 1)
+#define SAUCE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+// ------------------------------------------
+// --- Text ---
+// ------------------------------------------
+
+// Todo valor text aponta para os bytes logo depois de um cabeçalho com tamanho e
+// hash (FNV-1a): literais são objetos estáticos internados (um por texto distinto),
+// e cópias, hear, canais e concatenações alocam pelo runtime. A igualdade testa o
+// ponteiro, depois tamanho e hash, e só então compara os bytes. NULL (text não
+// inicializado) vale como o text vazio. 'kind' diz de onde veio a memória: só o
+// que saiu do malloc é liberado (literais e valores do arena nunca).
+enum { SAUCE_TEXT_STATIC, SAUCE_TEXT_HEAP, SAUCE_TEXT_ARENA };
+typedef struct { unsigned long long hash; size_t len; unsigned char kind; } _sauce_text_hdr; // hash 0: desconhecido
+#define _SAUCE_TEXT_HDR(s) ((_sauce_text_hdr *)(s) - 1)
+#define SAUCE_TEXT_HASH_INIT 1469598103934665603ULL
+
+static inline unsigned long long _sauce_text_hash_more(unsigned long long h, const char *s, size_t n) {
+    for (size_t i = 0; i < n; i++) { h ^= (unsigned char)s[i]; h *= 1099511628211ULL; }
+    return h;
+}
+
+static inline unsigned long long _sauce_text_seal(unsigned long long h) { return h ? h : 1; }
+
+static inline char *_sauce_text_alloc(size_t len) {
+    _sauce_text_hdr *h = malloc(sizeof(_sauce_text_hdr) + len + 1);
+    if (SAUCE_UNLIKELY(!h)) { perror("malloc"); exit(1); }
+    h->len = len;
+    h->hash = 0;
+    h->kind = SAUCE_TEXT_HEAP;
+    return (char *)(h + 1);
+}
+
+// Cópias com o alocador dado (heap ou arena): o hash já conhecido vem junto
+static inline char *_sauce_text_new_with(char *(*alloc)(size_t), const char *s, size_t len) {
+    char *t = alloc(len);
+    memcpy(t, s, len);
+    t[len] = '\0';
+    _SAUCE_TEXT_HDR(t)->hash = _sauce_text_seal(_sauce_text_hash_more(SAUCE_TEXT_HASH_INIT, s, len));
+    return t;
+}
+
+static inline char *_sauce_text_dup_with(char *(*alloc)(size_t), const char *s) {
+    if (!s) return NULL;
+    const _sauce_text_hdr *h = _SAUCE_TEXT_HDR(s);
+    char *t = alloc(h->len);
+    memcpy(t, s, h->len + 1);
+    _SAUCE_TEXT_HDR(t)->hash = h->hash;
+    return t;
+}
+
+static inline char *_sauce_text_new(const char *s, size_t len) { return _sauce_text_new_with(_sauce_text_alloc, s, len); }
+static inline char *_sauce_text_dup(const char *s) { return _sauce_text_dup_with(_sauce_text_alloc, s); }
+static inline void _sauce_text_free(char *s) { if (s && _SAUCE_TEXT_HDR(s)->kind == SAUCE_TEXT_HEAP) free(_SAUCE_TEXT_HDR(s)); }
+
+static inline unsigned long long _sauce_text_hash(const char *s) {
+    const _sauce_text_hdr *h = _SAUCE_TEXT_HDR(s);
+    return h->hash ? h->hash : _sauce_text_seal(_sauce_text_hash_more(SAUCE_TEXT_HASH_INIT, s, h->len));
+}
+
+static inline int _sauce_text_eq(const char *a, const char *b) {
+    if (a == b) return 1;
+    if (!a || !b) return *(a ? a : b) == '\0';
+    const _sauce_text_hdr *x = _SAUCE_TEXT_HDR(a), *y = _SAUCE_TEXT_HDR(b);
+    if (x->len != y->len || (x->hash && y->hash && x->hash != y->hash)) return 0;
+    return memcmp(a, b, x->len) == 0;
+}
+
+static inline int _sauce_text_cmp(const char *a, const char *b) {
+    return a == b ? 0 : strcmp(a ? a : "", b ? b : "");
+}
+
+// ------------------------------------------
+// --- Concatenação ---
+// ------------------------------------------
+
+// Uma cadeia 'a + b + 1 + ...' vira uma só chamada: soma os tamanhos dos cabeçalhos,
+// aloca uma vez e copia (números são formatados na pilha, como no say).
+#define SAUCE_FLOAT_CHARS 320 // '%f' de qualquer double
+typedef struct { _sauce_text_hdr hdr; char s[12]; } _sauce_text_intbuf;
+typedef struct { _sauce_text_hdr hdr; char s[SAUCE_FLOAT_CHARS]; } _sauce_text_floatbuf;
+typedef struct { size_t cap; char *own; } _sauce_textbuf; // own: valor atual, se é nosso; cap == 0: sem folga para crescer
+
+static inline const char *_sauce_text_int(_sauce_text_intbuf *b, int x) { b->hdr.len = snprintf(b->s, sizeof b->s, "%d", x); return b->s; }
+static inline const char *_sauce_text_float(_sauce_text_floatbuf *b, double x) { b->hdr.len = snprintf(b->s, sizeof b->s, "%f", x); return b->s; }
+
+static inline size_t _sauce_text_measure(int count, const char **parts, size_t *lens) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        lens[i] = parts[i] ? _SAUCE_TEXT_HDR(parts[i])->len : 0;
+        total += lens[i];
+    }
+    return total;
+}
+
+static inline void _sauce_text_copy(char *dst, int count, const char **parts, const size_t *lens) {
+    for (int i = 0; i < count; i++) { if (lens[i]) memcpy(dst, parts[i], lens[i]); dst += lens[i]; }
+    *dst = '\0';
+}
+
+static inline char *_sauce_concat_with(char *(*alloc)(size_t), int count, const char **parts) {
+    size_t lens[count];
+    size_t len = _sauce_text_measure(count, parts, lens);
+    char *s = alloc(len);
+    _sauce_text_copy(s, count, parts, lens);
+    _SAUCE_TEXT_HDR(s)->hash = _sauce_text_seal(_sauce_text_hash_more(SAUCE_TEXT_HASH_INIT, s, len));
+    return s;
+}
+
+static inline char *_sauce_concat(int count, const char **parts) { return _sauce_concat_with(_sauce_text_alloc, count, parts); }
+
+// s + parts: os pedaços podem citar o próprio s (só lemos [0, len) antes de trocá-lo);
+// o hash continua de onde parou
+static inline char *_sauce_append(char *s, _sauce_textbuf *b, int count, const char **parts) {
+    size_t lens[count];
+    size_t add = _sauce_text_measure(count, parts, lens);
+    size_t len = s ? _SAUCE_TEXT_HDR(s)->len : 0;
+    unsigned long long h = s ? _SAUCE_TEXT_HDR(s)->hash : 0;
+    char *t = s;
+    if (len + add + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 32;
+        while (cap < len + add + 1) cap *= 2;
+        _sauce_text_hdr *grown = malloc(sizeof(_sauce_text_hdr) + cap);
+        if (SAUCE_UNLIKELY(!grown)) { perror("malloc"); exit(1); }
+        grown->kind = SAUCE_TEXT_HEAP;
+        t = (char *)(grown + 1);
+        if (len) memcpy(t, s, len);
+        _sauce_text_copy(t + len, count, parts, lens);
+        _sauce_text_free(b->own); // Valor anterior de fora (own == NULL) não é nosso para liberar
+        b->cap = cap;
+        b->own = t;
+    } else {
+        _sauce_text_copy(t + len, count, parts, lens);
+    }
+    h = h > 1 ? _sauce_text_hash_more(h, t + len, add) : _sauce_text_hash_more(SAUCE_TEXT_HASH_INIT, t, len + add);
+    _SAUCE_TEXT_HDR(t)->len = len + add;
+    _SAUCE_TEXT_HDR(t)->hash = _sauce_text_seal(h);
+    return t;
+}
+
+// Saída da função (cleanup): o buffer que não foi devolvido é liberado
+static inline void _sauce_textbuf_release(_sauce_textbuf *b) { _sauce_text_free(b->own); }
+
+// Outro valor no lugar do buffer sem passar pelo free de uma atribuição (nova declaração, TCO)
+static inline void _sauce_textbuf_drop(_sauce_textbuf *b) { _sauce_textbuf_release(b); b->cap = 0; b->own = NULL; }
+
+// 'return s': o buffer passa para quem chamou; um valor que não é do buffer vira cópia
+// própria, então o resultado nunca é guardado por mais ninguém
+static inline char *_sauce_textbuf_take(_sauce_textbuf *b, char *s) {
+    if (b->own) { b->cap = 0; b->own = NULL; return s; }
+    return s && _SAUCE_TEXT_HDR(s)->kind == SAUCE_TEXT_STATIC ? s : _sauce_text_dup(s);
+}
+
+// ------------------------------------------
+// --- Arena por chamada (rt_arena.c) ---
+// ------------------------------------------
+
+// Uma pilha de blocos por thread onde alocar é avançar um índice. A função guarda
+// a marca na entrada e volta a ela em qualquer return (cleanup) e a cada volta da
+// TCO; só o crescimento (bloco novo) sai do caminho inline.
+#define SAUCE_ARENA_CHUNK 65536
+typedef struct _sauce_arena_chunk { struct _sauce_arena_chunk *prev; size_t cap, used; char data[]; } _sauce_arena_chunk;
+typedef struct { _sauce_arena_chunk *chunk; size_t used; } _sauce_arena_mark;
+extern _Thread_local _sauce_arena_chunk *_sauce_arena_top;
+extern _Thread_local _sauce_arena_chunk *_sauce_arena_spare; // Evita malloc/free alternados na fronteira de um bloco
+void *_sauce_arena_grow(size_t size);
+
+static inline _sauce_arena_mark _sauce_arena_save(void) {
+    _sauce_arena_mark m = { _sauce_arena_top, _sauce_arena_top ? _sauce_arena_top->used : 0 };
+    return m;
+}
+
+static inline void _sauce_arena_release(_sauce_arena_mark *m) {
+    while (_sauce_arena_top != m->chunk) {
+        _sauce_arena_chunk *c = _sauce_arena_top;
+        _sauce_arena_top = c->prev;
+        if (!_sauce_arena_spare && c->cap == SAUCE_ARENA_CHUNK) _sauce_arena_spare = c;
+        else free(c);
+    }
+    if (_sauce_arena_top) _sauce_arena_top->used = m->used;
+}
+
+static inline char *_sauce_arena_alloc(size_t len) {
+    size_t size = (sizeof(_sauce_text_hdr) + len + 1 + 7) & ~(size_t)7;
+    _sauce_arena_chunk *c = _sauce_arena_top;
+    _sauce_text_hdr *h;
+    if (SAUCE_LIKELY(c && c->cap - c->used >= size)) { h = (_sauce_text_hdr *)(c->data + c->used); c->used += size; }
+    else h = _sauce_arena_grow(size);
+    h->len = len;
+    h->hash = 0;
+    h->kind = SAUCE_TEXT_ARENA;
+    return (char *)(h + 1);
+}
+
+// Literais são imutáveis e eternos: não precisam de cópia
+static inline char *_sauce_arena_dup(const char *s) {
+    if (s && _SAUCE_TEXT_HDR(s)->kind == SAUCE_TEXT_STATIC) return (char *)s;
+    return _sauce_text_dup_with(_sauce_arena_alloc, s);
+}
+
+// Resultado novo de uma chamada (ninguém mais o guarda): copia para o arena e libera
+static inline char *_sauce_arena_take(char *s) {
+    char *t = _sauce_arena_dup(s);
+    if (t != s) _sauce_text_free(s);
+    return t;
+}
+
+// ------------------------------------------
+// --- Memoização ---
+// ------------------------------------------
+
+#define SAUCE_MEMO_SIZE 4096
+
+static inline unsigned long long _sauce_memo_mix(unsigned long long h, unsigned long long v) {
+    h ^= v; h *= 0xff51afd7ed558ccdULL; h ^= h >> 33; return h;
+}
+
+static inline unsigned long long _sauce_memo_dbits(double d) {
+    unsigned long long u; memcpy(&u, &d, sizeof u); return u;
+}
+
+// ------------------------------------------
+// --- Geradores ---
+// ------------------------------------------
+
+typedef struct _sauce_gen {
+    int (*next)(struct _sauce_gen *, void *); // 0: terminou; senão grava o valor
+} _sauce_gen;
+
+// ------------------------------------------
+// --- Tarefas (rt_task.c) ---
+// ------------------------------------------
+
+typedef union { int i; double f; char *s; } _sauce_value;
+
+// Os wrappers de spawn gerados embutem _sauce_task como primeiro campo
+typedef struct _sauce_task {
+    void (*run)(struct _sauce_task *);
+    atomic_int done;
+    _sauce_value result;
+} _sauce_task;
+
+void _sauce_task_submit(_sauce_task *t, void (*run)(_sauce_task *));
+_sauce_value _sauce_join(_sauce_task **slot);
+
+// ------------------------------------------
+// --- Canais e estágios (rt_chan.c) ---
+// ------------------------------------------
+
+// Anel limitado de Vyukov. A tentativa sem espera fica inline; girar, dormir no
+// futex e fechar ficam na biblioteca.
+#ifndef SAUCE_CHAN_CAPACITY
+#define SAUCE_CHAN_CAPACITY 1024 // Potência de 2
+#endif
+typedef struct { atomic_size_t seq; _sauce_value v; } _sauce_cell;
+typedef struct {
+    _Alignas(64) atomic_size_t head; // Próxima célula a enviar
+    _Alignas(64) atomic_size_t tail; // Próxima célula a receber
+    _Alignas(64) atomic_uint not_empty;
+    atomic_int recv_waiters;
+    _Alignas(64) atomic_uint not_full;
+    atomic_int send_waiters;
+    atomic_int closed;
+    int spsc;
+    size_t mask;
+    _sauce_cell cell[];
+} _sauce_chan;
+
+_sauce_chan *_sauce_chan_new(size_t capacity, int spsc);
+void _sauce_chan_close(_sauce_chan *c);
+void _sauce_chan_send_wait(_sauce_chan *c, _sauce_value v);
+int _sauce_chan_recv_wait(_sauce_chan *c, _sauce_value *out);
+void _sauce_chan_futex_wake(atomic_uint *word, int count);
+void _sauce_stage_start(void *(*run)(void *), void *args);
+void _sauce_stage_wait_all(void);
+
+static inline int _sauce_chan_try_send(_sauce_chan *c, _sauce_value v) {
+    size_t pos = atomic_load_explicit(&c->head, memory_order_relaxed);
+    _sauce_cell *cell;
+    for (;;) {
+        cell = &c->cell[pos & c->mask];
+        long dif = (long)(atomic_load_explicit(&cell->seq, memory_order_acquire) - pos);
+        if (dif < 0) return 0; // Cheio
+        if (dif > 0) { pos = atomic_load_explicit(&c->head, memory_order_relaxed); continue; }
+        if (c->spsc) { atomic_store_explicit(&c->head, pos + 1, memory_order_relaxed); break; }
+        if (atomic_compare_exchange_weak_explicit(&c->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+    }
+    cell->v = v;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return 1;
+}
+
+static inline int _sauce_chan_try_recv(_sauce_chan *c, _sauce_value *out) {
+    size_t pos = atomic_load_explicit(&c->tail, memory_order_relaxed);
+    _sauce_cell *cell;
+    for (;;) {
+        cell = &c->cell[pos & c->mask];
+        long dif = (long)(atomic_load_explicit(&cell->seq, memory_order_acquire) - (pos + 1));
+        if (dif < 0) return 0; // Vazio
+        if (dif > 0) { pos = atomic_load_explicit(&c->tail, memory_order_relaxed); continue; }
+        if (c->spsc) { atomic_store_explicit(&c->tail, pos + 1, memory_order_relaxed); break; }
+        if (atomic_compare_exchange_weak_explicit(&c->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+    }
+    *out = cell->v;
+    atomic_store_explicit(&cell->seq, pos + c->mask + 1, memory_order_release);
+    return 1;
+}
+
+// Avança a palavra do futex (seq_cst: ordenado com o incremento de waiters do outro lado)
+static inline void _sauce_chan_wake(atomic_uint *word, atomic_int *waiters, int count) {
+    atomic_fetch_add(word, 1);
+    if (atomic_load(waiters) > 0) _sauce_chan_futex_wake(word, count);
+}
+
+static inline void _sauce_chan_send(_sauce_chan *c, _sauce_value v) {
+    if (SAUCE_LIKELY(!atomic_load(&c->closed) && _sauce_chan_try_send(c, v))) {
+        _sauce_chan_wake(&c->not_empty, &c->recv_waiters, 1);
+        return;
+    }
+    _sauce_chan_send_wait(c, v);
+}
+
+// 0: canal fechado e já vazio
+static inline int _sauce_chan_recv(_sauce_chan *c, _sauce_value *out) {
+    if (SAUCE_LIKELY(_sauce_chan_try_recv(c, out))) {
+        _sauce_chan_wake(&c->not_full, &c->send_waiters, 1);
+        return 1;
+    }
+    return _sauce_chan_recv_wait(c, out);
+}
+
+static inline void _sauce_send_int(_sauce_chan *c, int x) { _sauce_value v; v.i = x; _sauce_chan_send(c, v); }
+static inline void _sauce_send_float(_sauce_chan *c, double x) { _sauce_value v; v.f = x; _sauce_chan_send(c, v); }
+// text: o canal leva uma cópia (o remetente continua dono da sua string)
+static inline void _sauce_send_text(_sauce_chan *c, const char *x) { _sauce_value v; v.s = _sauce_text_dup(x); _sauce_chan_send(c, v); }
+
+static inline int _sauce_recv_int(_sauce_chan *c, int *x) {
+    _sauce_value v;
+    if (!_sauce_chan_recv(c, &v)) return 0;
+    *x = v.i;
+    return 1;
+}
+
+static inline int _sauce_recv_float(_sauce_chan *c, double *x) {
+    _sauce_value v;
+    if (!_sauce_chan_recv(c, &v)) return 0;
+    *x = v.f;
+    return 1;
+}
+
+static inline int _sauce_recv_text(_sauce_chan *c, char **x) {
+    _sauce_value v;
+    if (!_sauce_chan_recv(c, &v)) return 0;
+    _sauce_text_free(*x);
+    *x = v.s;
+    return 1;
+}
+
+// ------------------------------------------
+// --- Perfil (--profile, rt_prof.c) ---
+// ------------------------------------------
+
+// Contadores thread-local por função, pilha sombra para tempo inclusivo/exclusivo
+// e uma árvore de contextos de chamada (CCT) para as pilhas colapsadas. Entrada e
+// saída ficam inline; o programa registra os nomes e os contadores de desvio com
+// _sauce_prof_start e os relatórios são escritos na saída.
+#define SAUCE_PROF_MAX_FN 4096 // MAX_FN_DEFS do compilador (compiler.h): o programa verifica com _Static_assert
+#define SAUCE_PROF_MAX_DEPTH 4096
+#define SAUCE_PROF_MAX_NODES 16384
+typedef struct { int fn; unsigned long long start, child; int node; } _sauce_prof_frame;
+typedef struct { int fn, parent, child, sibling; unsigned long long self; } _sauce_prof_node;
+extern _Thread_local unsigned long long _sauce_prof_calls[SAUCE_PROF_MAX_FN];
+extern _Thread_local unsigned long long _sauce_prof_incl[SAUCE_PROF_MAX_FN];
+extern _Thread_local unsigned long long _sauce_prof_self[SAUCE_PROF_MAX_FN];
+extern _Thread_local int _sauce_prof_active[SAUCE_PROF_MAX_FN];
+extern _Thread_local _sauce_prof_frame _sauce_prof_stack[SAUCE_PROF_MAX_DEPTH];
+extern _Thread_local int _sauce_prof_depth;
+extern _Thread_local _sauce_prof_node _sauce_prof_nodes[SAUCE_PROF_MAX_NODES];
+
+int _sauce_prof_child_node(int parent, int fn);
+void _sauce_prof_start(const char *const *names, int nfn, const int (*br_pos)[2],
+                       unsigned long long (*br)[2], int nbr);
+
+static inline unsigned long long _sauce_prof_now(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static inline int _sauce_prof_enter(int fn) {
+    int d = _sauce_prof_depth++;
+    _sauce_prof_calls[fn]++;
+    if (d >= SAUCE_PROF_MAX_DEPTH) return d;
+    int parent = d > 0 ? _sauce_prof_stack[d - 1].node : 0;
+    _sauce_prof_stack[d].fn = fn; _sauce_prof_stack[d].child = 0;
+    _sauce_prof_stack[d].node = _sauce_prof_child_node(parent, fn);
+    _sauce_prof_active[fn]++;
+    _sauce_prof_stack[d].start = _sauce_prof_now();
+    return d;
+}
+
+static inline void _sauce_prof_exit(int *frame) {
+    int d = *frame;
+    _sauce_prof_depth = d;
+    if (d >= SAUCE_PROF_MAX_DEPTH) return;
+    _sauce_prof_frame *f = &_sauce_prof_stack[d];
+    unsigned long long elapsed = _sauce_prof_now() - f->start;
+    unsigned long long self = elapsed > f->child ? elapsed - f->child : 0;
+    _sauce_prof_self[f->fn] += self;
+    _sauce_prof_nodes[f->node].self += self;
+    if (--_sauce_prof_active[f->fn] == 0) _sauce_prof_incl[f->fn] += elapsed; // Recursão: só a ativação externa
+    if (d > 0) _sauce_prof_stack[d - 1].child += elapsed;
+}
+
+// ------------------------------------------
+// --- say/hear sem stdio (--static, rt_io.c) ---
+// ------------------------------------------
+
+void _sauce_say_int(int x);
+void _sauce_say_float(double x);
+void _sauce_say_bool(int x);
+void _sauce_say_text(const char *s);
+void _sauce_hear_int(int *x);
+void _sauce_hear_float(double *x);
+char *_sauce_hear_text(char *(*alloc)(size_t)); // Valor novo com o alocador dado (heap ou arena)
+
+// ------------------------------------------
+// --- Blocos bench (--bench, rt_bench.c) ---
+// ------------------------------------------
+
+void _sauce_bench_run(const char *name, void (*body)(void));
+
+#endif
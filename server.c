@@ -0,0 +1,492 @@
+// server.c -- Servidor de compilação persistente ('compiler serve <socket>').
+//
+// O processo do servidor guarda em memória a AST de cada arquivo .sauce já
+// visto (indexada pelo caminho absoluto, validada por mtime/tamanho e hash do
+// conteúdo). Cada pedido roda num processo filho (fork): o filho herda as ASTs
+// sem copiar nada, só relê/reparseia os arquivos que mudaram e, no build
+// normal, gera uma unidade C por função em sauce-units/. Só as unidades cujo
+// texto mudou são recompiladas. Os erros do compilador continuam terminando
+// com exit(1): isso derruba apenas o filho, nunca o servidor.
+//
+// Protocolo: o cliente envia cwd e argv como strings terminadas em '\0',
+// seguidas de uma string vazia; o servidor devolve stdout+stderr do build e,
+// no último byte, o código de saída.
+
+#define _DEFAULT_SOURCE // realpath
+#include "compiler.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_PATH 1024
+#define MAX_CMD 8192
+#define MAX_CACHED_FILES 128
+#define MAX_REQUEST 16384
+#define MAX_REQUEST_ARGS 64
+#define REQUEST_TIMEOUT_S 5
+#define UNIT_DIR "sauce-units"
+
+typedef struct {
+    char path[MAX_PATH];            // Caminho absoluto
+    struct timespec mtime;
+    off_t size;
+    unsigned long long hash;        // Hash do conteúdo parseado
+    Node *fns[MAX_FN_DEFS];
+    int fnCount;
+    Node *stmts[MAX_FN_DEFS];
+    int stmtCount;
+} CachedFile;
+
+static CachedFile cache[MAX_CACHED_FILES];
+static int cacheCount = 0;
+
+static int worker_active = 0; // Processo filho atendendo um pedido
+static int report_fd = -1;    // Filho -> servidor: arquivos parseados fora do cache
+static const char *listen_path = NULL;
+
+// --- Utilidades ---
+
+static unsigned long long hash_text(const char *s) {
+    unsigned long long h = 1469598103934665603ULL;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int absolute_path(const char *path, char *out) {
+    char resolved[PATH_MAX];
+    if (!realpath(path, resolved)) return 0;
+    size_t len = strlen(resolved);
+    if (len + 1 >= MAX_PATH) return 0; // +1: load_source acrescenta '\n'
+    memcpy(out, resolved, len + 1);
+    return 1;
+}
+
+static CachedFile *find_cached(const char *abs) {
+    for (int i = 0; i < cacheCount; i++) {
+        if (strcmp(cache[i].path, abs) == 0) return &cache[i];
+    }
+    return NULL;
+}
+
+static int same_stat(const CachedFile *c, const struct stat *st) {
+    return c->size == st->st_size && c->mtime.tv_sec == st->st_mtim.tv_sec &&
+           c->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static void free_tree(Node *n) {
+    if (!n) return;
+    free_tree(n->left);
+    free_tree(n->mid);
+    free_tree(n->right);
+    free(n);
+}
+
+static void write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, buf, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return;
+        buf += w;
+        len -= (size_t)w;
+    }
+}
+
+// ------------------------------------------
+// --- Carga de Fontes (com ou sem servidor) ---
+// ------------------------------------------
+
+// No filho: copia a AST guardada pelo servidor se o arquivo não mudou desde então
+static int restore_cached(const char *path) {
+    char abs[MAX_PATH];
+    struct stat st;
+    if (!worker_active || !absolute_path(path, abs) || stat(abs, &st) != 0) return 0;
+
+    CachedFile *c = find_cached(abs);
+    if (!c || !same_stat(c, &st)) return 0;
+
+    fnDefCount = c->fnCount;
+    memcpy(fn_defs, c->fns, sizeof(Node *) * c->fnCount);
+    globalStmtCount = c->stmtCount;
+    memcpy(global_stmts, c->stmts, sizeof(Node *) * c->stmtCount);
+    stats.source_bytes += (long)st.st_size;
+    return 1;
+}
+
+int load_source(const char *path) {
+    if (restore_cached(path)) return 1;
+
+    stats_enter(PHASE_READ);
+    char *src = read_file(path);
+    stats_leave();
+    if (!src) return 0;
+    stats.source_bytes += (long)strlen(src);
+
+    fnDefCount = 0;
+    globalStmtCount = 0;
+    lexer_init_from_string(src);
+    parse_program();
+    free(src);
+
+    // Avisa o servidor para guardar esta AST para os próximos pedidos
+    char abs[MAX_PATH];
+    if (worker_active && report_fd >= 0 && absolute_path(path, abs)) {
+        size_t len = strlen(abs);
+        abs[len] = '\n';
+        write_all(report_fd, abs, len + 1);
+    }
+    return 1;
+}
+
+int server_worker_active() {
+    return worker_active;
+}
+
+// ------------------------------------------
+// --- Cache de ASTs (processo do servidor) ---
+// ------------------------------------------
+
+// O parser termina o processo em erro de sintaxe; por isso o conteúdo novo é
+// validado num filho antes de ser parseado no servidor.
+static int parses_cleanly(const char *src) {
+    pid_t pid = fork();
+    if (pid < 0) return 0;
+    if (pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) {
+            dup2(devnull, 1);
+            dup2(devnull, 2);
+        }
+        fnDefCount = 0;
+        globalStmtCount = 0;
+        lexer_init_from_string(src);
+        parse_program();
+        _exit(0);
+    }
+    int status;
+    if (waitpid(pid, &status, 0) < 0) return 0;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void refresh_cached(const char *abs) {
+    struct stat st;
+    CachedFile *c = find_cached(abs);
+    if (stat(abs, &st) != 0) return;
+    if (c && same_stat(c, &st)) return;
+
+    char *src = read_file(abs);
+    if (!src) return;
+    unsigned long long h = hash_text(src);
+
+    // Só o mtime mudou (ex.: 'touch', checkout): a AST guardada continua valendo
+    if (c && c->hash == h) {
+        c->mtime = st.st_mtim;
+        c->size = st.st_size;
+        free(src);
+        return;
+    }
+    if (!parses_cleanly(src)) {
+        free(src);
+        return;
+    }
+    if (!c) {
+        if (cacheCount >= MAX_CACHED_FILES) { free(src); return; }
+        c = &cache[cacheCount++];
+        snprintf(c->path, MAX_PATH, "%s", abs);
+    } else {
+        for (int i = 0; i < c->fnCount; i++) free_tree(c->fns[i]);
+        for (int i = 0; i < c->stmtCount; i++) free_tree(c->stmts[i]);
+    }
+
+    fnDefCount = 0;
+    globalStmtCount = 0;
+    lexer_init_from_string(src);
+    parse_program();
+    free(src);
+
+    c->mtime = st.st_mtim;
+    c->size = st.st_size;
+    c->hash = h;
+    c->fnCount = fnDefCount;
+    memcpy(c->fns, fn_defs, sizeof(Node *) * fnDefCount);
+    c->stmtCount = globalStmtCount;
+    memcpy(c->stmts, global_stmts, sizeof(Node *) * globalStmtCount);
+    fnDefCount = 0;
+    globalStmtCount = 0;
+    fprintf(stderr, "[serve] AST em cache: %s\n", abs);
+}
+
+// ------------------------------------------
+// --- Servidor ---
+// ------------------------------------------
+
+static void on_signal(int sig) {
+    (void)sig;
+    if (listen_path) unlink(listen_path);
+    _exit(0);
+}
+
+// Lê cwd + argv; retorna argc (sem contar argv[0]) ou -1
+static int read_request(int conn, char *buf, char **cwd, char **args) {
+    size_t len = 0;
+    for (;;) {
+        if (len == MAX_REQUEST) return -1;
+        ssize_t got = read(conn, buf + len, MAX_REQUEST - len);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return -1;
+        len += (size_t)got;
+        // Terminado por uma string vazia: "\0\0" no fim
+        if (len >= 2 && buf[len - 1] == '\0' && buf[len - 2] == '\0') break;
+    }
+
+    *cwd = buf;
+    int argc = 0;
+    char *p = buf + strlen(buf) + 1;
+    while (*p && argc < MAX_REQUEST_ARGS) {
+        args[argc++] = p;
+        p += strlen(p) + 1;
+    }
+    return argc;
+}
+
+static void handle_request(int conn, int listen_fd, int (*driver)(int argc, char **argv)) {
+    char buf[MAX_REQUEST];
+    char *cwd;
+    char *argv[MAX_REQUEST_ARGS + 2];
+    argv[0] = "compiler";
+    int argc = read_request(conn, buf, &cwd, argv + 1);
+    if (argc < 0) return;
+    argc++;
+    argv[argc] = NULL;
+
+    int report[2];
+    if (pipe(report) != 0) { perror("pipe"); return; }
+
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(report[0]);
+        close(report[1]);
+        return;
+    }
+    if (pid == 0) {
+        close(listen_fd);
+        close(report[0]);
+        report_fd = report[1];
+        worker_active = 1;
+        dup2(conn, 1);
+        dup2(conn, 2);
+        close(conn);
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        if (chdir(cwd) != 0) { perror("chdir"); _exit(1); }
+        memset(&stats, 0, sizeof(stats));
+        exit(driver(argc, argv));
+    }
+    close(report[1]);
+
+    // Caminhos parseados pelo filho (lidos antes do waitpid para o filho nunca bloquear)
+    size_t cap = 4096, len = 0;
+    char *paths = malloc(cap);
+    ssize_t got;
+    while ((got = read(report[0], paths + len, cap - len - 1)) != 0) {
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        len += (size_t)got;
+        if (len + 1 == cap) {
+            cap *= 2;
+            paths = realloc(paths, cap);
+            if (!paths) { perror("realloc"); exit(1); }
+        }
+    }
+    paths[len] = '\0';
+    close(report[0]);
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    unsigned char code = WIFEXITED(status) ? (unsigned char)WEXITSTATUS(status) : 1;
+    write_all(conn, (const char *)&code, 1);
+    close(conn);
+
+    // Fora do caminho crítico: o cliente já recebeu a resposta
+    for (char *line = strtok(paths, "\n"); line; line = strtok(NULL, "\n")) {
+        refresh_cached(line);
+    }
+    free(paths);
+}
+
+int server_main(const char *socket_path, int (*driver)(int argc, char **argv)) {
+    struct sockaddr_un addr;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Erro: Caminho do socket muito longo: %s\n", socket_path);
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) { perror("socket"); return 1; }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) { perror("bind"); return 1; }
+    if (listen(fd, 16) != 0) { perror("listen"); return 1; }
+
+    listen_path = socket_path;
+    signal(SIGPIPE, SIG_IGN); // Cliente que desconecta no meio não derruba o servidor
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    fprintf(stderr, "[serve] Aguardando pedidos em %s\n", socket_path);
+
+    // Um pedido por vez: os builds escrevem no diretório do projeto
+    for (;;) {
+        int conn = accept(fd, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR) continue;
+            perror("accept");
+            return 1;
+        }
+        struct timeval timeout = { REQUEST_TIMEOUT_S, 0 };
+        setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        handle_request(conn, fd, driver);
+        close(conn);
+    }
+}
+
+// ------------------------------------------
+// --- Cliente ---
+// ------------------------------------------
+
+int server_request(const char *socket_path, int argc, char **argv) {
+    struct sockaddr_un addr;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    char cwd[MAX_PATH];
+    if (!getcwd(cwd, sizeof(cwd))) { close(fd); return -1; }
+    signal(SIGPIPE, SIG_IGN);
+    write_all(fd, cwd, strlen(cwd) + 1);
+    for (int i = 1; i < argc; i++) {
+        // O filho do servidor compila localmente: não repassa --server
+        if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) { i++; continue; }
+        write_all(fd, argv[i], strlen(argv[i]) + 1);
+    }
+    write_all(fd, "", 1);
+    shutdown(fd, SHUT_WR);
+
+    // Repassa a saída para stderr; o último byte recebido é o código de saída
+    char buf[4096];
+    int pending = -1;
+    ssize_t got;
+    while ((got = read(fd, buf, sizeof(buf))) != 0) {
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pending >= 0) {
+            char c = (char)pending;
+            write_all(2, &c, 1);
+        }
+        write_all(2, buf, (size_t)got - 1);
+        pending = (unsigned char)buf[got - 1];
+    }
+    close(fd);
+
+    if (pending < 0) {
+        fprintf(stderr, "Erro: O servidor encerrou a conexão sem resposta.\n");
+        return 1;
+    }
+    return pending;
+}
+
+// ------------------------------------------
+// --- Build por Função (sauce-units/) ---
+// ------------------------------------------
+
+// Uma unidade por função + uma para globais e main(). Como cada unidade só
+// declara o que usa, o texto gerado é a própria análise de impacto: mudou o
+// corpo, uma assinatura chamada ou o resultado de um inlining, mudou o .c.
+int build_function_units(const char *cc_flags, int jobs, const char *outfile) {
+    mkdir(UNIT_DIR, 0755);
+    prepare_program(1);
+
+    // Flags diferentes invalidam todos os objetos
+    int flags_changed = write_if_changed(UNIT_DIR "/cc-flags", cc_flags);
+
+    int units = fnDefCount + 1;
+    char **cmds = malloc(sizeof(char *) * units);
+    size_t link_size = (size_t)units * (MAX_TOKEN_LEN + 32) + MAX_CMD;
+    char *link = malloc(link_size);
+    int link_len = snprintf(link, link_size, "cc %s", cc_flags);
+    int count = 0;
+
+    for (int u = -1; u < fnDefCount; u++) {
+        char name[MAX_TOKEN_LEN + 8], path[MAX_PATH], tmp[MAX_PATH + 8], obj[MAX_PATH];
+        if (u < 0) snprintf(name, sizeof(name), "program");
+        else snprintf(name, sizeof(name), "fn_%s", fn_defs[u]->name);
+
+        snprintf(path, sizeof(path), UNIT_DIR "/%s.c", name);
+        snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+        snprintf(obj, sizeof(obj), UNIT_DIR "/%s.o", name);
+        generate_unit(tmp, u);
+
+        int changed = replace_if_changed(tmp, path);
+        if (changed || flags_changed || !file_exists(obj)) {
+            remove(obj); // Se o cc falhar, o .o antigo não pode parecer atualizado
+            cmds[count] = malloc(MAX_CMD);
+            snprintf(cmds[count++], MAX_CMD, "cc %s -c %s -o %s", cc_flags, path, obj);
+        }
+        link_len += snprintf(link + link_len, link_size - link_len, " %s", obj);
+    }
+    snprintf(link + link_len, link_size - link_len, " '%s/libsauce_rt.a' -o '%s'", runtime_dir(), outfile);
+
+    // Função removida ou renomeada: nenhum objeto novo, mas o link muda
+    char manifest[MAX_PATH];
+    snprintf(manifest, sizeof(manifest), UNIT_DIR "/link-cmd");
+    int link_changed = write_if_changed(manifest, link);
+
+    stats_enter(PHASE_CC);
+    fprintf(stderr, "Compiling %d of %d unit(s) with up to %d job(s)\n", count, units, jobs);
+    int ok = run_commands_parallel(cmds, count, jobs);
+    if (!ok) {
+        fprintf(stderr, "Compilation of function units failed\n");
+        remove(manifest); // Força o link na próxima build
+    } else if (count > 0 || link_changed || !file_exists(outfile)) {
+        fprintf(stderr, "  [ld] %s\n", outfile);
+        int rc = system(link);
+        if (rc != 0) {
+            fprintf(stderr, "Link failed with error code %d\n", rc);
+            remove(manifest);
+            ok = 0;
+        }
+    } else {
+        fprintf(stderr, "  '%s' está atualizado\n", outfile);
+    }
+    stats_leave();
+
+    for (int i = 0; i < count; i++) free(cmds[i]);
+    free(cmds);
+    free(link);
+    return ok;
+}
@@ -0,0 +1,102 @@
+// stats.c -- Auto-profiling do compilador: tempo por fase e contadores
+
+#include "compiler.h"
+#include <time.h>
+#include <sys/resource.h>
+
+#define STATS_MAX_NESTING 16
+
+CompilerStats stats = {0};
+int stats_enabled = 0;
+
+static const char *PHASE_NAMES[PHASE_COUNT] = {
+    "read", "lex", "parse", "analysis", "codegen", "cc"
+};
+
+// Pilha de fases ativas: o tempo é sempre cobrado da fase do topo (tempo exclusivo),
+// então 'lex' chamado de dentro de 'parse' não é contado duas vezes.
+static Phase phase_stack[STATS_MAX_NESTING];
+static int phase_depth = 0;
+static double phase_mark = 0.0;
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void charge_current() {
+    double now = now_seconds();
+    if (phase_depth > 0) {
+        stats.phase_time[phase_stack[phase_depth - 1]] += now - phase_mark;
+    }
+    phase_mark = now;
+}
+
+void stats_enter(Phase phase) {
+    if (!stats_enabled) return;
+    charge_current();
+    if (phase_depth < STATS_MAX_NESTING) {
+        phase_stack[phase_depth++] = phase;
+    }
+}
+
+void stats_leave() {
+    if (!stats_enabled) return;
+    charge_current();
+    if (phase_depth > 0) phase_depth--;
+}
+
+static long peak_rss_kb() {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return ru.ru_maxrss; // Linux: KB
+}
+
+static void report_text(FILE *out, int timings, int counters) {
+    if (timings) {
+        double total = 0.0;
+        fprintf(out, "===== Tempo por fase =====\n");
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            total += stats.phase_time[i];
+        }
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            double ms = stats.phase_time[i] * 1e3;
+            fprintf(out, "  %-10s %10.3f ms  %5.1f%%\n", PHASE_NAMES[i], ms,
+                    total > 0 ? 100.0 * stats.phase_time[i] / total : 0.0);
+        }
+        fprintf(out, "  %-10s %10.3f ms\n", "total", total * 1e3);
+    }
+    if (counters) {
+        fprintf(out, "===== Contadores =====\n");
+        fprintf(out, "  %-16s %ld\n", "source_bytes", stats.source_bytes);
+        fprintf(out, "  %-16s %ld\n", "tokens", stats.tokens);
+        fprintf(out, "  %-16s %ld\n", "ast_nodes", stats.ast_nodes);
+        fprintf(out, "  %-16s %ld\n", "ast_bytes", stats.ast_bytes);
+        fprintf(out, "  %-16s %ld\n", "symbol_lookups", stats.symbol_lookups);
+        fprintf(out, "  %-16s %ld\n", "c_bytes", stats.c_bytes);
+        fprintf(out, "  %-16s %ld\n", "peak_rss_kb", peak_rss_kb());
+    }
+}
+
+static void report_json(FILE *out) {
+    fprintf(out, "{\"phases_ms\": {");
+    double total = 0.0;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        fprintf(out, "%s\"%s\": %.3f", i ? ", " : "", PHASE_NAMES[i], stats.phase_time[i] * 1e3);
+        total += stats.phase_time[i];
+    }
+    fprintf(out, "}, \"total_ms\": %.3f, ", total * 1e3);
+    fprintf(out, "\"counters\": {\"source_bytes\": %ld, \"tokens\": %ld, \"ast_nodes\": %ld, \"ast_bytes\": %ld, "
+                 "\"symbol_lookups\": %ld, \"c_bytes\": %ld, \"peak_rss_kb\": %ld}}\n",
+            stats.source_bytes, stats.tokens, stats.ast_nodes, stats.ast_bytes,
+            stats.symbol_lookups, stats.c_bytes, peak_rss_kb());
+}
+
+void stats_report(FILE *out, int timings, int counters, int json) {
+    if (json) {
+        report_json(out);
+    } else {
+        report_text(out, timings, counters);
+    }
+}
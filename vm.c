@@ -0,0 +1,897 @@
+// vm.c -- 'sauce run': compila a AST para bytecode de registradores e executa no próprio processo
+//
+// Sem output.c e sem cc: para scripts e iterações rápidas. A semântica segue a do
+// C gerado (int de 32 bits com wrap, double, conversões implícitas, formatos do say).
+//
+//  - Bytecode: instruções de tamanho fixo (op, a, b, c) sobre registradores do quadro.
+//    Parâmetros ocupam os primeiros registradores, depois as locais, depois temporários.
+//  - Valores sem caixa: um registrador é um union int/double/char*; o tipo é conhecido
+//    em tempo de compilação, então a instrução já é a especializada (ADDI, ADDF...).
+//  - Chamadas: os argumentos são avaliados em registradores consecutivos no topo do
+//    quadro do chamador, que viram os parâmetros do quadro novo (sem cópia).
+//  - Despacho por computed goto (GCC/Clang), com 'switch' como alternativa portátil.
+
+#include "compiler.h"
+#include <limits.h>
+
+#define VM_STACK_SLOTS (1 << 22) // Registradores de todos os quadros vivos
+#define VM_MAX_FRAMES (1 << 20)
+#define VM_MAX_LOCALS 1024
+#define VM_HEAR_BUF 1024
+
+// X-macro: a mesma lista gera o enum e a tabela de rótulos do despacho
+#define VM_OPS(X) \
+    X(MOV) X(LOADI) X(LOADF) X(LOADS) X(ZERO) X(LOADG) X(STOREG) \
+    X(ADDI) X(SUBI) X(MULI) X(DIVI) X(ADDK) \
+    X(ADDF) X(SUBF) X(MULF) X(DIVF) X(I2F) X(F2I) \
+    X(LTI) X(LEI) X(GTI) X(GEI) X(EQI) X(NEI) \
+    X(LTF) X(LEF) X(GTF) X(GEF) X(EQF) X(NEF) \
+    X(LTP) X(LEP) X(GTP) X(GEP) X(EQP) X(NEP) \
+    X(NOT) X(TRUTHI) X(TRUTHF) X(TRUTHP) \
+    X(JMP) X(JZ) X(JNZ) X(JLTI) X(JLEI) X(JGTI) X(JGEI) X(JEQI) X(JNEI) \
+    X(CALL) X(RET) \
+    X(SAYI) X(SAYF) X(SAYS) X(SAYB) X(SAYERR) \
+    X(HEARI) X(HEARF) X(HEARS) \
+    X(STRDUP) X(FREE)
+
+#define VM_ENUM(n) OP_##n,
+typedef enum { VM_OPS(VM_ENUM) OP_COUNT } VmOp;
+
+typedef struct {
+    int op;
+    int a, b, c; // Registradores, imediato, índice de constante ou destino de salto
+} VmInstr;
+
+typedef union {
+    int i;
+    double f;
+    char *s;
+} VmValue;
+
+typedef struct {
+    Node *fn;
+    int entry;  // Índice da primeira instrução
+    int nregs;  // Registradores usados pelo quadro
+} VmFunc;
+
+typedef struct {
+    const VmInstr *ret_pc; // CALL do chamador (a = registrador de destino)
+    VmValue *base;
+} VmFrame;
+
+// --- Programa Compilado ---
+
+static VmInstr *code = NULL;
+static int codeCount = 0, codeCap = 0;
+static double *float_pool = NULL;
+static int floatCount = 0, floatCap = 0;
+static char **str_pool = NULL;
+static int strCount = 0, strCap = 0;
+static VmFunc funcs[MAX_FN_DEFS + 1]; // + main
+static int globalCount = 0;
+static Node *global_decls[MAX_FN_DEFS];
+
+// --- Estado do Compilador de Bytecode ---
+
+typedef struct {
+    const char *name;
+    const char *ctype;
+    int reg;
+} VmLocal;
+
+static VmLocal locals[VM_MAX_LOCALS];
+static int localCount = 0;
+static int next_reg = 0; // Primeiro registrador livre (acima das locais vivas)
+static int max_reg = 0;
+static Node *cur_fn = NULL;
+static int cur_entry = 0;
+
+static void compile_expr(Node *n, int dest);
+static void compile_statement(Node *n);
+
+// ------------------------------------------
+// --- Emissão ---
+// ------------------------------------------
+
+static int emit(int op, int a, int b, int c) {
+    if (codeCount == codeCap) {
+        codeCap = codeCap ? codeCap * 2 : 1024;
+        code = realloc(code, sizeof(VmInstr) * codeCap);
+        if (!code) { perror("realloc"); exit(1); }
+    }
+    code[codeCount].op = op;
+    code[codeCount].a = a;
+    code[codeCount].b = b;
+    code[codeCount].c = c;
+    return codeCount++;
+}
+
+// Saltos para frente: o destino é preenchido depois (campo b em JMP/JZ/JNZ, c nos JCMP)
+static void patch_jump(int at, int target) {
+    if (code[at].op == OP_JMP || code[at].op == OP_JZ || code[at].op == OP_JNZ) code[at].b = target;
+    else code[at].c = target;
+}
+
+static int float_const(double v) {
+    for (int i = 0; i < floatCount; i++) {
+        if (memcmp(&float_pool[i], &v, sizeof(double)) == 0) return i;
+    }
+    if (floatCount == floatCap) {
+        floatCap = floatCap ? floatCap * 2 : 64;
+        float_pool = realloc(float_pool, sizeof(double) * floatCap);
+        if (!float_pool) { perror("realloc"); exit(1); }
+    }
+    float_pool[floatCount] = v;
+    return floatCount++;
+}
+
+// Literais text passam pelas mesmas sequências de escape que o compilador C interpretaria
+static char *unescape(const char *s) {
+    char *out = malloc(strlen(s) + 1);
+    char *o = out;
+    for (; *s; s++) {
+        if (*s != '\\' || !s[1]) { *o++ = *s; continue; }
+        switch (*++s) {
+            case 'n': *o++ = '\n'; break;
+            case 't': *o++ = '\t'; break;
+            case 'r': *o++ = '\r'; break;
+            case '0': *o++ = '\0'; break;
+            case 'a': *o++ = '\a'; break;
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'v': *o++ = '\v'; break;
+            default: *o++ = *s; break; // \\ \" \' e desconhecidas
+        }
+    }
+    *o = '\0';
+    return out;
+}
+
+static int string_const(const char *text) {
+    char *s = unescape(text);
+    for (int i = 0; i < strCount; i++) {
+        if (strcmp(str_pool[i], s) == 0) { free(s); return i; }
+    }
+    if (strCount == strCap) {
+        strCap = strCap ? strCap * 2 : 64;
+        str_pool = realloc(str_pool, sizeof(char *) * strCap);
+        if (!str_pool) { perror("realloc"); exit(1); }
+    }
+    str_pool[strCount] = s;
+    return strCount++;
+}
+
+static int alloc_reg() {
+    int r = next_reg++;
+    if (next_reg > max_reg) max_reg = next_reg;
+    return r;
+}
+
+// ------------------------------------------
+// --- Tipos e Variáveis ---
+// ------------------------------------------
+
+static const char *ctype_of(Node *n) {
+    return sauce_type_to_c(get_expr_type(n, cur_fn));
+}
+
+static int is_double(const char *ctype) {
+    return strcmp(ctype, "double") == 0;
+}
+
+static int is_ptr(const char *ctype) {
+    return strcmp(ctype, "char*") == 0;
+}
+
+static int find_fn_index(const char *name) {
+    for (int i = 0; i < fnDefCount; i++) {
+        if (strcmp(fn_defs[i]->name, name) == 0) return i;
+    }
+    fprintf(stderr, "Erro Semântico: Função '%s' não definida.\n", name);
+    exit(1);
+}
+
+static VmLocal *find_local(const char *name) {
+    for (int i = localCount - 1; i >= 0; i--) {
+        if (strcmp(locals[i].name, name) == 0) return &locals[i];
+    }
+    return NULL;
+}
+
+static int find_global(const char *name) {
+    for (int i = 0; i < globalCount; i++) {
+        if (strcmp(global_decls[i]->name, name) == 0) return i;
+    }
+    fprintf(stderr, "Erro Semântico: Variável '%s' não declarada.\n", name);
+    exit(1);
+}
+
+static void declare_local(const char *name, const char *ctype, int reg) {
+    if (localCount >= VM_MAX_LOCALS) {
+        fprintf(stderr, "Erro: Variáveis locais demais para o modo run.\n");
+        exit(1);
+    }
+    locals[localCount].name = name;
+    locals[localCount].ctype = ctype;
+    locals[localCount].reg = reg;
+    localCount++;
+}
+
+static void convert(int reg, const char *from, const char *to) {
+    if (strcmp(from, "int") == 0 && is_double(to)) emit(OP_I2F, reg, reg, 0);
+    else if (is_double(from) && strcmp(to, "int") == 0) emit(OP_F2I, reg, reg, 0);
+}
+
+static void compile_expr_as(Node *n, int dest, const char *ctype) {
+    compile_expr(n, dest);
+    convert(dest, ctype_of(n), ctype);
+}
+
+// Registrador com o valor de 'n' no tipo 'ctype': a própria local quando possível
+static int operand_as(Node *n, const char *ctype) {
+    if (n->kind == N_VAR) {
+        VmLocal *l = find_local(n->name);
+        if (l && strcmp(l->ctype, ctype) == 0) return l->reg;
+    }
+    int r = alloc_reg();
+    compile_expr_as(n, r, ctype);
+    return r;
+}
+
+// ------------------------------------------
+// --- Expressões ---
+// ------------------------------------------
+
+static int is_compare(NodeKind k) {
+    return k == N_GT || k == N_LT || k == N_GTE || k == N_LTE || k == N_EQ_CMP || k == N_NEQ;
+}
+
+// Deslocamento dentro de cada família de comparação (LT, LE, GT, GE, EQ, NE)
+static int compare_index(NodeKind k) {
+    switch (k) {
+        case N_LT: return 0;
+        case N_LTE: return 1;
+        case N_GT: return 2;
+        case N_GTE: return 3;
+        case N_EQ_CMP: return 4;
+        default: return 5;
+    }
+}
+
+// Comparação inversa (para saltar quando a condição é falsa)
+static int compare_inverse(int idx) {
+    static const int inverse[6] = { 3, 2, 1, 0, 5, 4 };
+    return inverse[idx];
+}
+
+static void compile_binary(Node *n, int dest) {
+    const char *lt = ctype_of(n->left);
+    const char *rt = ctype_of(n->right);
+    if (is_ptr(ctype_of(n))) { // Valida os tipos (erro em aritmética com text)
+        fprintf(stderr, "Erro: 'run' ainda não suporta concatenação de text ('+'); use o backend C.\n");
+        exit(1);
+    }
+    int mark = next_reg;
+
+    if (is_compare(n->kind) && (is_ptr(lt) || is_ptr(rt))) {
+        int l = operand_as(n->left, "char*"), r = operand_as(n->right, "char*");
+        emit(OP_LTP + compare_index(n->kind), dest, l, r);
+    } else if (is_double(lt) || is_double(rt)) {
+        int l = operand_as(n->left, "double"), r = operand_as(n->right, "double");
+        switch (n->kind) {
+            case N_ADD: emit(OP_ADDF, dest, l, r); break;
+            case N_SUB: emit(OP_SUBF, dest, l, r); break;
+            case N_MUL: emit(OP_MULF, dest, l, r); break;
+            case N_DIV: emit(OP_DIVF, dest, l, r); break;
+            default: emit(OP_LTF + compare_index(n->kind), dest, l, r); break;
+        }
+    } else {
+        int l = operand_as(n->left, "int");
+        // Soma/subtração com literal: imediato na instrução
+        if ((n->kind == N_ADD || n->kind == N_SUB) && n->right->kind == N_INT) {
+            long k = strtol(n->right->text, NULL, 0);
+            if (k > INT_MIN && k <= INT_MAX) {
+                emit(OP_ADDK, dest, l, n->kind == N_ADD ? (int)k : -(int)k);
+                next_reg = mark;
+                return;
+            }
+        }
+        int r = operand_as(n->right, "int");
+        switch (n->kind) {
+            case N_ADD: emit(OP_ADDI, dest, l, r); break;
+            case N_SUB: emit(OP_SUBI, dest, l, r); break;
+            case N_MUL: emit(OP_MULI, dest, l, r); break;
+            case N_DIV: emit(OP_DIVI, dest, l, r); break;
+            default: emit(OP_LTI + compare_index(n->kind), dest, l, r); break;
+        }
+    }
+    next_reg = mark;
+}
+
+// dest = 0 ou 1 conforme a verdade de 'n' (como o '!!' do C)
+static void compile_truth(Node *n, int dest) {
+    const char *t = ctype_of(n);
+    compile_expr(n, dest);
+    if (is_double(t)) emit(OP_TRUTHF, dest, dest, 0);
+    else if (is_ptr(t)) emit(OP_TRUTHP, dest, dest, 0);
+    else emit(OP_TRUTHI, dest, dest, 0);
+}
+
+// Salta quando a condição é falsa; retorna a instrução a ser corrigida
+static int compile_jump_if_false(Node *cond) {
+    int mark = next_reg;
+    int at;
+    if (is_compare(cond->kind) && strcmp(ctype_of(cond->left), "int") == 0 &&
+        strcmp(ctype_of(cond->right), "int") == 0) {
+        int l = operand_as(cond->left, "int"), r = operand_as(cond->right, "int");
+        at = emit(OP_JLTI + compare_inverse(compare_index(cond->kind)), l, r, -1);
+    } else {
+        int t = alloc_reg();
+        compile_truth(cond, t);
+        at = emit(OP_JZ, t, -1, 0);
+    }
+    next_reg = mark;
+    return at;
+}
+
+static void compile_call(Node *n, int dest) {
+    int idx = find_fn_index(n->name);
+    Node *callee = fn_defs[idx];
+    int mark = next_reg;
+    int argbase = next_reg;
+
+    Node *p = callee->left, *a = n->left;
+    for (; p && a; p = p->right, a = a->right) {
+        int r = alloc_reg();
+        compile_expr_as(a->left, r, sauce_type_to_c(p->left->typeName));
+    }
+    if (p || a) {
+        fprintf(stderr, "Erro Semântico: Número de argumentos incorreto na chamada de '%s'.\n", n->name);
+        exit(1);
+    }
+    emit(OP_CALL, dest, idx, argbase);
+    next_reg = mark;
+}
+
+static void compile_expr(Node *n, int dest) {
+    if (!n) return;
+
+    switch (n->kind) {
+        case N_INT:
+            emit(OP_LOADI, dest, (int)strtol(n->text, NULL, 0), 0);
+            break;
+        case N_BOOL:
+            emit(OP_LOADI, dest, strcmp(n->text, "true") == 0, 0);
+            break;
+        case N_FLOAT:
+            emit(OP_LOADF, dest, float_const(strtod(n->text, NULL)), 0);
+            break;
+        case N_STRING:
+            emit(OP_LOADS, dest, string_const(n->text), 0);
+            break;
+        case N_VAR: {
+            VmLocal *l = find_local(n->name);
+            if (l) {
+                if (l->reg != dest) emit(OP_MOV, dest, l->reg, 0);
+            } else {
+                emit(OP_LOADG, dest, find_global(n->name), 0);
+            }
+            break;
+        }
+        case N_FN_CALL:
+            compile_call(n, dest);
+            break;
+        case N_NOT:
+            compile_truth(n->left, dest);
+            emit(OP_NOT, dest, dest, 0);
+            break;
+        case N_AND:
+        case N_OR: {
+            // Curto-circuito: o resultado parcial já é a resposta quando decide
+            compile_truth(n->left, dest);
+            int skip = emit(n->kind == N_AND ? OP_JZ : OP_JNZ, dest, -1, 0);
+            compile_truth(n->right, dest);
+            patch_jump(skip, codeCount);
+            break;
+        }
+        case N_ADD: case N_SUB: case N_MUL: case N_DIV:
+        case N_GT: case N_LT: case N_EQ_CMP: case N_NEQ:
+        case N_GTE: case N_LTE:
+            compile_binary(n, dest);
+            break;
+        default:
+            fprintf(stderr, "Erro Interno: Expressão de nó desconhecida: %d\n", n->kind);
+            exit(1);
+    }
+}
+
+// Expressões que só escrevem o destino na última instrução podem mirar direto numa local
+static int writes_dest_last(Node *n) {
+    return n->kind != N_AND && n->kind != N_OR && n->kind != N_NOT;
+}
+
+// ------------------------------------------
+// --- Comandos ---
+// ------------------------------------------
+
+static void compile_block(Node *list) {
+    int local_mark = localCount, reg_mark = next_reg; // Locais do bloco saem de escopo no fim
+    for (Node *w = list; w; w = w->right) {
+        compile_statement(w->left);
+    }
+    localCount = local_mark;
+    next_reg = reg_mark;
+}
+
+// Atribui o valor do registrador 'src' (já no tipo da variável) a uma local ou global
+static void store_var(const char *name, int src) {
+    VmLocal *l = find_local(name);
+    if (l) {
+        if (l->reg != src) emit(OP_MOV, l->reg, src, 0);
+    } else {
+        emit(OP_STOREG, src, find_global(name), 0);
+    }
+}
+
+// free do valor antigo de uma variável text
+static void free_var(const char *name) {
+    VmLocal *l = find_local(name);
+    if (l) {
+        emit(OP_FREE, l->reg, 0, 0);
+    } else {
+        int t = alloc_reg();
+        emit(OP_LOADG, t, find_global(name), 0);
+        emit(OP_FREE, t, 0, 0);
+        next_reg--;
+    }
+}
+
+static const char *var_ctype(const char *name) {
+    VmLocal *l = find_local(name);
+    return l ? l->ctype : sauce_type_to_c(global_decls[find_global(name)]->typeName);
+}
+
+static void compile_assign(const char *name, Node *expr) {
+    const char *ctype = var_ctype(name);
+    int mark = next_reg;
+    VmLocal *l = find_local(name);
+
+    if (is_ptr(ctype)) {
+        // Cópia nova antes de liberar a antiga (a expressão pode ler a própria variável)
+        int t = alloc_reg();
+        compile_expr(expr, t);
+        emit(OP_STRDUP, t, t, 0);
+        free_var(name);
+        store_var(name, t);
+    } else if (l && writes_dest_last(expr)) {
+        compile_expr_as(expr, l->reg, ctype);
+    } else {
+        int t = alloc_reg();
+        compile_expr_as(expr, t, ctype);
+        store_var(name, t);
+    }
+    next_reg = mark;
+}
+
+static void compile_say(Node *n) {
+    const char *type = get_expr_type(n->left, cur_fn);
+    const char *ctype = sauce_type_to_c(type);
+    int mark = next_reg;
+
+    if (strcmp(type, "boolean") == 0 || strcmp(type, "bool") == 0) {
+        int t = alloc_reg();
+        compile_truth(n->left, t);
+        emit(OP_SAYB, t, 0, 0);
+    } else if (strcmp(ctype, "void") == 0) {
+        emit(OP_SAYERR, 0, 0, 0);
+    } else {
+        int r = operand_as(n->left, ctype);
+        emit(is_double(ctype) ? OP_SAYF : is_ptr(ctype) ? OP_SAYS : OP_SAYI, r, 0, 0);
+    }
+    next_reg = mark;
+}
+
+static void compile_hear(Node *n) {
+    const char *name = n->left->name;
+    const char *ctype = var_ctype(name);
+    int mark = next_reg;
+    int t = alloc_reg();
+
+    if (is_ptr(ctype)) {
+        emit(OP_HEARS, t, 0, 0);
+        free_var(name);
+    } else {
+        emit(is_double(ctype) ? OP_HEARF : OP_HEARI, t, 0, 0);
+    }
+    store_var(name, t);
+    next_reg = mark;
+}
+
+static int is_self_tail_call(Node *ret) {
+    return ret->left && ret->left->kind == N_FN_CALL && strcmp(ret->left->name, cur_fn->name) == 0;
+}
+
+// return f(...) dentro de f: novos argumentos nos parâmetros e salto para a entrada
+static void compile_self_tail_call(Node *call) {
+    int mark = next_reg;
+    int first = next_reg, nargs = 0;
+    Node *p = cur_fn->left, *a = call->left;
+    for (; p && a; p = p->right, a = a->right, nargs++) {
+        int r = alloc_reg();
+        compile_expr_as(a->left, r, sauce_type_to_c(p->left->typeName));
+    }
+    if (p || a) {
+        fprintf(stderr, "Erro Semântico: Número de argumentos incorreto na chamada recursiva de '%s'.\n", cur_fn->name);
+        exit(1);
+    }
+    for (int i = 0; i < nargs; i++) {
+        emit(OP_MOV, i, first + i, 0);
+    }
+    emit(OP_JMP, 0, cur_entry, 0);
+    next_reg = mark;
+}
+
+static void compile_statement(Node *n) {
+    if (!n) return;
+
+    switch (n->kind) {
+        case N_VAR_DECL: {
+            // Locais (as globais são inicializadas por compile_main)
+            const char *ctype = sauce_type_to_c(n->typeName);
+            int reg = alloc_reg();
+            if (n->left) compile_expr_as(n->left, reg, ctype);
+            else emit(OP_ZERO, reg, 0, 0);
+            declare_local(n->name, ctype, reg);
+            break;
+        }
+
+        case N_VAR_ASSIGN:
+            compile_assign(n->name, n->left);
+            break;
+
+        case N_SAY:
+            compile_say(n);
+            break;
+
+        case N_HEAR:
+            compile_hear(n);
+            break;
+
+        case N_IF: {
+            int to_else = compile_jump_if_false(n->left);
+            compile_block(n->right);
+            if (n->mid) {
+                int to_end = emit(OP_JMP, 0, -1, 0);
+                patch_jump(to_else, codeCount);
+                if (n->mid->kind == N_IF) compile_statement(n->mid);
+                else compile_block(n->mid);
+                patch_jump(to_end, codeCount);
+            } else {
+                patch_jump(to_else, codeCount);
+            }
+            break;
+        }
+
+        case N_RETURN: {
+            if (is_self_tail_call(n)) {
+                compile_self_tail_call(n->left);
+                break;
+            }
+            const char *ret_type = sauce_type_to_c(cur_fn->typeName);
+            int mark = next_reg;
+            int t = alloc_reg();
+            if (!n->left) {
+                emit(OP_ZERO, t, 0, 0);
+            } else if (n->explicitReturnType[0] != '\0') {
+                const char *cast = sauce_type_to_c(n->explicitReturnType);
+                compile_expr_as(n->left, t, cast);
+                convert(t, cast, ret_type);
+            } else {
+                compile_expr_as(n->left, t, ret_type);
+            }
+            emit(OP_RET, t, 0, 0);
+            next_reg = mark;
+            break;
+        }
+
+        case N_EXPR_STMT: {
+            int t = alloc_reg();
+            compile_expr(n->left, t);
+            next_reg--;
+            break;
+        }
+
+        case N_IMPORT:
+        case N_BENCH:
+            break;
+
+        default:
+            fprintf(stderr, "Erro Interno: Comando de nó desconhecido para geração: %d\n", n->kind);
+            exit(1);
+    }
+}
+
+// ------------------------------------------
+// --- Funções e Programa ---
+// ------------------------------------------
+
+static void begin_function(Node *fn) {
+    cur_fn = fn;
+    cur_entry = codeCount;
+    localCount = 0;
+    next_reg = 0;
+    max_reg = 0;
+}
+
+static void compile_function(int idx) {
+    Node *fn = fn_defs[idx];
+    begin_function(fn);
+    for (Node *p = fn->left; p; p = p->right) {
+        declare_local(p->left->name, sauce_type_to_c(p->left->typeName), alloc_reg());
+    }
+    compile_block(fn->mid);
+
+    // Retorno de segurança: 0 / 0.0 / NULL
+    int t = alloc_reg();
+    emit(OP_ZERO, t, 0, 0);
+    emit(OP_RET, t, 0, 0);
+
+    funcs[idx].fn = fn;
+    funcs[idx].entry = cur_entry;
+    funcs[idx].nregs = max_reg;
+}
+
+// main: inicializadores globais e comandos de topo na ordem original
+static void compile_main() {
+    // Contexto sintético: locais dos 'if' de topo visíveis para get_expr_type
+    Node *ifs = NULL, *tail = NULL;
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (global_stmts[i]->kind != N_IF) continue;
+        Node *w = make_node(N_STMT_LIST, NULL, NULL, global_stmts[i], NULL, NULL);
+        if (tail) tail->right = w;
+        else ifs = w;
+        tail = w;
+    }
+    Node *ctx = make_node(N_FN_DEF, "_sauce_main", NULL, NULL, ifs, NULL);
+    strcpy(ctx->typeName, "int");
+    begin_function(ctx);
+
+    for (int i = 0; i < globalStmtCount; i++) {
+        Node *stmt = global_stmts[i];
+        if (stmt->kind != N_VAR_DECL) compile_statement(stmt);
+        else if (stmt->left) compile_assign(stmt->name, stmt->left);
+    }
+
+    int t = alloc_reg();
+    for (int i = 0; i < globalCount; i++) {
+        if (is_ptr(sauce_type_to_c(global_decls[i]->typeName))) {
+            emit(OP_LOADG, t, i, 0);
+            emit(OP_FREE, t, 0, 0);
+        }
+    }
+    emit(OP_LOADI, t, 0, 0);
+    emit(OP_RET, t, 0, 0);
+
+    funcs[fnDefCount].fn = ctx;
+    funcs[fnDefCount].entry = cur_entry;
+    funcs[fnDefCount].nregs = max_reg;
+}
+
+// ------------------------------------------
+// --- Runtime de E/S (mesmo comportamento do C gerado) ---
+// ------------------------------------------
+
+static void hear_flush_line() {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+}
+
+static int hear_int() {
+    int v = 0;
+    printf("\n> ");
+    if (scanf("%d", &v) != 1) { /* erro na leitura de int */ }
+    hear_flush_line();
+    return v;
+}
+
+static double hear_float() {
+    double v = 0.0;
+    printf("\n> ");
+    if (scanf("%lf", &v) != 1) { /* erro na leitura de double */ }
+    hear_flush_line();
+    return v;
+}
+
+// Comparação de text pelo conteúdo, como no C gerado (NULL vale como o text vazio;
+// literais iguais já são o mesmo ponteiro do pool)
+static int text_cmp(const char *a, const char *b) {
+    if (a == b) return 0;
+    return strcmp(a ? a : "", b ? b : "");
+}
+
+static char *hear_text() {
+    char buf[VM_HEAR_BUF];
+    int c;
+    printf("\n> ");
+    do { c = getchar(); } while (c != EOF && isspace(c));
+    if (c != EOF) ungetc(c, stdin);
+    if (!fgets(buf, sizeof(buf), stdin)) buf[0] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return strdup(buf);
+}
+
+// ------------------------------------------
+// --- Interpretador ---
+// ------------------------------------------
+
+// Aritmética int com wrap de 32 bits, sem UB no próprio interpretador
+#define WRAP(expr) ((int)(unsigned int)(expr))
+
+#if defined(__GNUC__)
+#define VM_LABEL(n) &&L_##n,
+#define VM_CASE(n) L_##n:
+#define VM_NEXT() do { pc++; goto *labels[pc->op]; } while (0)
+#define VM_JUMP(target) do { pc = code + (target); goto *labels[pc->op]; } while (0)
+#define VM_LOOP_BEGIN goto *labels[pc->op];
+#define VM_LOOP_END
+#else
+// 'continue' precisa valer para o for externo: sem do/while nas macros
+#define VM_CASE(n) case OP_##n:
+#define VM_NEXT() { pc++; continue; }
+#define VM_JUMP(target) { pc = code + (target); continue; }
+#define VM_LOOP_BEGIN for (;;) switch (pc->op) {
+#define VM_LOOP_END }
+#endif
+
+#define R(x) base[pc->x]
+
+static int vm_exec(VmValue *globals) {
+#if defined(__GNUC__)
+    static void *labels[OP_COUNT] = { VM_OPS(VM_LABEL) };
+#endif
+    VmValue *stack = malloc(sizeof(VmValue) * VM_STACK_SLOTS);
+    VmFrame *frames = malloc(sizeof(VmFrame) * VM_MAX_FRAMES);
+    if (!stack || !frames) { perror("malloc"); exit(1); }
+
+    VmValue *stack_end = stack + VM_STACK_SLOTS;
+    VmFrame *frames_end = frames + VM_MAX_FRAMES;
+    VmFrame *fp = frames; // frames[0]: main (sem chamador)
+    VmValue *base = stack;
+    const VmInstr *pc = code + funcs[fnDefCount].entry;
+    int exit_code = 0;
+
+    VM_LOOP_BEGIN
+
+    VM_CASE(MOV) R(a) = R(b); VM_NEXT();
+    VM_CASE(LOADI) R(a).i = pc->b; VM_NEXT();
+    VM_CASE(LOADF) R(a).f = float_pool[pc->b]; VM_NEXT();
+    VM_CASE(LOADS) R(a).s = str_pool[pc->b]; VM_NEXT();
+    VM_CASE(ZERO) memset(&R(a), 0, sizeof(VmValue)); VM_NEXT();
+    VM_CASE(LOADG) R(a) = globals[pc->b]; VM_NEXT();
+    VM_CASE(STOREG) globals[pc->b] = R(a); VM_NEXT();
+
+    VM_CASE(ADDI) R(a).i = WRAP((unsigned)R(b).i + (unsigned)R(c).i); VM_NEXT();
+    VM_CASE(SUBI) R(a).i = WRAP((unsigned)R(b).i - (unsigned)R(c).i); VM_NEXT();
+    VM_CASE(MULI) R(a).i = WRAP((unsigned)R(b).i * (unsigned)R(c).i); VM_NEXT();
+    VM_CASE(DIVI) R(a).i = R(b).i / R(c).i; VM_NEXT(); // Divisão por zero: SIGFPE, como no C
+    VM_CASE(ADDK) R(a).i = WRAP((unsigned)R(b).i + (unsigned)pc->c); VM_NEXT();
+
+    VM_CASE(ADDF) R(a).f = R(b).f + R(c).f; VM_NEXT();
+    VM_CASE(SUBF) R(a).f = R(b).f - R(c).f; VM_NEXT();
+    VM_CASE(MULF) R(a).f = R(b).f * R(c).f; VM_NEXT();
+    VM_CASE(DIVF) R(a).f = R(b).f / R(c).f; VM_NEXT();
+    VM_CASE(I2F) R(a).f = (double)R(b).i; VM_NEXT();
+    VM_CASE(F2I) R(a).i = (int)R(b).f; VM_NEXT();
+
+    VM_CASE(LTI) R(a).i = R(b).i < R(c).i; VM_NEXT();
+    VM_CASE(LEI) R(a).i = R(b).i <= R(c).i; VM_NEXT();
+    VM_CASE(GTI) R(a).i = R(b).i > R(c).i; VM_NEXT();
+    VM_CASE(GEI) R(a).i = R(b).i >= R(c).i; VM_NEXT();
+    VM_CASE(EQI) R(a).i = R(b).i == R(c).i; VM_NEXT();
+    VM_CASE(NEI) R(a).i = R(b).i != R(c).i; VM_NEXT();
+
+    VM_CASE(LTF) R(a).i = R(b).f < R(c).f; VM_NEXT();
+    VM_CASE(LEF) R(a).i = R(b).f <= R(c).f; VM_NEXT();
+    VM_CASE(GTF) R(a).i = R(b).f > R(c).f; VM_NEXT();
+    VM_CASE(GEF) R(a).i = R(b).f >= R(c).f; VM_NEXT();
+    VM_CASE(EQF) R(a).i = R(b).f == R(c).f; VM_NEXT();
+    VM_CASE(NEF) R(a).i = R(b).f != R(c).f; VM_NEXT();
+
+    VM_CASE(LTP) R(a).i = text_cmp(R(b).s, R(c).s) < 0; VM_NEXT();
+    VM_CASE(LEP) R(a).i = text_cmp(R(b).s, R(c).s) <= 0; VM_NEXT();
+    VM_CASE(GTP) R(a).i = text_cmp(R(b).s, R(c).s) > 0; VM_NEXT();
+    VM_CASE(GEP) R(a).i = text_cmp(R(b).s, R(c).s) >= 0; VM_NEXT();
+    VM_CASE(EQP) R(a).i = text_cmp(R(b).s, R(c).s) == 0; VM_NEXT();
+    VM_CASE(NEP) R(a).i = text_cmp(R(b).s, R(c).s) != 0; VM_NEXT();
+
+    VM_CASE(NOT) R(a).i = !R(b).i; VM_NEXT();
+    VM_CASE(TRUTHI) R(a).i = R(b).i != 0; VM_NEXT();
+    VM_CASE(TRUTHF) R(a).i = R(b).f != 0.0; VM_NEXT();
+    VM_CASE(TRUTHP) R(a).i = R(b).s != NULL; VM_NEXT();
+
+    VM_CASE(JMP) VM_JUMP(pc->b);
+    VM_CASE(JZ) if (!R(a).i) VM_JUMP(pc->b); VM_NEXT();
+    VM_CASE(JNZ) if (R(a).i) VM_JUMP(pc->b); VM_NEXT();
+    VM_CASE(JLTI) if (R(a).i < R(b).i) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JLEI) if (R(a).i <= R(b).i) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JGTI) if (R(a).i > R(b).i) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JGEI) if (R(a).i >= R(b).i) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JEQI) if (R(a).i == R(b).i) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JNEI) if (R(a).i != R(b).i) VM_JUMP(pc->c); VM_NEXT();
+
+    VM_CASE(CALL) {
+        const VmFunc *f = &funcs[pc->b];
+        VmValue *callee = base + pc->c;
+        if (fp + 1 >= frames_end || callee + f->nregs > stack_end) {
+            fflush(stdout);
+            fprintf(stderr, "Erro de execução: estouro de pilha em '%s'.\n", f->fn->name);
+            exit_code = 1;
+            goto done;
+        }
+        fp++;
+        fp->ret_pc = pc;
+        fp->base = base;
+        base = callee;
+        VM_JUMP(f->entry);
+    }
+    VM_CASE(RET) {
+        VmValue v = R(a);
+        if (fp == frames) {
+            exit_code = v.i; // return no main: código de saída
+            goto done;
+        }
+        pc = fp->ret_pc;
+        base = fp->base;
+        fp--;
+        R(a) = v;
+        VM_NEXT();
+    }
+
+    VM_CASE(SAYI) printf("%d\n", R(a).i); VM_NEXT();
+    VM_CASE(SAYF) printf("%f\n", R(a).f); VM_NEXT();
+    VM_CASE(SAYS) printf("%s\n", R(a).s); VM_NEXT();
+    VM_CASE(SAYB) printf("%s\n", R(a).i ? "true" : "false"); VM_NEXT();
+    VM_CASE(SAYERR) printf("Erro: Tipo desconhecido (SAID) para saida.\n"); VM_NEXT();
+
+    VM_CASE(HEARI) R(a).i = hear_int(); VM_NEXT();
+    VM_CASE(HEARF) R(a).f = hear_float(); VM_NEXT();
+    VM_CASE(HEARS) R(a).s = hear_text(); VM_NEXT();
+
+    VM_CASE(STRDUP) R(a).s = strdup(R(b).s); VM_NEXT();
+    VM_CASE(FREE) free(R(a).s); VM_NEXT();
+
+    VM_LOOP_END
+
+done:
+    free(stack);
+    free(frames);
+    return exit_code;
+}
+
+// ------------------------------------------
+// --- Ponto de Entrada ---
+// ------------------------------------------
+
+// Compila o programa já parseado para bytecode e executa; retorna o código de saída
+int vm_run_program() {
+    prepare_program(0);
+
+    stats_enter(PHASE_CODEGEN);
+    globalCount = 0;
+    for (int i = 0; i < globalStmtCount; i++) {
+        if (global_stmts[i]->kind == N_VAR_DECL) global_decls[globalCount++] = global_stmts[i];
+    }
+    for (int i = 0; i < fnDefCount; i++) {
+        compile_function(i);
+    }
+    compile_main();
+    stats.c_bytes += (long)(codeCount * sizeof(VmInstr));
+    stats_leave();
+
+    VmValue *globals = calloc(globalCount > 0 ? globalCount : 1, sizeof(VmValue));
+    if (!globals) { perror("calloc"); exit(1); }
+    int rc = vm_exec(globals);
+    fflush(stdout);
+    free(globals);
+    return rc;
+}